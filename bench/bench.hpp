@@ -0,0 +1,116 @@
+#pragma once
+
+#include <json/value.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace wabar::bench {
+
+/* Keep the compiler from optimizing away a computed value */
+template <typename T>
+inline void doNotOptimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * One timed run of a benchmark, repeating the measured operation `iterations` times.
+ */
+class Batch {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  explicit Batch(uint64_t iterations) : iterations_(iterations) {}
+
+  uint64_t iterations() const { return iterations_; }
+
+  /* Time `body`, which runs the operation iterations() times. Setup done before is not counted */
+  template <typename Body>
+  void measure(Body &&body) {
+    auto begin = clock::now();
+    body();
+    elapsed_ = clock::now() - begin;
+  }
+
+  clock::duration elapsed() const { return elapsed_; }
+
+ private:
+  uint64_t iterations_;
+  clock::duration elapsed_{};
+};
+
+/**
+ * Minimal benchmark runner.
+ *
+ * The iteration count of each benchmark is doubled until a batch lasts `min_time`, then `samples`
+ * batches are timed and the per operation time is reported as JSON.
+ */
+class Runner {
+ public:
+  using Benchmark = std::function<void(Batch &)>;
+
+  struct Options {
+    std::string filter;
+    unsigned samples = 10;
+    std::chrono::milliseconds min_time{20};
+  };
+
+  explicit Runner(Options options) : options_(std::move(options)) {}
+
+  void add(std::string name, Benchmark benchmark) {
+    benchmarks_.push_back({std::move(name), std::move(benchmark)});
+  }
+
+  Json::Value run() const {
+    Json::Value results(Json::arrayValue);
+    for (const auto &[name, benchmark] : benchmarks_) {
+      if (name.find(options_.filter) != std::string::npos) {
+        results.append(runOne(name, benchmark));
+      }
+    }
+    return results;
+  }
+
+ private:
+  Json::Value runOne(const std::string &name, const Benchmark &benchmark) const {
+    uint64_t iterations = 1;
+    while (true) {
+      Batch batch(iterations);
+      benchmark(batch);
+      if (batch.elapsed() >= options_.min_time || iterations >= (uint64_t{1} << 40)) {
+        break;
+      }
+      iterations *= 2;
+    }
+
+    std::vector<double> ns_per_op;
+    for (unsigned i = 0; i < options_.samples; ++i) {
+      Batch batch(iterations);
+      benchmark(batch);
+      auto ns = std::chrono::duration<double, std::nano>(batch.elapsed()).count();
+      ns_per_op.push_back(ns / static_cast<double>(iterations));
+    }
+    std::sort(ns_per_op.begin(), ns_per_op.end());
+
+    Json::Value result;
+    result["name"] = name;
+    result["iterations"] = static_cast<Json::UInt64>(iterations);
+    result["samples"] = options_.samples;
+    result["min_ns"] = ns_per_op.front();
+    result["median_ns"] = ns_per_op[ns_per_op.size() / 2];
+    result["mean_ns"] = std::accumulate(ns_per_op.begin(), ns_per_op.end(), 0.0) /
+                        static_cast<double>(ns_per_op.size());
+    result["max_ns"] = ns_per_op.back();
+    return result;
+  }
+
+  Options options_;
+  std::vector<std::pair<std::string, Benchmark>> benchmarks_;
+};
+
+}  // namespace wabar::bench
@@ -0,0 +1,299 @@
+#include <fmt/format.h>
+#include <gtkmm/main.h>
+#include <json/writer.h>
+#include <spdlog/spdlog.h>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "modules/sway/tree.hpp"
+#include "util/clara.hpp"
+#include "util/command.hpp"
+#include "util/format.hpp"
+#include "util/json.hpp"
+#include "util/regex_collection.hpp"
+#include "util/rewrite_string.hpp"
+#include "util/sanitize_str.hpp"
+
+#ifdef __linux__
+#include "modules/cpu_usage.hpp"
+#include "modules/memory.hpp"
+#endif
+#if defined(HAVE_CHRONO_TIMEZONES) || defined(HAVE_LIBDATE)
+#include "modules/clock.hpp"
+#endif
+
+namespace {
+
+using wabar::bench::Batch;
+using wabar::bench::doNotOptimize;
+using wabar::bench::Runner;
+
+std::string readFile(const std::string &path) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    throw std::runtime_error("Can't open " + path);
+  }
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+// Typical window titles, as fed to the window and taskbar modules
+const std::vector<std::string> TITLES = {
+    "Wayland debugging — Mozilla Firefox",
+    "nvim ~/src/wabar/src/bar.cpp",
+    "Inbox (3) - <user@example.com> - Thunderbird",
+    "bar.cpp - wabar - Code - OSS",
+    "Slack | #general | \"Team\" & friends",
+    "talk.webm - mpv",
+};
+
+Json::Value rewriteRules() {
+  Json::Value rules;
+  rules["(.*) — Mozilla Firefox"] = "🌎 $1";
+  rules["(.*) - Thunderbird"] = "📧 $1";
+  rules["nvim (.*)"] = " $1";
+  rules["(.*) - Code - OSS"] = "󰨞 $1";
+  rules["(.*) - mpv"] = "🎞 $1";
+  return rules;
+}
+
+// The recorded sway tree with its outputs repeated up to `size`, as with many windows open
+std::string growTree(const std::string &tree, size_t size) {
+  auto root = wabar::util::JsonParser().parse(tree);
+  const auto outputs = root["nodes"];
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  auto payload = Json::writeString(builder, root);
+  while (payload.size() < size) {
+    for (const auto &output : outputs) {
+      root["nodes"].append(output);
+    }
+    payload = Json::writeString(builder, root);
+  }
+  return payload;
+}
+
+void addJsonBenchmarks(Runner &runner, const std::string &data_dir) {
+  auto sway_tree = readFile(data_dir + "/sway_get_tree.json");
+  for (const auto &[name, payload] :
+       {std::pair{"json/sway_get_tree", sway_tree},
+        std::pair{"json/sway_get_tree_1mb", growTree(sway_tree, 1024 * 1024)},
+        std::pair{"json/hyprland_clients", readFile(data_dir + "/hyprland_clients.json")}}) {
+    runner.add(name, [payload](Batch &batch) {
+      wabar::util::JsonParser parser;
+      batch.measure([&] {
+        for (uint64_t i = 0; i < batch.iterations(); ++i) {
+          doNotOptimize(parser.parse(payload));
+        }
+      });
+    });
+  }
+}
+
+void addSwayTreeBenchmarks(Runner &runner, const std::string &data_dir) {
+  auto sway_tree = readFile(data_dir + "/sway_get_tree.json");
+  for (const auto &[name, payload] :
+       {std::pair{"sway/tree_decode", sway_tree},
+        std::pair{"sway/tree_decode_1mb", growTree(sway_tree, 1024 * 1024)}}) {
+    runner.add(name, [payload](Batch &batch) {
+      batch.measure([&] {
+        for (uint64_t i = 0; i < batch.iterations(); ++i) {
+          doNotOptimize(wabar::modules::sway::Tree(payload).size());
+        }
+      });
+    });
+  }
+}
+
+void addStringBenchmarks(Runner &runner) {
+  runner.add("format/pow_format", [](Batch &batch) {
+    batch.measure([&] {
+      for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        doNotOptimize(fmt::format("{:>}", pow_format(static_cast<long long>(i) * 7919, "B/s")));
+      }
+    });
+  });
+  runner.add("format/pow_format_binary", [](Batch &batch) {
+    batch.measure([&] {
+      for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        doNotOptimize(
+            fmt::format("{:=}", pow_format(static_cast<long long>(i) * 104729, "B", true)));
+      }
+    });
+  });
+  runner.add("string/sanitize_string", [](Batch &batch) {
+    batch.measure([&] {
+      for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        doNotOptimize(wabar::util::sanitize_string(TITLES[i % TITLES.size()]));
+      }
+    });
+  });
+  runner.add("string/rewrite_string", [rules = rewriteRules()](Batch &batch) {
+    batch.measure([&] {
+      for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        doNotOptimize(wabar::util::rewriteString(TITLES[i % TITLES.size()], rules));
+      }
+    });
+  });
+  runner.add("regex_collection/get_hit", [rules = rewriteRules()](Batch &batch) {
+    wabar::util::RegexCollection collection(rules, "default");
+    auto titles = TITLES;
+    for (auto &title : titles) {
+      collection.get(title);
+    }
+    batch.measure([&] {
+      for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        doNotOptimize(collection.get(titles[i % titles.size()]));
+      }
+    });
+  });
+  runner.add("regex_collection/get_miss", [rules = rewriteRules()](Batch &batch) {
+    wabar::util::RegexCollection collection(rules, "default");
+    // Unique values, every lookup has to run the regexes
+    std::vector<std::string> titles;
+    titles.reserve(batch.iterations());
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+      titles.push_back(fmt::format("{} {}", TITLES[i % TITLES.size()], i));
+    }
+    batch.measure([&] {
+      for (auto &title : titles) {
+        doNotOptimize(collection.get(title));
+      }
+    });
+  });
+}
+
+void addCommandBenchmarks(Runner &runner) {
+  // Spawning cost grows with the size of the parent, which is large with the tray and taskbar
+  for (const auto &[name, resident] : {std::pair{"command/exec", size_t{0}},
+                                       std::pair{"command/exec_large_rss", size_t{256} << 20}}) {
+    runner.add(name, [resident](Batch &batch) {
+      std::vector<char> ballast(resident, 1);
+      doNotOptimize(ballast.data());
+      batch.measure([&] {
+        for (uint64_t i = 0; i < batch.iterations(); ++i) {
+          doNotOptimize(wabar::util::command::exec("true", "bench"));
+        }
+      });
+    });
+  }
+}
+
+#ifdef __linux__
+void addProcBenchmarks(Runner &runner, const std::string &data_dir) {
+  runner.add("proc/parse_cpuinfo", [stat = readFile(data_dir + "/proc_stat")](Batch &batch) {
+    batch.measure([&] {
+      for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        std::istringstream stream(stat);
+        doNotOptimize(wabar::modules::CpuUsage::parseCpuinfo(stream));
+      }
+    });
+  });
+  runner.add("proc/parse_meminfo", [meminfo = readFile(data_dir + "/proc_meminfo")](Batch &batch) {
+    batch.measure([&] {
+      for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        std::istringstream stream(meminfo);
+        doNotOptimize(wabar::modules::Memory::parseMeminfo(stream));
+      }
+    });
+  });
+}
+#endif
+
+#if defined(HAVE_CHRONO_TIMEZONES) || defined(HAVE_LIBDATE)
+Json::Value clockConfig() {
+  Json::Value config;
+  config["locale"] = "C";
+  config["tooltip-format"] = "<tt><small>{calendar}</small></tt>";
+  auto &calendar = config["calendar"];
+  calendar["mode-mon-col"] = 3;
+  calendar["weeks-pos"] = "right";
+  calendar["format"]["months"] = "<span color='#ffead3'><b>{}</b></span>";
+  calendar["format"]["days"] = "<span color='#ecc6d9'><b>{}</b></span>";
+  calendar["format"]["weeks"] = "<span color='#99ffdd'><b>W{}</b></span>";
+  calendar["format"]["weekdays"] = "<span color='#ffcc66'><b>{}</b></span>";
+  calendar["format"]["today"] = "<span color='#ff6699'><b><u>{}</u></b></span>";
+  return config;
+}
+
+void addClockBenchmarks(Runner &runner, const Json::Value &config) {
+  for (const auto &[name, year] : {std::pair{"clock/calendar_month", false},
+                                   std::pair{"clock/calendar_year", true}}) {
+    runner.add(name, [&config, year](Batch &batch) {
+      wabar::modules::Clock clock("bench", config);
+      if (year) {
+        clock.doAction("mode");
+      }
+      batch.measure([&] {
+        for (uint64_t i = 0; i < batch.iterations(); ++i) {
+          // Move to another month or year, so the calendar cache never hits
+          clock.doAction(i % 2 == 0 ? "shift_up" : "shift_down");
+          doNotOptimize(clock.getTooltip());
+        }
+      });
+    });
+  }
+}
+#endif
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  bool show_help = false;
+  std::string data_dir = BENCH_DATA_DIR;
+  Runner::Options options;
+  auto min_time_ms = static_cast<unsigned>(options.min_time.count());
+  auto cli = clara::detail::Help(show_help) |
+             clara::detail::Opt(options.filter, "substring")["-f"]["--filter"](
+                 "Only run the benchmarks whose name contains substring") |
+             clara::detail::Opt(options.samples, "count")["-n"]["--samples"](
+                 "Timed batches per benchmark") |
+             clara::detail::Opt(min_time_ms, "ms")["-t"]["--min-time"]("Minimum batch length") |
+             clara::detail::Opt(data_dir, "dir")["-d"]["--data"]("Recorded payloads directory");
+  auto res = cli.parse(clara::detail::Args(argc, argv));
+  if (!res) {
+    spdlog::error("Error in command line: {}", res.errorMessage());
+    return 1;
+  }
+  if (show_help) {
+    std::cout << cli << std::endl;
+    return 0;
+  }
+  options.samples = std::max(options.samples, 1U);
+  options.min_time = std::chrono::milliseconds(min_time_ms);
+  // Results go to stdout, keep it clean
+  spdlog::set_level(spdlog::level::warn);
+
+  Runner runner(options);
+  addJsonBenchmarks(runner, data_dir);
+  addSwayTreeBenchmarks(runner, data_dir);
+  addStringBenchmarks(runner);
+  addCommandBenchmarks(runner);
+#ifdef __linux__
+  addProcBenchmarks(runner, data_dir);
+#endif
+#if defined(HAVE_CHRONO_TIMEZONES) || defined(HAVE_LIBDATE)
+  // Modules are GTK widgets
+  const auto clock_config = clockConfig();
+  if (gtk_init_check(&argc, &argv)) {
+    Gtk::Main::init_gtkmm_internals();
+    addClockBenchmarks(runner, clock_config);
+  } else {
+    spdlog::warn("No display available, skipping the clock benchmarks");
+  }
+#endif
+
+  Json::Value output;
+  output["version"] = VERSION;
+  output["benchmarks"] = runner.run();
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "  ";
+  std::cout << Json::writeString(builder, output) << std::endl;
+  return 0;
+}
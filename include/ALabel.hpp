@@ -1,10 +1,15 @@
 #pragma once
 
 #include <glibmm/markup.h>
-#include <gtkmm/label.h>
 #include <json/json.h>
 
+#include <chrono>
+#include <functional>
+#include <optional>
+
 #include "AModule.hpp"
+#include "util/cached_widget.hpp"
+#include "util/state_cache.hpp"
 
 namespace wabar {
 
@@ -13,20 +18,80 @@ class ALabel : public AModule {
   ALabel(const Json::Value &, const std::string &, const std::string &, const std::string &format,
          uint16_t interval = 0, bool ellipsize = false, bool enable_click = false,
          bool enable_scroll = false);
-  virtual ~ALabel() = default;
+  virtual ~ALabel();
   auto update() -> void override;
   virtual std::string getIcon(uint16_t, const std::string &alt = "", uint16_t max = 0);
   virtual std::string getIcon(uint16_t, const std::vector<std::string> &alts, uint16_t max = 0);
 
+  /**
+   * Show `state`, saved by a previous run, until the module shows something of its own or
+   * STALE_TIMEOUT passed. The label has the "stale" class meanwhile.
+   */
+  void restoreState(const util::ModuleState &state);
+  bool stale() const { return restored_.has_value(); }
+  // What to save for the next run, nothing for a hidden module
+  std::optional<util::ModuleState> saveState();
+  // update(), keeping the restored state up while the module has nothing to show
+  void updateOverRestored();
+
+  static constexpr const char *STALE_CLASS = "stale";
+  static constexpr auto STALE_TIMEOUT = std::chrono::seconds(10);
+
  protected:
-  Gtk::Label label_;
+  util::CachedLabel label_;
   std::string format_;
   const std::chrono::seconds interval_;
   bool alt_ = false;
   std::string default_format_;
+  // Placeholders of the configured formats and the default one. Modules add the tooltip formats
+  // they fall back on, before deciding what to sample.
+  util::FormatFields fields_;
+
+  // Whether a format or tooltip format may show the `field` placeholder
+  bool shows(std::string_view field) const { return fields_.contains(field); }
 
   bool handleToggle(GdkEventButton *const &e) override;
   virtual std::string getState(uint8_t value, bool lesser = false);
+
+  // The icons getIcon picks from for `alts`, to look up once for several icons
+  const util::ConfigView::IconTable *iconTable(const std::vector<std::string> &alts) const {
+    return config_view_.icons(alts);
+  }
+  // The icon of `icons` for `percentage` out of `max` (100 by default), empty if there are none
+  static const std::string &iconAt(const util::ConfigView::IconTable *icons, uint16_t percentage,
+                                   uint16_t max = 0);
+
+  /**
+   * Build the tooltip only when GTK is about to show it, instead of on every update.
+   * The callback returns the tooltip text (markup if `markup` is set), empty for no tooltip.
+   * A null callback removes the tooltip.
+   */
+  using TooltipCallback = std::function<std::string()>;
+  void setTooltipCallback(TooltipCallback callback, bool markup = false);
+
+ private:
+  bool handleQueryTooltip(int x, int y, bool keyboard_tooltip,
+                          const Glib::RefPtr<Gtk::Tooltip> &tooltip);
+
+  TooltipCallback tooltip_callback_;
+  sigc::connection tooltip_connection_;
+  bool tooltip_markup_ = false;
+  bool hovered_ = false;
+
+  // State class currently set on the label
+  std::string state_class_;
+
+  void applyRestored();
+  void removeRestored();
+  bool showsContent();
+
+  std::optional<util::ModuleState> restored_;
+  std::chrono::steady_clock::time_point stale_until_;
+  // Classes of restored_ the label didn't have already
+  std::vector<std::string> restored_classes_;
+  // Whether the module had its event box hidden before the restored state showed it
+  bool restored_shown_box_ = false;
+  sigc::connection stale_timeout_;
 };
 
 }  // namespace wabar
@@ -1,11 +1,14 @@
 #pragma once
 
-#include <glibmm/dispatcher.h>
 #include <glibmm/markup.h>
-#include <gtkmm/eventbox.h>
 #include <json/json.h>
 
 #include "IModule.hpp"
+#include "util/cached_widget.hpp"
+#include "util/child_supervisor.hpp"
+#include "util/config_view.hpp"
+#include "util/metrics.hpp"
+#include "util/update_queue.hpp"
 
 namespace wabar {
 
@@ -19,8 +22,8 @@ class AModule : public IModule {
   operator Gtk::Widget &() override;
   auto doAction(const std::string &name) -> void override;
 
-  /// Emitting on this dispatcher triggers a update() call
-  Glib::Dispatcher dp;
+  /// Emitting on this dispatcher schedules an update() call on the next frame
+  util::UpdateDispatcher dp;
 
  protected:
   // Don't need to make an object directly
@@ -35,7 +38,9 @@ class AModule : public IModule {
 
   const std::string name_;
   const Json::Value &config_;
-  Gtk::EventBox event_box_;
+  // The generic keys of config_, for updates to use instead
+  const util::ConfigView config_view_;
+  util::CachedEventBox event_box_;
 
   virtual bool handleToggle(GdkEventButton *const &ev);
   virtual bool handleScroll(GdkEventScroll *);
@@ -43,11 +48,14 @@ class AModule : public IModule {
 
  private:
   bool handleUserEvent(GdkEventButton *const &ev);
+  // Run a user command in the background, terminated with the module if still running
+  void forkExec(const std::string &cmd);
   const bool isTooltip;
-  std::vector<int> pid_;
+  std::vector<std::shared_ptr<const util::Child>> children_;
+  // Processes spawned from event handlers are counted for the module
+  const std::shared_ptr<util::ModuleMetrics> metrics_ = util::Metrics::current();
   gdouble distance_scrolled_y_;
   gdouble distance_scrolled_x_;
-  std::map<std::string, std::string> eventActionMap_;
   static const inline std::map<std::pair<uint, GdkEventType>, std::string> eventMap_{
       {std::make_pair(1, GdkEventType::GDK_BUTTON_PRESS), "on-click"},
       {std::make_pair(1, GdkEventType::GDK_BUTTON_RELEASE), "on-click-release"},
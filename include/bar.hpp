@@ -61,13 +61,21 @@ class Bar {
   static const std::string MODE_INVISIBLE;
 
   Bar(struct wabar_output *w_output, const Json::Value &);
+  /* Bar without a surface or modules of its own, hosting modules for the headless runner */
+  struct Headless {};
+  Bar(struct wabar_output *w_output, const Json::Value &, Headless);
   Bar(const Bar &) = delete;
   ~Bar();
 
   void setMode(const std::string &mode);
   void setVisible(bool visible);
+  /* Apply a new config in place, keeping the modules whose config didn't change.
+   * Returns false if bar level settings changed and the bar has to be recreated. */
+  bool reload(const Json::Value &new_config);
   void toggle();
   void handleSignal(int);
+  // Hand what the modules show to the StateCache
+  void saveState();
 
   struct wabar_output *output;
   Json::Value config;
@@ -87,9 +95,22 @@ class Bar {
  private:
   void onMap(GdkEventAny *);
   auto setupWidgets() -> void;
+  struct ModuleEntry {
+    std::string ref;
+    std::shared_ptr<wabar::AModule> module;
+    // Modules created for a group, owned by the group entry
+    std::vector<std::shared_ptr<wabar::AModule>> children;
+  };
+
   void getModules(const Factory &, const std::string &, wabar::Group *);
-  void setupAltFormatKeyForModule(const std::string &module_name);
-  void setupAltFormatKeyForModuleList(const char *module_list_name);
+  bool restoresState() const;
+  void addModule(const Factory &, const Json::Value &name, const std::string &pos,
+                 wabar::Group *group);
+  std::vector<ModuleEntry> &getModuleEntries(const std::string &pos);
+  Gtk::Box &getModuleBox(const std::string &pos);
+  void packModules();
+  static void setupAltFormatKeyForModule(Json::Value &config, const std::string &module_name);
+  static void setupAltFormatKeyForModuleList(Json::Value &config, const char *module_list_name);
   void setMode(const bar_mode &);
   void setPassThrough(bool passthrough);
   void setPosition(Gtk::PositionType position);
@@ -109,9 +130,9 @@ class Bar {
   Gtk::Box center_;
   Gtk::Box right_;
   Gtk::Box box_;
-  std::vector<std::shared_ptr<wabar::AModule>> modules_left_;
-  std::vector<std::shared_ptr<wabar::AModule>> modules_center_;
-  std::vector<std::shared_ptr<wabar::AModule>> modules_right_;
+  std::vector<ModuleEntry> modules_left_;
+  std::vector<ModuleEntry> modules_center_;
+  std::vector<ModuleEntry> modules_right_;
 #ifdef HAVE_SWAY
   using BarIpcClient = modules::sway::BarIpcClient;
   std::unique_ptr<BarIpcClient> _ipc_client;
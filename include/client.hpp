@@ -3,10 +3,12 @@
 #include <fmt/format.h>
 #include <gdk/gdk.h>
 #include <gdk/gdkwayland.h>
+#include <glibmm/dispatcher.h>
 #include <wayland-client.h>
 
 #include "bar.hpp"
 #include "config.hpp"
+#include "headless.hpp"
 #include "util/css_reload_helper.hpp"
 #include "util/portal.hpp"
 
@@ -20,6 +22,8 @@ class Client {
   static Client *inst();
   int main(int argc, char *argv[]);
   void reset();
+  // Async signal safe, reloads the config on the main loop
+  void requestReload();
 
   Glib::RefPtr<Gtk::Application> gtk_app;
   Glib::RefPtr<Gdk::Display> gdk_display;
@@ -35,6 +39,11 @@ class Client {
   Client() = default;
   const std::string getStyle(const std::string &style, std::optional<Appearance> appearance);
   void bindInterfaces();
+  int runHeadless(int argc, char *argv[], const std::string &config_opt,
+                  HeadlessHost::Options options);
+  void applyGlobalSettings();
+  void saveState();
+  void reload();
   void handleOutput(struct wabar_output &output);
   auto setupCss(const std::string &css_file) -> void;
   struct wabar_output &getOutput(void *);
@@ -55,6 +64,7 @@ class Client {
   std::unique_ptr<Portal> portal;
   std::list<struct wabar_output> outputs_;
   std::unique_ptr<CssReloadHelper> m_cssReloadHelper;
+  std::unique_ptr<Glib::Dispatcher> reload_dp_;
   std::string m_cssFile;
 };
 
@@ -26,6 +26,8 @@ class Config {
 
   Json::Value &getConfig() { return config_; }
 
+  const std::string &getConfigFile() const { return config_file_; }
+
   std::vector<Json::Value> getOutputConfigs(const std::string &name, const std::string &identifier);
 
  private:
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <gtkmm/box.h>
+#include <gtkmm/offscreenwindow.h>
+#include <json/json.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bar.hpp"
+
+namespace wabar {
+
+/**
+ * Runs modules without a compositor, for benchmarks and CI.
+ *
+ * Modules are created through the Factory for a bar that is never mapped and packed into an
+ * offscreen window. Each tick updates every module, lays out and draws its widget into an image
+ * surface, and prints the time spent and the resulting labels as JSON lines.
+ */
+class HeadlessHost {
+ public:
+  struct Options {
+    std::vector<std::string> modules;
+    unsigned ticks = 10;
+    // Time left between ticks for the modules to sample new data
+    std::chrono::milliseconds interval{0};
+  };
+
+  // `config` is the bar config the module configs are looked up in
+  HeadlessHost(const Json::Value &config, Options options);
+  HeadlessHost(const HeadlessHost &) = delete;
+  ~HeadlessHost();
+
+  // Returns the process exit code
+  int run();
+
+ private:
+  struct Hosted {
+    std::string name;
+    std::shared_ptr<AModule> module;
+    bool emitted = false;
+  };
+
+  void waitForData(std::chrono::milliseconds timeout);
+  // Run the main loop for `duration`, so the modules can sample in the background
+  static void iterate(std::chrono::milliseconds duration);
+
+  Options options_;
+  struct wabar_output output_;
+  std::unique_ptr<Bar> bar_;
+  Gtk::OffscreenWindow window_;
+  Gtk::Box box_;
+  std::vector<Hosted> modules_;
+};
+
+}  // namespace wabar
@@ -26,6 +26,9 @@ class Backlight : public ALabel {
   const std::string preferred_device_;
 
   std::string previous_format_;
+  // The brightness and label of the last update, for the tooltip
+  uint8_t percent_ = 0;
+  std::string desc_;
 
   util::BacklightBackend backend;
 };
@@ -14,6 +14,7 @@
 
 #include "ALabel.hpp"
 #include "bar.hpp"
+#include "util/scheduler.hpp"
 #include "util/sleeper_thread.hpp"
 
 namespace wabar::modules {
@@ -43,12 +44,20 @@ class Battery : public ALabel {
   int global_watch_fd_;
   std::mutex battery_list_mutex_;
   std::string old_status_;
+  // What the last update showed, for the tooltip
+  struct {
+    std::string format;
+    std::string time_to;
+    float power = 0;
+    uint8_t capacity = 0;
+    std::string time;
+  } tooltip_;
   bool warnFirstTime_{true};
   const Bar& bar_;
 
   util::SleeperThread thread_;
   util::SleeperThread thread_battery_update_;
-  util::SleeperThread thread_timer_;
+  util::Timer timer_;
 };
 
 }  // namespace wabar::modules
@@ -62,6 +62,7 @@ class Bluetooth : public ALabel {
   // Returns std::nullopt if no controller could be found
   auto findCurController() -> std::optional<ControllerInfo>;
   auto findConnectedDevices(const std::string&, std::vector<DeviceInfo>&) -> void;
+  std::string tooltipText();
 
 #ifdef WANT_RFKILL
   util::Rfkill rfkill_;
@@ -72,7 +73,9 @@ class Bluetooth : public ALabel {
   std::optional<ControllerInfo> cur_controller_;
   std::vector<DeviceInfo> connected_devices_;
   DeviceInfo cur_focussed_device_;
-  std::string device_enumerate_;
+  // The tooltip format and icon picked by the last update
+  std::string tooltip_format_;
+  std::string tooltip_icon_;
 
   std::vector<std::string> device_preference_;
 };
@@ -2,7 +2,7 @@
 
 #include "ALabel.hpp"
 #include "util/date.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/scheduler.hpp"
 
 namespace wabar::modules {
 
@@ -19,12 +19,12 @@ class Clock final : public ALabel {
   virtual ~Clock() = default;
   auto update() -> void override;
   auto doAction(const std::string&) -> void override;
+  auto getTooltip() -> std::string;  // tooltip text to print, built on demand
 
  private:
   const std::locale locale_;
   // tooltip
   const std::string tlpFmt_;
-  std::string tlpText_{""};  // tooltip text to print
   // Calendar
   const bool cldInTooltip_;  // calendar in tooltip
   /*
@@ -57,7 +57,7 @@ class Clock final : public ALabel {
   std::vector<const time_zone*> tzList_;  // time zones list
   int tzCurrIdx_;                         // current time zone index for tzList_
   std::string tzText_{""};                // time zones text to print
-  util::SleeperThread thread_;
+  util::Timer timer_;
 
   // ordinal date in tooltip
   const bool ordInTooltip_;
@@ -10,7 +10,7 @@
 #include <vector>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/data_source.hpp"
 
 namespace wabar::modules {
 
@@ -21,9 +21,15 @@ class Cpu : public ALabel {
   auto update() -> void override;
 
  private:
-  std::vector<std::tuple<size_t, size_t>> prev_times_;
-
-  util::SleeperThread thread_;
+  struct Sample {
+    double load1 = 0;
+    std::vector<uint16_t> usage;
+    float max_frequency = 0;
+    float min_frequency = 0;
+    float avg_frequency = 0;
+  };
+
+  util::DataSource<Sample>::Handle source_;
 };
 
 }  // namespace wabar::modules
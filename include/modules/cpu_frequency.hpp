@@ -10,7 +10,7 @@
 #include <vector>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/data_source.hpp"
 
 namespace wabar::modules {
 
@@ -26,7 +26,7 @@ class CpuFrequency : public ALabel {
  private:
   static std::vector<float> parseCpuFrequencies();
 
-  util::SleeperThread thread_;
+  util::DataSource<std::tuple<float, float, float>>::Handle source_;
 };
 
 }  // namespace wabar::modules
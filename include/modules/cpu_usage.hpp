@@ -1,6 +1,9 @@
 #pragma once
 
 #include <fmt/format.h>
+#if (FMT_VERSION >= 80000)
+#include <fmt/args.h>
+#endif
 
 #include <cstdint>
 #include <fstream>
@@ -10,7 +13,7 @@
 #include <vector>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/data_source.hpp"
 
 namespace wabar::modules {
 
@@ -20,16 +23,23 @@ class CpuUsage : public ALabel {
   virtual ~CpuUsage() = default;
   auto update() -> void override;
 
-  // This is a static member because it is also used by the cpu module.
-  static std::tuple<std::vector<uint16_t>, std::string> getCpuUsage(
-      std::vector<std::tuple<size_t, size_t>>&);
-
- private:
+  // These are static members because they are also used by the cpu module.
+  static std::vector<uint16_t> getCpuUsage(std::vector<std::tuple<size_t, size_t>>&);
+  static std::string getTooltip(const std::vector<uint16_t>& usage);
+  // Push {usageN} and {iconN} for each core, `usage` starts with the total
+  static void pushCoreArgs(fmt::dynamic_format_arg_store<fmt::format_context>& store,
+                           const std::vector<uint16_t>& usage,
+                           const util::ConfigView::IconTable* icons);
+  // Idle and total time of the whole system, then of each cpu
   static std::vector<std::tuple<size_t, size_t>> parseCpuinfo();
+#ifdef __linux__
+  // Same, out of the content of /proc/stat
+  static std::vector<std::tuple<size_t, size_t>> parseCpuinfo(std::istream& stat);
+#endif
 
-  std::vector<std::tuple<size_t, size_t>> prev_times_;
+ private:
 
-  util::SleeperThread thread_;
+  util::DataSource<std::vector<uint16_t>>::Handle source_;
 };
 
 }  // namespace wabar::modules
@@ -2,13 +2,21 @@
 
 #include <fmt/format.h>
 
+#include <atomic>
 #include <csignal>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 
 #include "ALabel.hpp"
 #include "util/command.hpp"
+#include "util/data_source.hpp"
+#include "util/exec_cache.hpp"
+#include "util/file_watcher.hpp"
 #include "util/json.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/push_server.hpp"
+#include "util/reactor.hpp"
 
 namespace wabar::modules {
 
@@ -20,29 +28,67 @@ class Custom : public ALabel {
   void refresh(int /*signal*/) override;
 
  private:
+  // A run of the continuous script, shared with the callbacks of its end
+  struct Exec {
+    std::mutex mutex;
+    // Null once the module is destroyed
+    Custom* module = nullptr;
+    bool eof = false;
+    // Wait status, once reaped
+    std::optional<int> status;
+  };
+
+  FILE* openExec();
+  void execDone(const Exec& exec);
   void delayWorker();
   void continuousWorker();
   void waitingWorker();
+  void fileWorker();
+  void sharedWorker(std::chrono::seconds interval);
   void parseOutputRaw();
   void parseOutputJson();
+  void applyClasses();
   void handleEvent();
+  void wakeUp();
+  void post(util::command::res output, bool pushed);
   bool handleScroll(GdkEventScroll* e) override;
   bool handleToggle(GdkEventButton* const& e) override;
 
   const std::string name_;
   const std::string output_name_;
+  // Resolved from the config once, update() reads no JSON
+  // An empty or failed output of "exec", "exec-if" or "watch-file" hides the module
+  const bool hides_on_failure_;
+  const bool json_output_;
+  const bool escape_;
+  const std::optional<std::string> tooltip_format_;
   std::string text_;
   std::string id_;
   std::string alt_;
   std::string tooltip_;
   std::vector<std::string> class_;
+  // The classes of class_ on the label
+  std::vector<std::string> applied_classes_;
   int percentage_;
   FILE* fp_;
   int pid_;
   util::command::res output_;
   util::JsonParser parser_;
 
-  util::SleeperThread thread_;
+  std::atomic<bool> restarting_ = false;
+  // output_ comes from the push socket, main thread only
+  bool pushed_ = false;
+  // Output of the script, a file or a push, set off the main thread for the next update()
+  std::mutex pending_mutex_;
+  std::optional<util::command::res> pending_;
+  bool pending_pushed_ = false;
+  // The shared source ran the command since the last update()
+  bool sampled_ = false;
+  std::shared_ptr<Exec> exec_;
+  util::ReactorHandle reader_;
+  util::PushServer::Subscription push_;
+  std::unique_ptr<util::FileWatcher> watcher_;
+  util::DataSource<util::command::res>::Handle source_;
 };
 
 }  // namespace wabar::modules
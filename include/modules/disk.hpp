@@ -4,10 +4,11 @@
 #include <sys/statvfs.h>
 
 #include <fstream>
+#include <optional>
 
 #include "ALabel.hpp"
 #include "util/format.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/data_source.hpp"
 
 namespace wabar::modules {
 
@@ -18,10 +19,13 @@ class Disk : public ALabel {
   auto update() -> void override;
 
  private:
-  util::SleeperThread thread_;
   std::string path_;
   std::string unit_;
+  util::DataSource<std::optional<struct statvfs>>::Handle source_;
+  // Sample of the last update, for the tooltip
+  std::optional<struct statvfs> stats_;
 
+  std::string formatStats(const std::string& format, const struct statvfs& stats);
   float calc_specific_divisor(const std::string divisor);
 };
 
@@ -7,7 +7,7 @@
 #include <fstream>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/scheduler.hpp"
 
 namespace wabar::modules {
 
@@ -24,6 +24,8 @@ class JACK : public ALabel {
 
  private:
   std::string JACKState();
+  // Format with the values of the last update
+  std::string formatShown(const std::string &format) const;
 
   jack_client_t *client_;
   jack_nframes_t bufsize_;
@@ -33,7 +35,14 @@ class JACK : public ALabel {
   bool running_;
   std::mutex mutex_;
   std::string state_;
-  util::SleeperThread thread_;
+  util::Timer timer_;
+  struct {
+    float load;
+    jack_nframes_t bufsize;
+    jack_nframes_t samplerate;
+    float latency;
+    unsigned int xruns;
+  } shown_{};
 };
 
 }  // namespace wabar::modules
@@ -10,7 +10,7 @@
 #include <vector>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/data_source.hpp"
 
 namespace wabar::modules {
 
@@ -24,7 +24,7 @@ class Load : public ALabel {
   static std::tuple<double, double, double> getLoad();
 
  private:
-  util::SleeperThread thread_;
+  util::DataSource<std::tuple<double, double, double>>::Handle source_;
 };
 
 }  // namespace wabar::modules
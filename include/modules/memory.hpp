@@ -6,7 +6,7 @@
 #include <unordered_map>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/data_source.hpp"
 
 namespace wabar::modules {
 
@@ -16,12 +16,31 @@ class Memory : public ALabel {
   virtual ~Memory() = default;
   auto update() -> void override;
 
- private:
-  void parseMeminfo();
-
-  std::unordered_map<std::string, unsigned long> meminfo_;
+  using Meminfo = std::unordered_map<std::string, unsigned long>;
+  static Meminfo parseMeminfo();
+#ifdef __linux__
+  // Fields of /proc/meminfo, in kB
+  static Meminfo parseMeminfo(std::istream& meminfo);
+#endif
 
-  util::SleeperThread thread_;
+ private:
+  std::string tooltipText() const;
+
+  Meminfo meminfo_;
+  // Values of the last update, for the tooltip
+  struct Usage {
+    bool valid = false;
+    float total_ram_gigabytes = 0;
+    float total_swap_gigabytes = 0;
+    int used_ram_percentage = 0;
+    int used_swap_percentage = 0;
+    float used_ram_gigabytes = 0;
+    float used_swap_gigabytes = 0;
+    float available_ram_gigabytes = 0;
+    float available_swap_gigabytes = 0;
+  } usage_;
+
+  util::DataSource<Meminfo>::Handle source_;
 };
 
 }  // namespace wabar::modules
@@ -9,8 +9,10 @@
 #include <sys/epoll.h>
 
 #include <optional>
+#include <unordered_map>
 
 #include "ALabel.hpp"
+#include "util/data_source.hpp"
 #include "util/sleeper_thread.hpp"
 #ifdef WANT_RFKILL
 #include "util/rfkill.hpp"
@@ -47,6 +49,12 @@ class Network : public ALabel {
   void clearIface();
   bool wildcardMatch(const std::string& pattern, const std::string& text) const;
   std::optional<std::pair<unsigned long long, unsigned long long>> readBandwidthUsage();
+  // Format with the values of the last update
+  std::string formatShown(const std::string& format) const;
+
+  // Received and transmitted bytes of every interface, shared by all network modules
+  using NetDev = std::unordered_map<std::string, std::pair<unsigned long long, unsigned long long>>;
+  static std::optional<NetDev> readNetDev();
 
   int ifid_;
   sa_family_t family_;
@@ -81,11 +89,32 @@ class Network : public ALabel {
   uint32_t route_priority;
 
   util::SleeperThread thread_;
-  util::SleeperThread thread_timer_;
+  util::Timer timer_;
+  util::DataSource<std::optional<NetDev>>::Handle netdev_;
 #ifdef WANT_RFKILL
   util::Rfkill rfkill_;
 #endif
   float frequency_;
+
+  // What the last update showed, the tooltip formats it without taking mutex_
+  struct Shown {
+    std::string essid;
+    int32_t signal_strength_dbm = 0;
+    uint8_t signal_strength = 0;
+    std::string signal_strength_app;
+    std::string ifname;
+    std::string netmask;
+    std::string ipaddr;
+    std::string gwaddr;
+    int cidr = 0;
+    float frequency = 0;
+    std::string icon;
+    unsigned long long bandwidth_down = 0;
+    unsigned long long bandwidth_up = 0;
+    std::string tooltip_format;
+    // The label, also the tooltip without a tooltip format
+    std::string text;
+  } shown_;
 };
 
 }  // namespace wabar::modules
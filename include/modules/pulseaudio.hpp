@@ -22,6 +22,15 @@ class Pulseaudio : public ALabel {
   const std::vector<std::string> getPulseIcon() const;
 
   std::shared_ptr<util::AudioBackend> backend = nullptr;
+  // What the last update showed, for the tooltip
+  struct {
+    uint16_t sink_volume = 0;
+    uint16_t source_volume = 0;
+    std::string sink_desc;
+    std::string source_desc;
+    std::string format_source;
+    std::string icon;
+  } tooltip_;
 };
 
 }  // namespace wabar::modules
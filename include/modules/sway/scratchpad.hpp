@@ -9,7 +9,7 @@
 #include "bar.hpp"
 #include "client.hpp"
 #include "modules/sway/ipc/client.hpp"
-#include "util/json.hpp"
+#include "modules/sway/tree.hpp"
 
 namespace wabar::modules::sway {
 class Scratchpad : public ALabel {
@@ -30,6 +30,5 @@ class Scratchpad : public ALabel {
   int count_;
   std::mutex mutex_;
   Ipc ipc_;
-  util::JsonParser parser_;
 };
 }  // namespace wabar::modules::sway
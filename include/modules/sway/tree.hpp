@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace wabar::modules::sway {
+
+/**
+ * A container of a GET_TREE reply, with only the fields the modules use.
+ *
+ * Strings point into the Tree they belong to. A string missing from the reply, or null in it (e.g.
+ * the name of a split container or the app_id of an X11 window), has a null data().
+ */
+struct Node {
+  struct Rect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+  };
+
+  int64_t id = 0;
+  std::string_view type;
+  std::string_view name;
+  std::string_view app_id;
+  std::string_view shell;
+  std::string_view layout;
+  std::string_view output;
+  // Set on outputs
+  std::string_view current_workspace;
+  // "window_properties" of X11 windows
+  std::string_view window_class;
+  std::string_view window_instance;
+  int num = -1;
+  bool focused = false;
+  bool visible = false;
+  bool urgent = false;
+  Rect rect;
+
+  // Range of Tree::children_, the tiled children come first
+  uint32_t children = 0;
+  uint32_t nodes_count = 0;
+  uint32_t floating_nodes_count = 0;
+};
+
+/**
+ * A GET_TREE reply decoded into a flat array of nodes.
+ *
+ * The reply is scanned once and every field but those of Node is skipped, so no Json::Value is
+ * built. Children are indices into the array, and strings are copied unescaped into a single
+ * buffer sized after the reply, which is never reallocated.
+ */
+class Tree {
+ public:
+  // Throws std::runtime_error if `payload` isn't a valid tree
+  explicit Tree(std::string_view payload);
+  Tree(const Tree &) = delete;
+  Tree &operator=(const Tree &) = delete;
+
+  /**
+   * Decode `payload`, or return the tree decoded last if it was the same reply.
+   *
+   * Each module gets its own reply to GET_TREE, the same one when they asked for the same event,
+   * so the modules of every bar share one tree.
+   */
+  static std::shared_ptr<const Tree> decode(const std::string &payload);
+
+  const Node &root() const { return nodes_.front(); }
+  size_t size() const { return nodes_.size(); }
+
+  class Children {
+   public:
+    class Iterator {
+     public:
+      Iterator(const Tree *tree, const uint32_t *index) : tree_(tree), index_(index) {}
+      const Node &operator*() const { return tree_->nodes_[*index_]; }
+      Iterator &operator++() {
+        ++index_;
+        return *this;
+      }
+      bool operator==(const Iterator &other) const { return index_ == other.index_; }
+
+     private:
+      const Tree *tree_;
+      const uint32_t *index_;
+    };
+
+    Children(const Tree *tree, std::span<const uint32_t> indices)
+        : tree_(tree), indices_(indices) {}
+    Iterator begin() const { return {tree_, indices_.data()}; }
+    Iterator end() const { return {tree_, indices_.data() + indices_.size()}; }
+    size_t size() const { return indices_.size(); }
+    bool empty() const { return indices_.empty(); }
+    const Node &operator[](size_t i) const { return tree_->nodes_[indices_[i]]; }
+
+   private:
+    const Tree *tree_;
+    std::span<const uint32_t> indices_;
+  };
+
+  Children nodes(const Node &node) const {
+    return {this, {children_.data() + node.children, node.nodes_count}};
+  }
+  Children floatingNodes(const Node &node) const {
+    return {this,
+            {children_.data() + node.children + node.nodes_count, node.floating_nodes_count}};
+  }
+  // Both, tiled first
+  Children allNodes(const Node &node) const {
+    return {this,
+            {children_.data() + node.children, node.nodes_count + node.floating_nodes_count}};
+  }
+
+  // Whether `flag` is set on `node` or any container below it
+  bool hasFlag(const Node &node, bool Node::*flag) const;
+
+  // Containers are nested no deeper than this
+  static constexpr int MAX_DEPTH = 256;
+
+ private:
+  friend class TreeDecoder;
+
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> children_;
+  std::string strings_;
+};
+
+}  // namespace wabar::modules::sway
@@ -8,7 +8,7 @@
 #include "bar.hpp"
 #include "client.hpp"
 #include "modules/sway/ipc/client.hpp"
-#include "util/json.hpp"
+#include "modules/sway/tree.hpp"
 
 namespace wabar::modules::sway {
 
@@ -23,7 +23,7 @@ class Window : public AAppIconLabel, public sigc::trackable {
   void onEvent(const struct Ipc::ipc_response&);
   void onCmd(const struct Ipc::ipc_response&);
   std::tuple<std::size_t, int, int, std::string, std::string, std::string, std::string, std::string>
-  getFocusedNode(const Json::Value& nodes, std::string& output);
+  getFocusedNode(const Tree& tree, std::string& output);
   void getTree();
 
   const Bar& bar_;
@@ -36,7 +36,6 @@ class Window : public AAppIconLabel, public sigc::trackable {
   std::size_t app_nb_;
   std::string shell_;
   int floating_count_;
-  util::JsonParser parser_;
   std::mutex mutex_;
   Ipc ipc_;
 };
@@ -4,6 +4,9 @@
 #include <gtkmm/button.h>
 #include <gtkmm/label.h>
 
+#include <map>
+#include <memory>
+#include <optional>
 #include <string_view>
 #include <unordered_map>
 
@@ -11,7 +14,7 @@
 #include "bar.hpp"
 #include "client.hpp"
 #include "modules/sway/ipc/client.hpp"
-#include "util/json.hpp"
+#include "modules/sway/tree.hpp"
 #include "util/regex_collection.hpp"
 
 namespace wabar::modules::sway {
@@ -27,31 +30,53 @@ class Workspaces : public AModule, public sigc::trackable {
   static constexpr std::string_view persistent_workspace_switch_cmd_ =
       R"(workspace {} "{}"; move workspace to output "{}"; workspace {} "{}")";
 
+  // A workspace of tree_, or a persistent one sway doesn't have yet
+  struct Workspace {
+    std::string name;
+    int num = -1;
+    int sort = 0;
+    // Set on persistent workspaces, empty for all outputs
+    std::optional<std::string> target_output;
+    const Node* node = nullptr;
+  };
+
   static int convertWorkspaceNameToNum(std::string name);
   static int windowRewritePriorityFunction(std::string const& window_rule);
 
   void onCmd(const struct Ipc::ipc_response&);
   void onEvent(const struct Ipc::ipc_response&);
   bool filterButtons();
-  static bool hasFlag(const Json::Value&, const std::string&);
-  void updateWindows(const Json::Value&, std::string&);
-  Gtk::Button& addButton(const Json::Value&);
-  void onButtonReady(const Json::Value&, Gtk::Button&);
-  std::string getIcon(const std::string&, const Json::Value&);
-  const std::string getCycleWorkspace(std::vector<Json::Value>::iterator, bool prev) const;
+  bool hasFlag(const Workspace&, bool Node::*flag) const;
+  bool isEmpty(const Workspace&) const;
+  // The output of a workspace sway has, with a null data() for persistent ones
+  static std::string_view outputOf(const Workspace&);
+  void updateWindows(const Node&, std::string&);
+  Gtk::Button& addButton(const Workspace&);
+  void onButtonReady(const Workspace&, Gtk::Button&);
+  std::string getIcon(const std::string&, const Workspace&);
+  // The "format-icons" string of `key`, null if it has none
+  const std::string* icon(std::string_view key) const;
+  const std::string getCycleWorkspace(std::vector<Workspace>::iterator, bool prev) const;
   uint16_t getWorkspaceIndex(const std::string& name) const;
   std::string trimWorkspaceName(std::string);
   bool handleScroll(GdkEventScroll*) override;
 
   const Bar& bar_;
-  std::vector<Json::Value> workspaces_;
+  // Resolved from the config once, update() reads no JSON
+  const bool all_outputs_;
+  const bool disable_markup_;
+  // "window-format" is set
+  const bool show_windows_;
+  std::optional<std::string> format_;
+  std::map<std::string, std::string, std::less<>> icons_;
+  std::shared_ptr<const Tree> tree_;
+  std::vector<Workspace> workspaces_;
   std::vector<std::string> high_priority_named_;
   std::vector<std::string> workspaces_order_;
   Gtk::Box box_;
   std::string m_formatWindowSeperator;
   std::string m_windowRewriteDefault;
   util::RegexCollection m_windowRewriteRules;
-  util::JsonParser parser_;
   std::unordered_map<std::string, Gtk::Button> buttons_;
   std::mutex mutex_;
   Ipc ipc_;
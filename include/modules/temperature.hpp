@@ -3,9 +3,10 @@
 #include <fmt/format.h>
 
 #include <fstream>
+#include <optional>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/scheduler.hpp"
 
 namespace wabar::modules {
 
@@ -19,8 +20,13 @@ class Temperature : public ALabel {
   float getTemperature();
   bool isCritical(uint16_t);
 
+  // The temperature of the last update, for the tooltip
+  struct Reading {
+    uint16_t celsius, fahrenheit, kelvin;
+  };
+  std::optional<Reading> temperature_;
   std::string file_path_;
-  util::SleeperThread thread_;
+  util::Timer timer_;
 };
 
 }  // namespace wabar::modules
@@ -41,6 +41,8 @@ class Wireplumber : public ALabel {
   uint32_t pending_plugins_;
   bool muted_;
   double volume_;
+  // The volume the last update showed, for the tooltip
+  int shown_volume_ = 0;
   double min_step_;
   uint32_t node_id_{0};
   std::string node_name_;
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <glibmm/markup.h>
+#include <gtkmm/eventbox.h>
+#include <gtkmm/label.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+namespace wabar::util {
+
+/**
+ * Counters of the widget mutations requested by modules, either applied to GTK or skipped
+ * because the widget already had the requested state.
+ */
+struct RenderStats {
+  static inline std::atomic<uint64_t> applied{0};
+  static inline std::atomic<uint64_t> skipped{0};
+
+  // Count the mutation, returns whether it has to be applied
+  static bool count(bool changed) {
+    (changed ? applied : skipped).fetch_add(1, std::memory_order_relaxed);
+    return changed;
+  }
+};
+
+/**
+ * GTK widget which only forwards the setters modules call on every update when the value changes.
+ *
+ * The setters hide the non-virtual Gtk::Widget ones, and compare against the state stored by GTK
+ * rather than a private copy, so changes made through the base class are never missed.
+ */
+template <typename Widget>
+class CachedWidget : public Widget {
+ public:
+  using Widget::Widget;
+
+  void show() {
+    if (RenderStats::count(!this->get_visible())) {
+      Widget::show();
+    }
+  }
+
+  void hide() {
+    if (RenderStats::count(this->get_visible())) {
+      Widget::hide();
+    }
+  }
+
+  void set_tooltip_text(const Glib::ustring &text) {
+    if (RenderStats::count(tooltipChanged(Glib::Markup::escape_text(text)))) {
+      Widget::set_tooltip_text(text);
+    }
+  }
+
+  void set_tooltip_markup(const Glib::ustring &markup) {
+    if (RenderStats::count(tooltipChanged(markup))) {
+      Widget::set_tooltip_markup(markup);
+    }
+  }
+
+ private:
+  bool tooltipChanged(const Glib::ustring &markup) {
+    if (this->get_has_tooltip() == markup.empty()) {
+      return true;
+    }
+    // GTK stores plain text tooltips as escaped markup too
+    gchar *current = gtk_widget_get_tooltip_markup(this->Gtk::Widget::gobj());
+    bool changed = current == nullptr ? !markup.empty() : markup.raw() != current;
+    g_free(current);
+    return changed;
+  }
+};
+
+using CachedEventBox = CachedWidget<Gtk::EventBox>;
+
+class CachedLabel : public CachedWidget<Gtk::Label> {
+ public:
+  using CachedWidget<Gtk::Label>::CachedWidget;
+
+  void set_markup(const Glib::ustring &markup) {
+    if (RenderStats::count(labelChanged(markup, true))) {
+      Gtk::Label::set_markup(markup);
+    }
+  }
+
+  void set_text(const Glib::ustring &text) {
+    if (RenderStats::count(labelChanged(text, false))) {
+      Gtk::Label::set_text(text);
+    }
+  }
+
+ private:
+  bool labelChanged(const Glib::ustring &label, bool use_markup) {
+    return get_use_markup() != use_markup ||
+           std::strcmp(gtk_label_get_label(gobj()), label.c_str()) != 0;
+  }
+};
+
+}  // namespace wabar::util
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <signal.h>
+#include <sys/types.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "util/metrics.hpp"
+
+namespace wabar::util {
+
+/**
+ * A background child process, as seen by the ChildSupervisor.
+ */
+class Child {
+ public:
+  explicit Child(pid_t pid) : pid_(pid) {}
+
+  pid_t pid() const { return pid_; }
+  bool exited() const { return exited_.load(std::memory_order_acquire); }
+  // Wait status as returned by waitpid, once exited()
+  int status() const { return status_; }
+
+ private:
+  friend class ChildSupervisor;
+
+  const pid_t pid_;
+  int pidfd_ = -1;
+  int status_ = 0;
+  std::atomic<bool> exited_ = false;
+  std::function<void(int)> on_exit_;
+  std::shared_ptr<ModuleMetrics> owner_ = Metrics::current();
+};
+
+/**
+ * Reaps the processes started in the background (e.g. on-click commands) and reports their exit.
+ *
+ * Where pidfd_open is available, each child gets a pidfd watched by the Reactor, so an exit is
+ * handled on its own without scanning the other children. Elsewhere, children are polled with
+ * waitpid(WNOHANG) when the signal thread receives SIGCHLD. Children still running are counted
+ * against the module that started them.
+ */
+class ChildSupervisor {
+ public:
+  using ExitHandler = std::function<void(int status)>;
+
+  static ChildSupervisor &inst();
+
+  ChildSupervisor() = default;
+  ChildSupervisor(const ChildSupervisor &) = delete;
+
+  // Reap `pid` once it exits, then call `on_exit` with its wait status from the reactor thread,
+  // or from the signal thread without pidfds
+  std::shared_ptr<const Child> watch(pid_t pid, ExitHandler on_exit = {});
+  // Poll the children watched without a pidfd, called on SIGCHLD
+  void reapPolled();
+
+  // A module with more children running than this is warned about
+  static constexpr int64_t RUNAWAY_CHILDREN = 16;
+
+ private:
+  void exited(const std::shared_ptr<Child> &child, int status);
+  // Stop counting the child against its module, without reporting an exit
+  void forget(const std::shared_ptr<Child> &child);
+  // The waitpid status of a child reaped by waitid
+  static int waitStatus(const siginfo_t &info);
+
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<Child>> polled_;
+  std::atomic<bool> pidfd_supported_ = true;
+};
+
+}  // namespace wabar::util
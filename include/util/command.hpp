@@ -1,6 +1,8 @@
 #pragma once
 
 #include <fcntl.h>
+#include <poll.h>
+#include <fmt/ranges.h>
 #include <giomm.h>
 #include <spdlog/spdlog.h>
 #include <sys/wait.h>
@@ -13,10 +15,19 @@
 #include <sys/procctl.h>
 #endif
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <vector>
 
-extern std::mutex reap_mtx;
-extern std::list<pid_t> reap;
+#include "util/child_supervisor.hpp"
+#include "util/metrics.hpp"
+
+extern char** environ;
 
 namespace wabar::util::command {
 
@@ -25,14 +36,76 @@ struct res {
   std::string out;
 };
 
-inline std::string read(FILE* fp) {
-  std::array<char, 128> buffer = {0};
+/**
+ * Bounds on the output of a command read by exec().
+ */
+struct Limits {
+  // Output past this is dropped, the command keeps running until it exits
+  static constexpr size_t MAX_OUTPUT = 1024 * 1024;
+
+  size_t max_output = MAX_OUTPUT;
+  // The process group of the command is killed once it runs longer, zero for no limit
+  std::chrono::milliseconds timeout = std::chrono::milliseconds::zero();
+};
+
+/**
+ * Read the output of the command `pid` until it closes it, without the last newline.
+ *
+ * Reads straight into the result, grown geometrically up to `limits.max_output`. Output past the
+ * limit is still drained so that the command doesn't block, but dropped along with the partial
+ * line before it, so that each line left is whole (e.g. for "return-type": "json").
+ */
+inline std::string read(FILE* fp, pid_t pid, const Limits& limits = {}) {
+  static constexpr size_t CHUNK = 4096;
+  using clock = std::chrono::steady_clock;
+  auto fd = fileno(fp);
+  auto deadline = clock::now() + limits.timeout;
   std::string output;
-  while (feof(fp) == 0) {
-    if (fgets(buffer.data(), 128, fp) != nullptr) {
-      output += buffer.data();
+  size_t size = 0;
+  bool truncated = false;
+  std::array<char, CHUNK> discard;
+  while (true) {
+    if (limits.timeout > std::chrono::milliseconds::zero()) {
+      auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - clock::now());
+      pollfd pfd = {fd, POLLIN, 0};
+      int ready = left.count() > 0 ? poll(&pfd, 1, static_cast<int>(left.count())) : 0;
+      if (ready == -1 && errno == EINTR) {
+        continue;
+      }
+      if (ready == 0) {
+        spdlog::warn("Command still running after {}ms, killing it", limits.timeout.count());
+        killpg(pid, SIGKILL);
+        break;
+      }
+    }
+    ssize_t len;
+    if (size < limits.max_output) {
+      if (output.size() == size) {
+        output.resize(std::min(std::max(size * 2, CHUNK), limits.max_output));
+      }
+      len = ::read(fd, output.data() + size, output.size() - size);
+    } else {
+      len = ::read(fd, discard.data(), discard.size());
+      if (len > 0 && !truncated) {
+        spdlog::warn("Command output longer than {} bytes, dropping the rest", limits.max_output);
+        truncated = true;
+      }
+    }
+    if (len < 0 && errno == EINTR) {
+      continue;
+    }
+    if (len <= 0) {
+      break;
+    }
+    if (size < limits.max_output) {
+      size += len;
     }
   }
+  output.resize(size);
+  if (truncated) {
+    auto newline = output.rfind('\n');
+    output.resize(newline == std::string::npos ? 0 : newline);
+  }
 
   // Remove last newline
   if (!output.empty() && output[output.length() - 1] == '\n') {
@@ -66,8 +139,156 @@ inline int close(FILE* fp, pid_t pid) {
   return stat;
 }
 
-inline FILE* open(const std::string& cmd, int& pid, const std::string& output_name) {
-  if (cmd == "") return nullptr;
+/**
+ * Words of `cmd` if it is a plain list of words, which can be executed without a shell.
+ *
+ * Anything the shell would expand, quote, redirect or combine makes it return nothing, as does a
+ * leading variable assignment.
+ */
+inline std::optional<std::vector<std::string>> splitWords(const std::string& cmd) {
+  static constexpr std::string_view SPECIAL = "|&;<>()$`\\\"'*?[]#~{}!\n";
+  static constexpr std::string_view BLANK = " \t";
+  if (cmd.find_first_of(SPECIAL) != std::string::npos) {
+    return std::nullopt;
+  }
+  std::vector<std::string> words;
+  for (auto begin = cmd.find_first_not_of(BLANK); begin != std::string::npos;
+       begin = cmd.find_first_not_of(BLANK, begin)) {
+    auto end = std::min(cmd.find_first_of(BLANK, begin), cmd.size());
+    words.emplace_back(cmd, begin, end - begin);
+    begin = end;
+  }
+  if (words.empty() || words.front().find('=') != std::string::npos) {
+    return std::nullopt;
+  }
+  return words;
+}
+
+/* Path of the executable `program` is run from, like execvp would find it, or empty */
+inline std::string findProgram(const std::string& program) {
+  if (program.find('/') != std::string::npos) {
+    return access(program.c_str(), X_OK) == 0 ? program : "";
+  }
+  const char* path = getenv("PATH");
+  std::string_view dirs = path != nullptr ? path : "/usr/local/bin:/usr/bin:/bin";
+  while (true) {
+    auto sep = dirs.find(':');
+    auto dir = dirs.substr(0, sep);
+    auto candidate = std::string(dir.empty() ? "." : dir) + '/' + program;
+    if (access(candidate.c_str(), X_OK) == 0) {
+      return candidate;
+    }
+    if (sep == std::string_view::npos) {
+      return "";
+    }
+    dirs.remove_prefix(sep + 1);
+  }
+}
+
+/**
+ * Execute `args` in a new process group, returns the pid or -1 with errno set.
+ *
+ * Uses vfork rather than fork: the bar can have a few hundred MB mapped, and copying its page
+ * tables on every spawn dominated the cost of short lived commands. The child shares our memory
+ * until it execs, so it only makes system calls and everything it needs is prepared beforehand.
+ * `stdout_fd` replaces the standard output of the command when not -1, `output_name` is exported
+ * as WAYBAR_OUTPUT_NAME when not empty and `die_with_parent` sends SIGTERM to the command when
+ * the spawning thread exits. Like execvp, a script without a shebang is run with /bin/sh.
+ */
+inline pid_t spawn(const std::vector<std::string>& args, int stdout_fd,
+                   const std::string& output_name, bool die_with_parent) {
+  auto program = findProgram(args.front());
+  if (program.empty()) {
+    errno = ENOENT;
+    return -1;
+  }
+  static constexpr std::string_view OUTPUT_VAR = "WAYBAR_OUTPUT_NAME=";
+  std::string output_var;
+  std::vector<char*> envp;
+  for (char** var = environ; *var != nullptr; ++var) {
+    if (output_name.empty() || strncmp(*var, OUTPUT_VAR.data(), OUTPUT_VAR.size()) != 0) {
+      envp.push_back(*var);
+    }
+  }
+  if (!output_name.empty()) {
+    output_var = std::string(OUTPUT_VAR) + output_name;
+    envp.push_back(output_var.data());
+  }
+  envp.push_back(nullptr);
+  std::vector<char*> argv;
+  argv.reserve(args.size() + 1);
+  for (const auto& arg : args) {
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+  // For ENOEXEC, prepared here as the child can't allocate
+  std::vector<char*> shell_argv = {const_cast<char*>("/bin/sh"), program.data()};
+  shell_argv.insert(shell_argv.end(), argv.begin() + 1, argv.end());
+
+  // Signal handlers must not run in the child, it would be on our stack
+  sigset_t all;
+  sigset_t saved;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &saved);
+
+  pid_t pid = vfork();
+  if (pid == 0) {
+    // Restore the default action of the handled signals before unblocking them, like fork + exec
+    struct sigaction action {};
+    for (int sig = 1; sig < NSIG; ++sig) {
+      if (sigaction(sig, nullptr, &action) == 0 && action.sa_handler != SIG_IGN &&
+          action.sa_handler != SIG_DFL) {
+        action.sa_handler = SIG_DFL;
+        action.sa_flags = 0;
+        sigaction(sig, &action, nullptr);
+      }
+    }
+    if (die_with_parent) {
+      int deathsig = SIGTERM;
+#ifdef __linux__
+      prctl(PR_SET_PDEATHSIG, deathsig);
+#endif
+#ifdef __FreeBSD__
+      procctl(P_PID, 0, PROC_PDEATHSIG_CTL, reinterpret_cast<void*>(&deathsig));
+#endif
+    }
+    setpgid(0, 0);
+    if (stdout_fd != -1) {
+      dup2(stdout_fd, STDOUT_FILENO);
+    }
+    sigset_t none;
+    sigemptyset(&none);
+    sigprocmask(SIG_SETMASK, &none, nullptr);
+    execve(program.c_str(), argv.data(), envp.data());
+    if (errno == ENOEXEC) {
+      execve(shell_argv[0], shell_argv.data(), envp.data());
+    }
+    _exit(127);
+  }
+
+  int err = errno;
+  pthread_sigmask(SIG_SETMASK, &saved, nullptr);
+  errno = err;
+  return pid;
+}
+
+/* Run `cmd` directly if it is a plain list of words naming a program, else with /bin/sh */
+inline pid_t spawn(const std::string& cmd, int stdout_fd, const std::string& output_name,
+                   bool die_with_parent) {
+  if (auto words = splitWords(cmd)) {
+    auto pid = spawn(*words, stdout_fd, output_name, die_with_parent);
+    if (pid >= 0 || errno != ENOENT) {
+      return pid;
+    }
+    // Not a program, could be a shell builtin
+  }
+  return spawn({"/bin/sh", "-c", cmd}, stdout_fd, output_name, die_with_parent);
+}
+
+// `Command` is a command line or the arguments of a program, see spawn()
+template <typename Command>
+inline FILE* openCommand(const Command& cmd, int& pid, const std::string& output_name) {
+  if (cmd.empty()) return nullptr;
   int fd[2];
   // Open the pipe with the close-on-exec flag set, so it will not be inherited
   // by any other subprocesses launched by other threads (which could result in
@@ -78,58 +299,53 @@ inline FILE* open(const std::string& cmd, int& pid, const std::string& output_na
     return nullptr;
   }
 
-  pid_t child_pid = fork();
-
+  pid_t child_pid = spawn(cmd, fd[1], output_name, true);
   if (child_pid < 0) {
-    spdlog::error("Unable to exec cmd {}, error {}", cmd.c_str(), strerror(errno));
+    spdlog::error("Unable to exec cmd {}, error {}", cmd, strerror(errno));
     ::close(fd[0]);
     ::close(fd[1]);
     return nullptr;
   }
+  ::close(fd[1]);
 
-  if (!child_pid) {
-    int err;
-    sigset_t mask;
-    sigfillset(&mask);
-    // Reset sigmask
-    err = pthread_sigmask(SIG_UNBLOCK, &mask, nullptr);
-    if (err != 0) spdlog::error("pthread_sigmask in open failed: {}", strerror(err));
-    // Kill child if Wabar exits
-    int deathsig = SIGTERM;
-#ifdef __linux__
-    if (prctl(PR_SET_PDEATHSIG, deathsig) != 0) {
-      spdlog::error("prctl(PR_SET_PDEATHSIG) in open failed: {}", strerror(errno));
-    }
-#endif
-#ifdef __FreeBSD__
-    if (procctl(P_PID, 0, PROC_PDEATHSIG_CTL, reinterpret_cast<void*>(&deathsig)) == -1) {
-      spdlog::error("procctl(PROC_PDEATHSIG_CTL) in open failed: {}", strerror(errno));
-    }
-#endif
-    ::close(fd[0]);
-    dup2(fd[1], 1);
-    setpgid(child_pid, child_pid);
-    if (output_name != "") {
-      setenv("WAYBAR_OUTPUT_NAME", output_name.c_str(), 1);
-    }
-    execlp("/bin/sh", "sh", "-c", cmd.c_str(), (char*)0);
-    exit(0);
-  } else {
-    ::close(fd[1]);
-  }
+  Metrics::processSpawned();
   pid = child_pid;
   return fdopen(fd[0], "r");
 }
 
-inline struct res exec(const std::string& cmd, const std::string& output_name) {
+inline FILE* open(const std::string& cmd, int& pid, const std::string& output_name) {
+  return openCommand(cmd, pid, output_name);
+}
+
+inline FILE* open(const std::vector<std::string>& args, int& pid, const std::string& output_name) {
+  return openCommand(args, pid, output_name);
+}
+
+template <typename Command>
+inline struct res execCommand(const Command& cmd, const std::string& output_name,
+                              const Limits& limits) {
   int pid;
   auto fp = command::open(cmd, pid, output_name);
   if (!fp) return {-1, ""};
-  auto output = command::read(fp);
+  auto output = command::read(fp, pid, limits);
   auto stat = command::close(fp, pid);
+  // Like the shell does, so that a killed command doesn't look successful
+  if (WIFSIGNALED(stat)) {
+    return {128 + WTERMSIG(stat), output};
+  }
   return {WEXITSTATUS(stat), output};
 }
 
+inline struct res exec(const std::string& cmd, const std::string& output_name,
+                       const Limits& limits = {}) {
+  return execCommand(cmd, output_name, limits);
+}
+
+inline struct res exec(const std::vector<std::string>& args, const std::string& output_name,
+                       const Limits& limits = {}) {
+  return execCommand(args, output_name, limits);
+}
+
 inline struct res execNoRead(const std::string& cmd) {
   int pid;
   auto fp = command::open(cmd, pid, "");
@@ -138,35 +354,20 @@ inline struct res execNoRead(const std::string& cmd) {
   return {WEXITSTATUS(stat), ""};
 }
 
-inline int32_t forkExec(const std::string& cmd) {
-  if (cmd == "") return -1;
+/* Run `cmd` in the background, its exit is handled by the ChildSupervisor */
+inline std::shared_ptr<const Child> forkExec(const std::string& cmd,
+                                             ChildSupervisor::ExitHandler on_exit = {}) {
+  if (cmd == "") return nullptr;
 
-  pid_t pid = fork();
+  pid_t pid = spawn(cmd, -1, "", false);
 
   if (pid < 0) {
     spdlog::error("Unable to exec cmd {}, error {}", cmd.c_str(), strerror(errno));
-    return pid;
-  }
-
-  // Child executes the command
-  if (!pid) {
-    int err;
-    sigset_t mask;
-    sigfillset(&mask);
-    // Reset sigmask
-    err = pthread_sigmask(SIG_UNBLOCK, &mask, nullptr);
-    if (err != 0) spdlog::error("pthread_sigmask in forkExec failed: {}", strerror(err));
-    setpgid(pid, pid);
-    execl("/bin/sh", "sh", "-c", cmd.c_str(), (char*)0);
-    exit(0);
-  } else {
-    reap_mtx.lock();
-    reap.push_back(pid);
-    reap_mtx.unlock();
-    spdlog::debug("Added child to reap list: {}", pid);
+    return nullptr;
   }
 
-  return pid;
+  Metrics::processSpawned();
+  return ChildSupervisor::inst().watch(pid, std::move(on_exit));
 }
 
 }  // namespace wabar::util::command
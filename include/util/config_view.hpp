@@ -0,0 +1,113 @@
+#pragma once
+
+#include <json/json.h>
+
+#include <array>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "util/format_fields.hpp"
+
+namespace wabar::util {
+
+/**
+ * The keys every module understands, resolved once from its config.
+ *
+ * Formats per state, state thresholds, icon tables, event commands and actions are looked up
+ * here, so updates neither build keys such as "format-" + state nor walk the Json::Value.
+ * Mistakes that are certain to be ignored, such as an unknown "on-" event or a state without a
+ * number, are warned about when the module is built.
+ */
+class ConfigView {
+ public:
+  struct State {
+    std::string name;
+    unsigned threshold;
+  };
+
+  // Icons to pick from by percentage, a single icon is a table of one
+  using IconTable = std::vector<std::string>;
+
+  // Every "on-" key a module can have
+  static constexpr std::array<std::string_view, 25> EVENTS = {
+      "on-click",
+      "on-click-release",
+      "on-double-click",
+      "on-triple-click",
+      "on-click-middle",
+      "on-click-middle-release",
+      "on-double-click-middle",
+      "on-triple-click-middle",
+      "on-click-right",
+      "on-click-right-release",
+      "on-double-click-right",
+      "on-triple-click-right",
+      "on-click-backward",
+      "on-click-backward-release",
+      "on-double-click-backward",
+      "on-triple-click-backward",
+      "on-click-forward",
+      "on-click-forward-release",
+      "on-double-click-forward",
+      "on-triple-click-forward",
+      "on-scroll-up",
+      "on-scroll-down",
+      "on-scroll-left",
+      "on-scroll-right",
+      "on-update",
+  };
+
+  ConfigView() = default;
+  // `module` prefixes the warnings
+  ConfigView(const Json::Value &config, const std::string &module);
+
+  // "format-<key>" (e.g. "format-critical"), null if it isn't a string or `key` is empty
+  const std::string *format(std::string_view key) const { return find(formats_, key); }
+  // "tooltip-format-<key>", likewise
+  const std::string *tooltipFormat(std::string_view key) const {
+    return find(tooltip_formats_, key);
+  }
+
+  // Placeholders of "format", "tooltip-format" and their variants per state, alt or status
+  const FormatFields &fields() const { return fields_; }
+
+  // "states" with a number, by increasing threshold. Of states with the same threshold, only the
+  // first by name is kept.
+  const std::vector<State> &states() const { return states_; }
+
+  // The "format-icons" of `alt`, or the default ones, null if there are none
+  const IconTable *icons(std::string_view alt = "") const;
+  // The "format-icons" of the first of `alts` that has some, or the default ones
+  const IconTable *icons(const std::vector<std::string> &alts) const;
+
+  // The command of an "on-" event, null if it has none
+  const std::string *command(std::string_view event) const { return find(commands_, event); }
+
+  // "actions", module action by event name
+  const std::map<std::string, std::string> &actions() const { return actions_; }
+
+ private:
+  using Table = std::map<std::string, std::string, std::less<>>;
+
+  static const std::string *find(const Table &table, std::string_view key) {
+    auto it = table.find(key);
+    return it == table.end() ? nullptr : &it->second;
+  }
+  static IconTable iconTable(const Json::Value &icons);
+  const IconTable *altIcons(std::string_view alt) const;
+  const IconTable *defaultIcons() const;
+
+  Table formats_;
+  Table tooltip_formats_;
+  FormatFields fields_;
+  std::vector<State> states_;
+  // By alt when "format-icons" is an object, else under ""
+  std::map<std::string, IconTable, std::less<>> icons_;
+  bool icons_by_alt_ = false;
+  Table commands_;
+  std::map<std::string, std::string> actions_;
+};
+
+}  // namespace wabar::util
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <fmt/format.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "util/scheduler.hpp"
+
+namespace wabar::util {
+
+/**
+ * Build a data source key out of the module type and the values that affect sampling.
+ */
+template <typename... Args>
+std::string makeSourceKey(const std::string &type, const Args &...args) {
+  std::string key = type;
+  // Unit separator: can't be mistaken for a part of a path or a command
+  ((key += '\x1f', key += fmt::format("{}", args)), ...);
+  return key;
+}
+
+/**
+ * Process-wide sampled data shared by every instance of a module.
+ *
+ * Bars create their own module instances for each output, but identically configured instances
+ * share the same DataSource, looked up by a key built from the module type and the configuration
+ * fields that affect sampling. The source samples once per interval on a scheduler worker and
+ * notifies every subscriber, so module instances only have to render the latest sample.
+ */
+template <typename T>
+class DataSource {
+ public:
+  using Sampler = std::function<T()>;
+  using Callback = std::function<void()>;
+
+  /**
+   * Subscription to a data source, unsubscribes on destruction.
+   */
+  class Handle {
+   public:
+    Handle() = default;
+    Handle(std::shared_ptr<DataSource> source, uint64_t id)
+        : source_(std::move(source)), id_(id) {}
+    Handle(const Handle &) = delete;
+    Handle &operator=(const Handle &) = delete;
+    Handle(Handle &&other) noexcept { *this = std::move(other); }
+    Handle &operator=(Handle &&other) noexcept {
+      reset();
+      source_ = std::move(other.source_);
+      id_ = other.id_;
+      return *this;
+    }
+    ~Handle() { reset(); }
+
+    explicit operator bool() const { return source_ != nullptr; }
+
+    // Latest sample, default constructed until the first sample is taken
+    T get() const { return source_ ? source_->value().value_or(T{}) : T{}; }
+    bool ready() const { return source_ && source_->value().has_value(); }
+    // Sample again right away, e.g. on user action or signal
+    void refresh() const {
+      if (source_) source_->timer_.wake_up();
+    }
+
+    void reset() {
+      if (source_) {
+        source_->unsubscribe(id_);
+        source_.reset();
+      }
+    }
+
+   private:
+    std::shared_ptr<DataSource> source_;
+    uint64_t id_ = 0;
+  };
+
+  /**
+   * Subscribe to the source identified by `key`, creating it if no module uses it yet.
+   * `on_sample` is called from a scheduler worker after each sample, it should only schedule an
+   * update (e.g. AModule::dp.emit()).
+   */
+  template <typename Rep, typename Period>
+  static Handle subscribe(const std::string &key, std::chrono::duration<Rep, Period> interval,
+                          Sampler sampler, Callback on_sample,
+                          Scheduler::Align align = Scheduler::Align::SECOND) {
+    std::shared_ptr<DataSource> source;
+    {
+      std::lock_guard lock(registryMutex());
+      auto &weak = registry()[key];
+      source = weak.lock();
+      if (!source) {
+        source = std::shared_ptr<DataSource>(new DataSource());
+        weak = source;
+        source->sampler_ = std::move(sampler);
+        source->timer_.start(interval, [raw = source.get()] { raw->sample(); }, align);
+      }
+    }
+    auto id = source->addSubscriber(std::move(on_sample));
+    return Handle(std::move(source), id);
+  }
+
+  ~DataSource() {
+    timer_.stop();
+    std::lock_guard lock(registryMutex());
+    std::erase_if(registry(), [](const auto &entry) { return entry.second.expired(); });
+  }
+
+ private:
+  DataSource() = default;
+
+  static std::mutex &registryMutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  static std::unordered_map<std::string, std::weak_ptr<DataSource>> &registry() {
+    static std::unordered_map<std::string, std::weak_ptr<DataSource>> registry;
+    return registry;
+  }
+
+  std::optional<T> value() const {
+    std::lock_guard lock(mutex_);
+    return value_;
+  }
+
+  void sample() {
+    // Runs on a scheduler worker, never concurrently with itself
+    auto value = sampler_();
+    std::lock_guard lock(mutex_);
+    value_ = std::move(value);
+    for (auto &[id, callback] : subscribers_) {
+      callback();
+    }
+  }
+
+  uint64_t addSubscriber(Callback callback) {
+    std::lock_guard lock(mutex_);
+    auto id = next_id_++;
+    // Late subscribers (e.g. a bar on a new output) render the current sample right away
+    if (value_) {
+      callback();
+    }
+    subscribers_.emplace(id, std::move(callback));
+    return id;
+  }
+
+  void unsubscribe(uint64_t id) {
+    std::lock_guard lock(mutex_);
+    subscribers_.erase(id);
+  }
+
+  Sampler sampler_;
+  mutable std::mutex mutex_;
+  std::optional<T> value_;
+  uint64_t next_id_ = 1;
+  std::map<uint64_t, Callback> subscribers_;
+  Timer timer_;
+};
+
+}  // namespace wabar::util
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "util/command.hpp"
+
+namespace wabar::util::command {
+
+/**
+ * Process-wide cache of command results, for modules opting in with exec-cache-ttl.
+ *
+ * DataSource only shares the sampling of identically configured modules. This goes further: any
+ * module running the same command for the same output (the rest of the environment is the same
+ * for the whole process) joins a run in flight instead of starting its own, and reuses a result
+ * younger than its ttl. Results older than the longest ttl they were asked with are dropped.
+ */
+class ExecCache {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  static ExecCache &inst();
+
+  ExecCache() = default;
+  ExecCache(const ExecCache &) = delete;
+
+  // Result of `run` for `key`, run at most once at a time and reused for `ttl`. An exception
+  // thrown by `run` is thrown to the callers that joined the run as well.
+  res get(const std::string &key, clock::duration ttl, const std::function<res()> &run);
+
+ private:
+  struct Entry {
+    bool running = false;
+    // Callers waiting for the run in flight
+    size_t waiters = 0;
+    // Completed runs, lets waiters tell the run they joined has finished
+    uint64_t generation = 0;
+    std::optional<res> result;
+    // Of the last run, if it threw
+    std::exception_ptr error;
+    clock::time_point finished;
+    clock::duration ttl = clock::duration::zero();
+  };
+
+  void evict(clock::time_point now);
+
+  std::mutex mutex_;
+  std::condition_variable done_cv_;
+  std::unordered_map<std::string, Entry> entries_;
+};
+
+}  // namespace wabar::util::command
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "util/reactor.hpp"
+
+namespace wabar::util {
+
+/**
+ * Reads a file again each time it changes, without polling it.
+ *
+ * The file is kept open and read with pread. Regular files are watched with inotify on their
+ * directory, so a file written and closed, or renamed into place, is picked up, as is a file
+ * created or removed later on. sysfs attributes can't be watched this way and are waited on with
+ * POLLPRI instead, which only works for the attributes whose driver notifies a change. Both are
+ * waited on by the Reactor.
+ */
+class FileWatcher {
+ public:
+  // Called with the whole content, or an empty string while the file can't be read
+  using ChangeHandler = std::function<void(const std::string &content)>;
+
+  // Calls `on_change` with the current content before returning, then on each change
+  FileWatcher(std::string path, ChangeHandler on_change);
+  FileWatcher(const FileWatcher &) = delete;
+  ~FileWatcher();
+
+  // Files larger than this are truncated
+  static constexpr size_t MAX_CONTENT = 64 * 1024;
+
+ private:
+  void open();
+  void arm();
+  void changed();
+  bool drainEvents();
+  bool read(std::string &content) const;
+
+  const std::string path_;
+  const ChangeHandler on_change_;
+  int fd_ = -1;
+  int inotify_fd_ = -1;
+  bool sysfs_ = false;
+  // Last content passed to on_change_, touched by the constructor then the reactor thread only
+  std::string content_;
+  ReactorHandle handle_;
+};
+
+}  // namespace wabar::util
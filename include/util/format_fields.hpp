@@ -0,0 +1,39 @@
+#pragma once
+
+#include <set>
+#include <string>
+#include <string_view>
+
+namespace wabar::util {
+
+/**
+ * The named arguments a set of fmt format strings refer to, such as "usage" and "width" in
+ * "{usage:>{width}}".
+ *
+ * Formats are scanned once when a module is built, so its updates can skip sampling or formatting
+ * the values no format shows. A positional argument ("{}", "{0}") or a format fmt would reject may
+ * stand for any argument, so every name is then reported as shown.
+ */
+class FormatFields {
+ public:
+  FormatFields() = default;
+  explicit FormatFields(std::string_view format) { add(format); }
+
+  void add(std::string_view format);
+  void add(const FormatFields &other);
+
+  bool contains(std::string_view name) const;
+  // Whether a name starts with `prefix`, e.g. "usage" for "{usage}" and "{usage3}"
+  bool containsPrefix(std::string_view prefix) const;
+  // Whether the formats may refer to any argument
+  bool any() const { return any_; }
+
+ private:
+  // Add the argument starting at `i`, just past its '{', and return the index past its '}'
+  size_t argument(std::string_view format, size_t i);
+
+  std::set<std::string, std::less<>> names_;
+  bool any_ = false;
+};
+
+}  // namespace wabar::util
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <json/value.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+namespace wabar::util {
+
+/**
+ * Fixed size log-linear histogram, in the spirit of HdrHistogram.
+ *
+ * Values below 2^SUB_BITS get their own bucket, larger ones are split into power of two ranges of
+ * 2^SUB_BITS buckets each, so every recorded value is known within 1/2^SUB_BITS of its magnitude.
+ * Recording is a couple of bit operations and the memory footprint doesn't depend on the data.
+ */
+class Histogram {
+ public:
+  static constexpr unsigned SUB_BITS = 3;
+  static constexpr unsigned SUB_BUCKETS = 1U << SUB_BITS;
+  // Values are clamped to 2^MAX_BITS - 1, i.e. about 12 days when counting microseconds
+  static constexpr unsigned MAX_BITS = 40;
+  static constexpr unsigned BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+  void record(uint64_t value) {
+    value = std::min(value, (uint64_t{1} << MAX_BITS) - 1);
+    ++buckets_[index(value)];
+    ++count_;
+    sum_ += value;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+
+  uint64_t count() const { return count_; }
+  uint64_t sum() const { return sum_; }
+  uint64_t min() const { return count_ == 0 ? 0 : min_; }
+  uint64_t max() const { return max_; }
+
+  /* Upper bound of the bucket holding the value at `quantile` (0 to 1), capped to max() */
+  uint64_t percentile(double quantile) const {
+    if (count_ == 0) {
+      return 0;
+    }
+    auto rank = static_cast<uint64_t>(quantile * static_cast<double>(count_ - 1)) + 1;
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < BUCKETS; ++i) {
+      seen += buckets_[i];
+      if (seen >= rank) {
+        return std::min(upperBound(i), max_);
+      }
+    }
+    return max_;
+  }
+
+  /* Summary and the non empty buckets as [upper bound, count] pairs */
+  Json::Value toJson() const {
+    Json::Value json;
+    json["count"] = static_cast<Json::UInt64>(count_);
+    json["min"] = static_cast<Json::UInt64>(min());
+    json["max"] = static_cast<Json::UInt64>(max_);
+    json["mean"] = count_ == 0 ? 0.0 : static_cast<double>(sum_) / static_cast<double>(count_);
+    json["p50"] = static_cast<Json::UInt64>(percentile(0.5));
+    json["p90"] = static_cast<Json::UInt64>(percentile(0.9));
+    json["p99"] = static_cast<Json::UInt64>(percentile(0.99));
+    json["p999"] = static_cast<Json::UInt64>(percentile(0.999));
+    auto &buckets = json["buckets"] = Json::Value(Json::arrayValue);
+    for (unsigned i = 0; i < BUCKETS; ++i) {
+      if (buckets_[i] != 0) {
+        Json::Value bucket(Json::arrayValue);
+        bucket.append(static_cast<Json::UInt64>(upperBound(i)));
+        bucket.append(static_cast<Json::UInt64>(buckets_[i]));
+        buckets.append(bucket);
+      }
+    }
+    return json;
+  }
+
+  static unsigned index(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+      return static_cast<unsigned>(value);
+    }
+    unsigned msb = std::bit_width(value) - 1;
+    auto sub = static_cast<unsigned>(value >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1);
+    return (msb - SUB_BITS + 1) * SUB_BUCKETS + sub;
+  }
+
+  /* Largest value filed into bucket `i` */
+  static uint64_t upperBound(unsigned i) {
+    if (i < SUB_BUCKETS) {
+      return i;
+    }
+    unsigned msb = i / SUB_BUCKETS + SUB_BITS - 1;
+    uint64_t sub = i % SUB_BUCKETS;
+    uint64_t width = uint64_t{1} << (msb - SUB_BITS);
+    return (uint64_t{1} << msb) + (sub + 1) * width - 1;
+  }
+
+ private:
+  std::array<uint64_t, BUCKETS> buckets_{};
+  uint64_t count_ = 0;
+  uint64_t sum_ = 0;
+  uint64_t min_ = std::numeric_limits<uint64_t>::max();
+  uint64_t max_ = 0;
+};
+
+}  // namespace wabar::util
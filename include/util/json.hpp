@@ -7,7 +7,10 @@
 #include <codecvt>
 #include <iostream>
 #include <locale>
-#include <regex>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 
 #if (FMT_VERSION >= 90000)
 
@@ -18,30 +21,63 @@ struct fmt::formatter<Json::Value> : ostream_formatter {};
 
 namespace wabar::util {
 
+/**
+ * Parses JSON, accepting the "\xab" escapes some programs (e.g. sway) emit for raw bytes.
+ *
+ * Parses straight from the input with a CharReader kept per thread. The input is only copied
+ * when it has "\x" escapes, which are turned into "\u00" ones in a single pass.
+ */
 class JsonParser {
  public:
   JsonParser() = default;
 
-  Json::Value parse(const std::string& jsonStr) {
-    Json::Value root;
-
-    // replace all occurrences of "\x" with "\u00", because JSON doesn't allow "\x" escape sequences
-    std::string modifiedJsonStr = replaceHexadecimalEscape(jsonStr);
+  Json::Value parse(std::string_view json) const {
+    // Only ever used by this thread, CharReader keeps state while parsing
+    thread_local std::unique_ptr<Json::CharReader> reader(
+        Json::CharReaderBuilder().newCharReader());
+    thread_local std::string translated;
 
-    std::istringstream jsonStream(modifiedJsonStr);
+    const char* begin = json.data();
+    const char* end = begin + json.size();
+    if (replaceHexadecimalEscapes(json, translated)) {
+      begin = translated.data();
+      end = begin + translated.size();
+    }
+    Json::Value root;
     std::string errs;
-    if (!Json::parseFromStream(m_readerBuilder, jsonStream, &root, &errs)) {
+    if (!reader->parse(begin, end, &root, &errs)) {
       throw std::runtime_error("Error parsing JSON: " + errs);
     }
     return root;
   }
 
  private:
-  Json::CharReaderBuilder m_readerBuilder;
+  // Write `json` with "\x" escapes replaced by "\u00" into `out`, returns false if it has none
+  static bool replaceHexadecimalEscapes(std::string_view json, std::string& out) {
+    size_t pos = escapeAt(json, 0);
+    if (pos == std::string_view::npos) {
+      return false;
+    }
+    out.clear();
+    size_t copied = 0;
+    for (; pos != std::string_view::npos; pos = escapeAt(json, pos + 2)) {
+      out.append(json.substr(copied, pos - copied));
+      out.append("\\u00");
+      copied = pos + 2;
+    }
+    out.append(json.substr(copied));
+    return true;
+  }
 
-  static std::string replaceHexadecimalEscape(const std::string& str) {
-    static std::regex re("\\\\x");
-    return std::regex_replace(str, re, "\\u00");
+  // Position of the next "\x" escape from `pos`, other escapes such as "\\x" are skipped
+  static size_t escapeAt(std::string_view json, size_t pos) {
+    while ((pos = json.find('\\', pos)) != std::string_view::npos && pos + 1 < json.size()) {
+      if (json[pos + 1] == 'x') {
+        return pos;
+      }
+      pos += 2;
+    }
+    return std::string_view::npos;
   }
 };
 }  // namespace wabar::util
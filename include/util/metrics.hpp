@@ -0,0 +1,123 @@
+#pragma once
+
+#include <json/value.h>
+#include <sys/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "util/histogram.hpp"
+
+namespace wabar::util {
+
+/**
+ * Runtime counters of a module instance.
+ */
+class ModuleMetrics {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  ModuleMetrics(std::string name, std::string output)
+      : name_(std::move(name)), output_(std::move(output)) {}
+
+  const std::string &name() const { return name_; }
+  const std::string &output() const { return output_; }
+
+  // Time spent in update()
+  void recordUpdate(clock::duration duration);
+  // Time from dp.emit() to the frame showing the update
+  void recordLatency(clock::duration duration);
+
+  std::atomic<int64_t> threads = 0;
+  std::atomic<uint64_t> processes = 0;
+  // Background processes still running
+  std::atomic<int64_t> children = 0;
+
+  Json::Value toJson() const;
+
+ private:
+  const std::string name_;
+  const std::string output_;
+  mutable std::mutex mutex_;
+  Histogram update_;
+  Histogram latency_;
+};
+
+/**
+ * Process-wide runtime metrics, served as JSON on a Unix socket and queried with `wabar --stats`.
+ *
+ * Work done on behalf of a module (threads started, processes spawned) is attributed through a
+ * thread local current module set by Scope. Bars set it while creating and updating a module,
+ * threads and scheduler tasks inherit the one active when they are started.
+ */
+class Metrics {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  /**
+   * Makes `metrics` the current module of the calling thread for the enclosing scope.
+   */
+  class Scope {
+   public:
+    explicit Scope(std::shared_ptr<ModuleMetrics> metrics);
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+    ~Scope();
+
+   private:
+    std::shared_ptr<ModuleMetrics> previous_;
+  };
+
+  // Iterations of the main loop longer than this are counted as stalls
+  static constexpr auto STALL_THRESHOLD = std::chrono::milliseconds(50);
+
+  static Metrics &inst();
+  static std::shared_ptr<ModuleMetrics> current();
+
+  Metrics() = default;
+  Metrics(const Metrics &) = delete;
+  ~Metrics();
+
+  std::shared_ptr<ModuleMetrics> add(const std::string &name, const std::string &output);
+
+  // Count a thread or a process of the current module
+  static void threadStarted();
+  static void threadStopped(const std::shared_ptr<ModuleMetrics> &owner);
+  static void processSpawned();
+
+  // Time the main loop spent dispatching between two polls
+  void recordLoopIteration(clock::duration duration);
+
+  Json::Value snapshot();
+
+  // Serve snapshots on socketPath() from a background thread
+  void serve();
+  static std::string socketPath(pid_t pid);
+  // Print the snapshots of every running instance, returns the exit code of `wabar --stats`
+  static int query();
+
+ private:
+  void acceptLoop();
+
+  std::mutex mutex_;
+  std::vector<std::weak_ptr<ModuleMetrics>> modules_;
+  Histogram loop_;
+  uint64_t stall_us_ = 0;
+  uint64_t stalls_ = 0;
+  const clock::time_point started_ = clock::now();
+
+  std::atomic<uint64_t> processes_ = 0;
+  std::atomic<int64_t> threads_ = 0;
+
+  int fd_ = -1;
+  std::string path_;
+  std::thread thread_;
+};
+
+}  // namespace wabar::util
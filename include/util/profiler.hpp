@@ -0,0 +1,76 @@
+#pragma once
+
+#include <json/value.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace wabar::util {
+
+/**
+ * Records timed spans and writes them as a Chrome trace (chrome://tracing, Perfetto).
+ *
+ * Recording is off by default, spans are then a single relaxed atomic load. Once started the
+ * profiler collects spans from any thread until finish() writes the trace file.
+ */
+class Profiler {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  /**
+   * Times the enclosing scope, `detail` (e.g. a module or output name) ends up in the span args.
+   */
+  class Span {
+   public:
+    explicit Span(std::string_view name, std::string_view detail = {},
+                  Profiler &profiler = Profiler::inst());
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+    ~Span();
+
+   private:
+    Profiler *profiler_ = nullptr;
+    std::string name_;
+    std::string detail_;
+    clock::time_point begin_;
+  };
+
+  static Profiler &inst();
+
+  Profiler() = default;
+  Profiler(const Profiler &) = delete;
+
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  // Start recording, the trace is written to `path` by finish()
+  void start(const std::string &path);
+  // Stop recording and write the trace, does nothing if not recording
+  void finish();
+
+  void record(std::string name, std::string detail, clock::time_point begin,
+              clock::time_point end);
+  Json::Value trace() const;
+
+ private:
+  struct Event {
+    std::string name;
+    std::string detail;
+    clock::time_point begin;
+    clock::time_point end;
+    unsigned thread;
+  };
+
+  static unsigned threadId();
+
+  std::atomic<bool> enabled_ = false;
+  mutable std::mutex mutex_;
+  std::string path_;
+  clock::time_point origin_ = clock::now();
+  std::vector<Event> events_;
+};
+
+}  // namespace wabar::util
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <json/value.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "util/json.hpp"
+
+namespace wabar::util {
+
+/**
+ * Unix socket through which external programs push module updates, instead of being polled.
+ *
+ * Producers connect to socketPath() and write one JSON object per line, e.g.
+ * {"module": "custom/vpn", "text": "on", "class": "connected"}. Each line is handed to every
+ * subscriber of its "module", on every bar. Connections are read on the Reactor thread.
+ */
+class PushServer {
+ public:
+  using Handler = std::function<void(const Json::Value &)>;
+
+  /**
+   * Subscription to the updates of a module, unsubscribes on destruction.
+   */
+  class Subscription {
+   public:
+    Subscription() = default;
+    Subscription(PushServer *server, uint64_t id) : server_(server), id_(id) {}
+    Subscription(const Subscription &) = delete;
+    Subscription &operator=(const Subscription &) = delete;
+    Subscription(Subscription &&other) noexcept { *this = std::move(other); }
+    Subscription &operator=(Subscription &&other) noexcept {
+      reset();
+      server_ = std::exchange(other.server_, nullptr);
+      id_ = other.id_;
+      return *this;
+    }
+    ~Subscription() { reset(); }
+
+    void reset() {
+      if (server_ != nullptr) {
+        server_->unsubscribe(id_);
+        server_ = nullptr;
+      }
+    }
+
+   private:
+    PushServer *server_ = nullptr;
+    uint64_t id_ = 0;
+  };
+
+  static PushServer &inst();
+
+  PushServer() = default;
+  PushServer(const PushServer &) = delete;
+  ~PushServer();
+
+  // `handler` runs on the reactor thread and should only schedule an update
+  Subscription subscribe(const std::string &module, Handler handler);
+
+  // Start listening on socketPath()
+  void serve();
+  static std::string socketPath();
+
+  // Hand one line of a producer to the subscribers of its module
+  void dispatch(std::string_view line);
+
+ private:
+  void unsubscribe(uint64_t id);
+  void accept();
+
+  std::mutex mutex_;
+  uint64_t next_id_ = 1;
+  std::multimap<std::string, std::pair<uint64_t, Handler>> subscribers_;
+  JsonParser parser_;
+
+  int fd_ = -1;
+  std::string path_;
+};
+
+}  // namespace wabar::util
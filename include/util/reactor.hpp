@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+namespace wabar::util {
+
+/**
+ * Process-wide event loop for pipes of long running commands.
+ *
+ * A single thread waits on every registered fd with epoll (poll where it isn't available) and
+ * splits what it reads into lines, replacing a blocked reader thread per command. It also runs
+ * one-shot timers, e.g. to restart a command after a delay, and one-shot readiness callbacks.
+ * Callbacks run on the reactor thread and must not block.
+ */
+class Reactor {
+ public:
+  using clock = std::chrono::steady_clock;
+  using LineHandler = std::function<void(std::string_view)>;
+
+  struct Source;
+
+  static Reactor &inst();
+
+  Reactor(const Reactor &) = delete;
+  ~Reactor();
+
+  // Call `on_line` for each line read from `fd`, without its newline, then `on_eof` once at the
+  // end of the stream. The fd is made non-blocking and stays owned by the caller, which must keep
+  // it open until `on_eof` has been called or the source is cancelled.
+  std::shared_ptr<Source> readLines(int fd, LineHandler on_line, std::function<void()> on_eof);
+  // Call `on_ready` once when `fd` becomes readable, e.g. for a pidfd. With `priority`, waits
+  // for POLLPRI instead, which is how sysfs attributes notify a change.
+  std::shared_ptr<Source> readable(int fd, std::function<void()> on_ready, bool priority = false);
+  // Run `func` once after `delay`
+  std::shared_ptr<Source> after(clock::duration delay, std::function<void()> func);
+  // Unregister the source. Blocks until a concurrent callback of the source has finished.
+  void cancel(const std::shared_ptr<Source> &source);
+
+  // Lines longer than this are split
+  static constexpr size_t MAX_LINE = 64 * 1024;
+  // Read from an fd per wakeup at most. The rest is read on the next turn of the loop, after the
+  // other ready fds and the due timers, so a command writing nonstop can't starve them.
+  static constexpr size_t READ_BUDGET = 64 * 1024;
+
+ private:
+  Reactor();
+  void loop();
+  void wake();
+  void add(const std::shared_ptr<Source> &source);
+  void remove(const std::shared_ptr<Source> &source);
+  void read(const std::shared_ptr<Source> &source);
+  void run(const std::shared_ptr<Source> &source, const std::function<void()> &func);
+  bool acquire(const std::shared_ptr<Source> &source);
+  void release(const std::shared_ptr<Source> &source);
+  bool call(const std::shared_ptr<Source> &source, const std::function<void()> &func);
+  int timeout() const;
+
+  std::mutex mutex_;
+  std::condition_variable done_cv_;
+  bool stop_ = false;
+  std::unordered_map<int, std::shared_ptr<Source>> readers_;
+  std::multimap<clock::time_point, std::shared_ptr<Source>> timers_;
+  std::array<char, 4096> chunk_;
+
+  int poll_fd_ = -1;
+  int wake_fds_[2] = {-1, -1};
+  std::thread thread_;
+};
+
+/**
+ * RAII handle of the reactor sources of a module.
+ *
+ * Holds at most one source at a time: starting a new one, which may be done from a callback of
+ * the current one, replaces it. Once stopped, nothing can be started anymore.
+ */
+class ReactorHandle {
+ public:
+  ReactorHandle() = default;
+  ReactorHandle(const ReactorHandle &) = delete;
+  ReactorHandle &operator=(const ReactorHandle &) = delete;
+  ~ReactorHandle() { stop(); }
+
+  void readLines(int fd, Reactor::LineHandler on_line, std::function<void()> on_eof);
+  void readable(int fd, std::function<void()> on_ready, bool priority = false);
+  template <typename Rep, typename Period>
+  void after(std::chrono::duration<Rep, Period> delay, std::function<void()> func) {
+    replace([&] {
+      return Reactor::inst().after(std::chrono::duration_cast<Reactor::clock::duration>(delay),
+                                   std::move(func));
+    });
+  }
+  void stop();
+
+ private:
+  void replace(const std::function<std::shared_ptr<Reactor::Source>()> &start);
+
+  std::mutex mutex_;
+  bool stopped_ = false;
+  std::shared_ptr<Reactor::Source> source_;
+};
+
+}  // namespace wabar::util
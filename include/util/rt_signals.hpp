@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glibmm/iochannel.h>
+
+#include <functional>
+#include <set>
+
+#include "util/update_queue.hpp"
+
+namespace wabar::util {
+
+/**
+ * Real-time signals sent to the modules (SIGRTMIN+1 to SIGRTMAX), handled in the main loop.
+ *
+ * They are read from a signalfd rather than handled in a signal handler, where calling into the
+ * modules isn't safe. Signals received until the next frame are merged: a module signalled many
+ * times in a row, e.g. by a volume key held down, is refreshed once per frame. Without signalfd,
+ * a signal handler writes the signals to a pipe read the same way.
+ */
+class RtSignals {
+ public:
+  using Handler = std::function<void(int signal)>;
+
+  static RtSignals &inst();
+
+  RtSignals(const RtSignals &) = delete;
+  ~RtSignals();
+
+  // Keep the signals for the signalfd, called before starting any other thread
+  static void block();
+  // Start calling `handler` on the main thread for each distinct signal received
+  void start(Handler handler);
+
+ private:
+  RtSignals() = default;
+  bool read(Glib::IOCondition condition);
+  void dispatch();
+
+  Handler handler_;
+  int fd_ = -1;
+  // Main thread only
+  std::set<int> pending_;
+  UpdateDispatcher dp_;
+};
+
+}  // namespace wabar::util
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <sigc++/connection.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "util/metrics.hpp"
+#include "util/timer_wheel.hpp"
+
+namespace wabar::util {
+
+/**
+ * Process-wide timer service for interval driven modules.
+ *
+ * All periodic tasks share a single timer wheel driven by one thread. Expired tasks are handed to
+ * a small, lazily grown worker pool. A task left waiting while every worker is busy, e.g. on slow
+ * custom scripts, gets an extra worker, so blocking tasks can't delay the cheap ones for long.
+ * Deadlines are rounded up to the slack window and whole-second intervals are aligned to wall
+ * clock second boundaries, so modules polling at different rates still wake the CPU together.
+ */
+class Scheduler {
+ public:
+  using duration = std::chrono::milliseconds;
+
+  enum class Align {
+    // Plain fixed delay after each run
+    NONE,
+    // Snap whole-second deadlines to the wall clock second boundary
+    SECOND,
+    // Snap deadlines to a wall clock multiple of the interval (e.g. minute for clocks)
+    INTERVAL,
+  };
+
+  struct Task;
+
+  static Scheduler &inst();
+
+  Scheduler(const Scheduler &) = delete;
+  ~Scheduler();
+
+  // Run `func` now and then every `interval`. Interval of duration::max() runs only on wake up.
+  std::shared_ptr<Task> add(duration interval, std::function<void()> func, Align align);
+  // Run the task as soon as possible, then resume the regular interval
+  void wakeUp(const std::shared_ptr<Task> &task);
+  void wakeUpAll();
+  // Unschedule the task. Blocks until a concurrent run of the task has finished.
+  void cancel(const std::shared_ptr<Task> &task);
+
+  void setSlack(duration slack);
+
+  static constexpr duration TICK{10};
+  static constexpr duration DEFAULT_SLACK{50};
+  // Started on demand and kept
+  static constexpr size_t MAX_WORKERS = 4;
+  // Started for a task that waited this long while every worker was busy
+  static constexpr duration STALL_TIMEOUT{100};
+  static constexpr size_t MAX_EXTRA_WORKERS = 28;
+  // Workers beyond MAX_WORKERS exit after being idle this long
+  static constexpr std::chrono::seconds EXTRA_IDLE_TIMEOUT{30};
+
+ private:
+  using clock = std::chrono::steady_clock;
+
+  Scheduler();
+  void timerLoop();
+  void workerLoop();
+  void dispatch(const std::shared_ptr<Task> &task);
+  void spawn();
+  bool stalled() const;
+  void rearm(const std::shared_ptr<Task> &task);
+  TimerWheel::tick_t toTick(clock::time_point tp) const;
+
+  std::mutex mutex_;
+  std::condition_variable timer_cv_;
+  std::condition_variable worker_cv_;
+  std::condition_variable done_cv_;
+  bool stop_ = false;
+
+  const clock::time_point epoch_ = clock::now();
+  duration slack_ = DEFAULT_SLACK;
+  TimerWheel wheel_;
+  uint64_t next_id_ = 1;
+  std::unordered_map<uint64_t, std::shared_ptr<Task>> tasks_;
+  std::deque<std::shared_ptr<Task>> ready_;
+
+  size_t idle_ = 0;
+  // Workers spawned but not waiting for tasks yet
+  size_t starting_ = 0;
+  // Workers that haven't exited
+  size_t live_ = 0;
+  std::vector<std::thread> workers_;
+  // Extra workers that exited, joined on the next spawn
+  std::vector<std::thread::id> finished_;
+  std::thread timer_thread_;
+  sigc::connection sleep_connection_;
+};
+
+/**
+ * RAII handle of a scheduled task, a drop-in replacement of a polling SleeperThread.
+ */
+class Timer {
+ public:
+  Timer() = default;
+  Timer(const Timer &) = delete;
+  Timer &operator=(const Timer &) = delete;
+  ~Timer() { stop(); }
+
+  template <typename Rep, typename Period>
+  void start(std::chrono::duration<Rep, Period> interval, std::function<void()> func,
+             Scheduler::Align align = Scheduler::Align::SECOND) {
+    stop();
+    // Saturate, as modules use seconds::max() for "once"
+    auto ms = std::chrono::duration<double, std::milli>(interval).count();
+    auto interval_ms = ms >= static_cast<double>(Scheduler::duration::max().count())
+                           ? Scheduler::duration::max()
+                           : std::chrono::duration_cast<Scheduler::duration>(interval);
+    if (auto owner = Metrics::current()) {
+      // Keep attributing the work to the module starting the timer
+      func = [owner, func = std::move(func)] {
+        Metrics::Scope scope(owner);
+        func();
+      };
+    }
+    task_ = Scheduler::inst().add(interval_ms, std::move(func), align);
+  }
+
+  bool isRunning() const { return task_ != nullptr; }
+
+  void wake_up() {
+    if (task_) {
+      Scheduler::inst().wakeUp(task_);
+    }
+  }
+
+  void stop() {
+    if (task_) {
+      Scheduler::inst().cancel(task_);
+      task_.reset();
+    }
+  }
+
+ private:
+  std::shared_ptr<Scheduler::Task> task_;
+};
+
+}  // namespace wabar::util
@@ -7,6 +7,7 @@
 #include <thread>
 
 #include "prepare_for_sleep.h"
+#include "util/metrics.hpp"
 
 namespace wabar::util {
 
@@ -29,20 +30,25 @@ class SleeperThread {
  public:
   SleeperThread() = default;
 
-  SleeperThread(std::function<void()> func)
-      : thread_{[this, func] {
-          while (do_run_) {
-            signal_ = false;
-            func();
-          }
-        }} {
+  SleeperThread(std::function<void()> func) : owner_(Metrics::current()) {
+    Metrics::threadStarted();
+    thread_ = std::thread([this, func] {
+      Metrics::Scope scope(owner_);
+      while (do_run_) {
+        signal_ = false;
+        func();
+      }
+    });
     connection_ = prepare_for_sleep().connect([this](bool sleep) {
       if (not sleep) wake_up();
     });
   }
 
   SleeperThread& operator=(std::function<void()> func) {
+    owner_ = Metrics::current();
+    Metrics::threadStarted();
     thread_ = std::thread([this, func] {
+      Metrics::Scope scope(owner_);
       while (do_run_) {
         signal_ = false;
         func();
@@ -111,6 +117,7 @@ class SleeperThread {
     stop();
     if (thread_.joinable()) {
       thread_.join();
+      Metrics::threadStopped(owner_);
     }
   }
 
@@ -121,6 +128,8 @@ class SleeperThread {
   bool do_run_ = true;
   bool signal_ = false;
   sigc::connection connection_;
+  // Module the thread works for, see Metrics
+  std::shared_ptr<ModuleMetrics> owner_;
 };
 
 }  // namespace wabar::util
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <json/value.h>
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace wabar::util {
+
+/**
+ * What a module showed, saved to be shown on the next start until the module has data again.
+ */
+struct ModuleState {
+  std::string markup;
+  std::vector<std::string> classes;
+
+  bool operator==(const ModuleState &) const = default;
+};
+
+/**
+ * Last known state of the modules of every bar, kept in a file under $XDG_CACHE_HOME.
+ *
+ * The file is loaded once on start, so that a bar shows the text of its modules from the
+ * previous run right away instead of being empty while they fetch their data. The states are
+ * written back periodically, only when they changed.
+ */
+class StateCache {
+ public:
+  static StateCache &inst();
+
+  explicit StateCache(std::string path);
+  StateCache(const StateCache &) = delete;
+
+  // $XDG_CACHE_HOME/wabar/state.json, or under ~/.cache, empty without either
+  static std::string defaultPath();
+
+  std::optional<ModuleState> get(const std::string &output, const std::string &module);
+  // No state is saved for a module showing nothing
+  void set(const std::string &output, const std::string &module,
+           const std::optional<ModuleState> &state);
+  // Write the file if a state changed since the last save
+  void save();
+
+ private:
+  void load();
+
+  std::mutex mutex_;
+  const std::string path_;
+  Json::Value states_{Json::objectValue};
+  bool loaded_ = false;
+  bool dirty_ = false;
+};
+
+}  // namespace wabar::util
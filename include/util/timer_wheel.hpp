@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace wabar::util {
+
+/**
+ * Hierarchical timing wheel.
+ *
+ * Time is measured in abstract ticks. Level N has 64 slots, each covering 64^N ticks, so four
+ * levels span 64^4 ticks. Timers are filed into the coarsest slot that can hold them and are
+ * cascaded into finer levels as the wheel turns, which keeps insertion, removal and expiry cheap
+ * no matter how many timers are armed.
+ */
+class TimerWheel {
+ public:
+  using tick_t = uint64_t;
+  using id_t = uint64_t;
+
+  static constexpr unsigned LEVELS = 4;
+  static constexpr unsigned SLOT_BITS = 6;
+  static constexpr unsigned SLOTS = 1U << SLOT_BITS;
+
+  explicit TimerWheel(tick_t now = 0) : now_(now) {}
+
+  tick_t now() const { return now_; }
+  bool empty() const { return entries_.empty(); }
+  bool contains(id_t id) const { return entries_.count(id) != 0; }
+
+  /* Arm timer `id` to expire at `expires`. Timers in the past expire on the next advance() */
+  void insert(id_t id, tick_t expires) {
+    remove(id);
+    entries_.emplace(id, Entry{expires, 0, 0, false});
+    place(id);
+  }
+
+  bool remove(id_t id) {
+    auto it = entries_.find(id);
+    if (it == entries_.end()) {
+      return false;
+    }
+    auto &entry = it->second;
+    auto &bucket = entry.due ? due_ : slots_[entry.level][entry.slot];
+    for (auto b = bucket.begin(); b != bucket.end(); ++b) {
+      if (*b == id) {
+        *b = bucket.back();
+        bucket.pop_back();
+        break;
+      }
+    }
+    if (!entry.due && bucket.empty()) {
+      occupied_[entry.level] &= ~(uint64_t{1} << entry.slot);
+    }
+    entries_.erase(it);
+    return true;
+  }
+
+  /* Turn the wheel forward to `tick` and append every expired timer to `expired` */
+  void advance(tick_t tick, std::vector<id_t> &expired) {
+    while (now_ < tick) {
+      if (entries_.size() == due_.size()) {
+        // Nothing left on the wheel itself, skip the idle stretch
+        now_ = tick;
+        break;
+      }
+      // Jump straight to the next tick that has a slot to expire or to cascade
+      tick_t step = tick;
+      if (occupied_[0] != 0) {
+        step = now_ + 1;
+      }
+      for (unsigned level = 1; level < LEVELS; ++level) {
+        if (occupied_[level] != 0) {
+          step = std::min(step, ((now_ >> (SLOT_BITS * level)) + 1) << (SLOT_BITS * level));
+        }
+      }
+      now_ = step;
+      for (unsigned level = LEVELS - 1; level > 0; --level) {
+        if ((now_ & ((tick_t{1} << (SLOT_BITS * level)) - 1)) == 0) {
+          cascade(level, (now_ >> (SLOT_BITS * level)) & (SLOTS - 1));
+        }
+      }
+      cascade(0, now_ & (SLOTS - 1));
+    }
+    for (auto id : due_) {
+      entries_.erase(id);
+      expired.push_back(id);
+    }
+    due_.clear();
+  }
+
+  /* Earliest tick at which advance() will produce an expired timer */
+  std::optional<tick_t> nextExpiry() const {
+    if (!due_.empty()) {
+      return now_;
+    }
+    std::optional<tick_t> next;
+    for (unsigned level = 0; level < LEVELS; ++level) {
+      if (occupied_[level] == 0) {
+        continue;
+      }
+      if (level == LEVELS - 1) {
+        // Timers parked beyond the horizon break slot ordering, check every slot
+        for (unsigned slot = 0; slot < SLOTS; ++slot) {
+          earliest(slots_[level][slot], next);
+        }
+        continue;
+      }
+      // Slots are visited in time order starting right after the current one
+      auto current = (now_ >> (SLOT_BITS * level)) & (SLOTS - 1);
+      auto rotated = std::rotr(occupied_[level], static_cast<int>(current + 1) % SLOTS);
+      earliest(slots_[level][(current + 1 + std::countr_zero(rotated)) & (SLOTS - 1)], next);
+    }
+    return next;
+  }
+
+ private:
+  struct Entry {
+    tick_t expires;
+    unsigned level;
+    unsigned slot;
+    bool due;
+  };
+
+  void earliest(const std::vector<id_t> &bucket, std::optional<tick_t> &next) const {
+    for (auto id : bucket) {
+      auto expires = entries_.at(id).expires;
+      if (!next || expires < *next) {
+        next = expires;
+      }
+    }
+  }
+
+  void place(id_t id) {
+    auto &entry = entries_.at(id);
+    if (entry.expires <= now_) {
+      entry.due = true;
+      due_.push_back(id);
+      return;
+    }
+    entry.due = false;
+    unsigned level = 0;
+    while (level < LEVELS &&
+           (entry.expires >> (SLOT_BITS * level)) - (now_ >> (SLOT_BITS * level)) >= SLOTS) {
+      ++level;
+    }
+    tick_t slot_index;
+    if (level == LEVELS) {
+      // Beyond the wheel horizon: park in the furthest top level slot and re-file on cascade
+      level = LEVELS - 1;
+      slot_index = (now_ >> (SLOT_BITS * level)) + SLOTS - 1;
+    } else {
+      slot_index = entry.expires >> (SLOT_BITS * level);
+    }
+    entry.level = level;
+    entry.slot = slot_index & (SLOTS - 1);
+    slots_[level][entry.slot].push_back(id);
+    occupied_[level] |= uint64_t{1} << entry.slot;
+  }
+
+  void cascade(unsigned level, tick_t slot) {
+    if ((occupied_[level] & (uint64_t{1} << slot)) == 0) {
+      return;
+    }
+    auto bucket = std::move(slots_[level][slot]);
+    slots_[level][slot].clear();
+    occupied_[level] &= ~(uint64_t{1} << slot);
+    for (auto id : bucket) {
+      place(id);
+    }
+  }
+
+  tick_t now_;
+  std::unordered_map<id_t, Entry> entries_;
+  std::array<std::array<std::vector<id_t>, SLOTS>, LEVELS> slots_;
+  std::array<uint64_t, LEVELS> occupied_{};
+  std::vector<id_t> due_;
+};
+
+}  // namespace wabar::util
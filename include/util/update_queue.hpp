@@ -0,0 +1,109 @@
+#pragma once
+
+#include <glibmm/dispatcher.h>
+#include <gtkmm/widget.h>
+#include <sigc++/connection.h>
+#include <sigc++/signal.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace wabar::util {
+
+class UpdateDispatcher;
+
+using UpdateLatencyCallback = std::function<void(std::chrono::steady_clock::duration)>;
+
+/**
+ * Process-wide queue of modules waiting for an update.
+ *
+ * Modules mark themselves dirty from any thread, the queue wakes the main loop once and flushes
+ * every dirty module in a single batch on the next frame clock tick of a bar window. A burst of
+ * events thus costs one relayout per frame, no matter how many modules or events are involved.
+ * Flushes can additionally be capped to a maximum rate.
+ */
+class UpdateQueue {
+ public:
+  static UpdateQueue &inst();
+
+  UpdateQueue(const UpdateQueue &) = delete;
+  ~UpdateQueue();
+
+  // Bar windows whose frame clock drives the flushes
+  void attach(Gtk::Widget &widget);
+  void detach(Gtk::Widget &widget);
+
+  // 0 means no cap, flush on every frame
+  void setMaxFps(unsigned fps);
+
+ private:
+  friend class UpdateDispatcher;
+  using clock = std::chrono::steady_clock;
+
+  UpdateQueue();
+  void schedule(UpdateDispatcher *dispatcher);
+  void remove(UpdateDispatcher *dispatcher);
+  void requestFrame();
+  void waitForFrame();
+  // `painting` is the widget whose frame is being drawn, if any
+  void flush(Gtk::Widget *painting = nullptr);
+  void reportLatency();
+  static void handleAfterPaint(GdkFrameClock *clock, gpointer data);
+
+  std::mutex mutex_;
+  std::deque<UpdateDispatcher *> dirty_;
+  // Batch being flushed, dispatchers destroyed mid-flush are dropped from it
+  std::deque<UpdateDispatcher *> flushing_;
+  bool wakeup_pending_ = false;
+
+  // Main thread only
+  Glib::Dispatcher wakeup_;
+  std::vector<Gtk::Widget *> widgets_;
+  bool frame_requested_ = false;
+  Gtk::Widget *tick_widget_ = nullptr;
+  guint tick_id_ = 0;
+  sigc::connection delay_connection_;
+  sigc::connection timeout_connection_;
+  clock::duration min_frame_interval_ = clock::duration::zero();
+  clock::time_point last_flush_;
+  // Updates of the last flush waiting for the frame to be painted
+  std::vector<std::pair<clock::time_point, UpdateLatencyCallback>> painting_;
+  GdkFrameClock *paint_clock_ = nullptr;
+  gulong paint_handler_ = 0;
+};
+
+/**
+ * Drop-in replacement of Glib::Dispatcher for module updates: emit() marks the module dirty and the
+ * connected slots run on the main thread on the next flush of the UpdateQueue.
+ */
+class UpdateDispatcher {
+ public:
+  UpdateDispatcher();
+  UpdateDispatcher(const UpdateDispatcher &) = delete;
+  UpdateDispatcher &operator=(const UpdateDispatcher &) = delete;
+  ~UpdateDispatcher();
+
+  // Thread safe, repeated emissions before the flush are merged
+  void emit() { UpdateQueue::inst().schedule(this); }
+  void operator()() { emit(); }
+
+  sigc::connection connect(const sigc::slot<void()> &slot) { return signal_.connect(slot); }
+
+  // Called with the time from the first emit() to the frame showing the update
+  void setLatencyCallback(UpdateLatencyCallback callback) { latency_cb_ = std::move(callback); }
+
+ private:
+  friend class UpdateQueue;
+
+  sigc::signal<void()> signal_;
+  UpdateLatencyCallback latency_cb_;
+  // Guarded by UpdateQueue::mutex_
+  bool queued_ = false;
+  std::chrono::steady_clock::time_point queued_at_;
+};
+
+}  // namespace wabar::util
@@ -1,6 +1,9 @@
 #include "ALabel.hpp"
 
 #include <fmt/format.h>
+#include <glibmm/main.h>
+
+#include <algorithm>
 
 #include <util/command.hpp>
 
@@ -15,7 +18,9 @@ ALabel::ALabel(const Json::Value& config, const std::string& name, const std::st
                     ? std::chrono::seconds::max()
                     : std::chrono::seconds(
                           config_["interval"].isUInt() ? config_["interval"].asUInt() : interval)),
-      default_format_(format_) {
+      default_format_(format_),
+      fields_(config_view_.fields()) {
+  fields_.add(format_);
   label_.set_name(name);
   if (!id.empty()) {
     label_.get_style_context()->add_class(id);
@@ -63,54 +68,140 @@ ALabel::ALabel(const Json::Value& config, const std::string& name, const std::st
   }
 }
 
-auto ALabel::update() -> void { AModule::update(); }
+ALabel::~ALabel() { stale_timeout_.disconnect(); }
 
-std::string ALabel::getIcon(uint16_t percentage, const std::string& alt, uint16_t max) {
-  auto format_icons = config_["format-icons"];
-  if (format_icons.isObject()) {
-    if (!alt.empty() && (format_icons[alt].isString() || format_icons[alt].isArray())) {
-      format_icons = format_icons[alt];
-    } else {
-      format_icons = format_icons["default"];
-    }
+auto ALabel::update() -> void {
+  // Rebuild a visible tooltip with the new data
+  if (tooltip_callback_ && hovered_) {
+    label_.trigger_tooltip_query();
   }
-  if (format_icons.isArray()) {
-    auto size = format_icons.size();
-    if (size) {
-      auto idx = std::clamp(percentage / ((max == 0 ? 100 : max) / size), 0U, size - 1);
-      format_icons = format_icons[idx];
-    }
+  AModule::update();
+}
+
+void ALabel::restoreState(const util::ModuleState& state) {
+  restored_ = state;
+  stale_until_ = std::chrono::steady_clock::now() + STALE_TIMEOUT;
+  applyRestored();
+  // Take it down even if the module never updates again
+  stale_timeout_ = Glib::signal_timeout().connect_seconds(
+      [this] {
+        dp.emit();
+        return false;
+      },
+      STALE_TIMEOUT.count());
+}
+
+std::optional<util::ModuleState> ALabel::saveState() {
+  if (!showsContent()) {
+    return std::nullopt;
   }
-  if (format_icons.isString()) {
-    return format_icons.asString();
+  util::ModuleState state{label_.get_label(), {}};
+  for (const auto& name : label_.get_style_context()->list_classes()) {
+    state.classes.push_back(name);
   }
-  return "";
+  return state;
 }
 
-std::string ALabel::getIcon(uint16_t percentage, const std::vector<std::string>& alts,
-                            uint16_t max) {
-  auto format_icons = config_["format-icons"];
-  if (format_icons.isObject()) {
-    std::string _alt = "default";
-    for (const auto& alt : alts) {
-      if (!alt.empty() && (format_icons[alt].isString() || format_icons[alt].isArray())) {
-        _alt = alt;
-        break;
-      }
+void ALabel::updateOverRestored() {
+  if (!restored_) {
+    update();
+    return;
+  }
+  // The module updates a label without the restored state, it may add the same classes. A module
+  // that returns without touching the label leaves it empty, rather than last run's text.
+  removeRestored();
+  update();
+  if (showsContent() || std::chrono::steady_clock::now() >= stale_until_) {
+    restored_.reset();
+    stale_timeout_.disconnect();
+    return;
+  }
+  applyRestored();
+}
+
+void ALabel::applyRestored() {
+  label_.set_markup(restored_->markup);
+  auto style = label_.get_style_context();
+  for (const auto& name : restored_->classes) {
+    if (!style->has_class(name)) {
+      style->add_class(name);
+      restored_classes_.push_back(name);
     }
-    format_icons = format_icons[_alt];
   }
-  if (format_icons.isArray()) {
-    auto size = format_icons.size();
-    if (size) {
-      auto idx = std::clamp(percentage / ((max == 0 ? 100 : max) / size), 0U, size - 1);
-      format_icons = format_icons[idx];
-    }
+  style->add_class(STALE_CLASS);
+  restored_shown_box_ = !event_box_.get_visible();
+  event_box_.show();
+}
+
+void ALabel::removeRestored() {
+  auto style = label_.get_style_context();
+  for (const auto& name : restored_classes_) {
+    style->remove_class(name);
+  }
+  restored_classes_.clear();
+  style->remove_class(STALE_CLASS);
+  label_.set_markup("");
+  if (restored_shown_box_) {
+    event_box_.hide();
+    restored_shown_box_ = false;
   }
-  if (format_icons.isString()) {
-    return format_icons.asString();
+}
+
+bool ALabel::showsContent() { return event_box_.get_visible() && !label_.get_label().empty(); }
+
+void ALabel::setTooltipCallback(TooltipCallback callback, bool markup) {
+  if (callback && !tooltip_connection_.connected()) {
+    // Connected once, the callback is only replaced afterwards
+    tooltip_connection_ =
+        label_.signal_query_tooltip().connect(sigc::mem_fun(*this, &ALabel::handleQueryTooltip));
+    event_box_.signal_enter_notify_event().connect([this](GdkEventCrossing*) {
+      hovered_ = true;
+      return false;
+    });
+    event_box_.signal_leave_notify_event().connect([this](GdkEventCrossing*) {
+      hovered_ = false;
+      return false;
+    });
+  }
+  tooltip_callback_ = std::move(callback);
+  tooltip_markup_ = markup;
+  label_.set_has_tooltip(static_cast<bool>(tooltip_callback_));
+}
+
+bool ALabel::handleQueryTooltip(int, int, bool, const Glib::RefPtr<Gtk::Tooltip>& tooltip) {
+  if (!tooltip_callback_) {
+    return false;
+  }
+  auto text = tooltip_callback_();
+  if (text.empty()) {
+    return false;
+  }
+  if (tooltip_markup_) {
+    tooltip->set_markup(text);
+  } else {
+    tooltip->set_text(text);
   }
-  return "";
+  return true;
+}
+
+std::string ALabel::getIcon(uint16_t percentage, const std::string& alt, uint16_t max) {
+  return iconAt(config_view_.icons(alt), percentage, max);
+}
+
+std::string ALabel::getIcon(uint16_t percentage, const std::vector<std::string>& alts,
+                            uint16_t max) {
+  return iconAt(config_view_.icons(alts), percentage, max);
+}
+
+const std::string& ALabel::iconAt(const util::ConfigView::IconTable* icons, uint16_t percentage,
+                                  uint16_t max) {
+  static const std::string none;
+  if (icons == nullptr || icons->empty()) {
+    return none;
+  }
+  size_t size = icons->size();
+  size_t step = std::max<size_t>((max == 0 ? 100 : max) / size, 1);
+  return (*icons)[std::min<size_t>(percentage / step, size - 1)];
 }
 
 bool wabar::ALabel::handleToggle(GdkEventButton* const& e) {
@@ -126,30 +217,36 @@ bool wabar::ALabel::handleToggle(GdkEventButton* const& e) {
 }
 
 std::string ALabel::getState(uint8_t value, bool lesser) {
-  if (!config_["states"].isObject()) {
+  const auto& states = config_view_.states();
+  if (states.empty()) {
     return "";
   }
-  // Get current state
-  std::vector<std::pair<std::string, uint8_t>> states;
-  if (config_["states"].isObject()) {
-    for (auto it = config_["states"].begin(); it != config_["states"].end(); ++it) {
-      if (it->isUInt() && it.key().isString()) {
-        states.emplace_back(it.key().asString(), it->asUInt());
-      }
+  // The closest threshold reached, thresholds are sorted
+  const util::ConfigView::State* reached = nullptr;
+  if (lesser) {
+    auto it = std::ranges::lower_bound(states, value, {}, &util::ConfigView::State::threshold);
+    if (it != states.end()) {
+      reached = &*it;
+    }
+  } else {
+    auto it = std::ranges::upper_bound(states, value, {}, &util::ConfigView::State::threshold);
+    if (it != states.begin()) {
+      reached = &*std::prev(it);
     }
   }
-  // Sort states
-  std::sort(states.begin(), states.end(), [&lesser](auto& a, auto& b) {
-    return lesser ? a.second < b.second : a.second > b.second;
-  });
-  std::string valid_state;
-  for (auto const& state : states) {
-    if ((lesser ? value <= state.second : value >= state.second) && valid_state.empty()) {
-      label_.get_style_context()->add_class(state.first);
-      valid_state = state.first;
-    } else {
-      label_.get_style_context()->remove_class(state.first);
+  std::string valid_state = reached != nullptr ? reached->name : "";
+  // Only restyle on state transitions
+  auto style = label_.get_style_context();
+  bool changed = valid_state != state_class_ ||
+                 (!state_class_.empty() && !style->has_class(state_class_));
+  if (util::RenderStats::count(changed)) {
+    if (!state_class_.empty()) {
+      style->remove_class(state_class_);
+    }
+    if (!valid_state.empty()) {
+      style->add_class(valid_state);
     }
+    state_class_ = valid_state;
   }
   return valid_state;
 }
@@ -1,6 +1,7 @@
 #include "AModule.hpp"
 
 #include <fmt/format.h>
+#include <spdlog/spdlog.h>
 
 #include <util/command.hpp>
 
@@ -10,30 +11,23 @@ AModule::AModule(const Json::Value& config, const std::string& name, const std::
                  bool enable_click, bool enable_scroll)
     : name_(std::move(name)),
       config_(std::move(config)),
+      config_view_(config_, name_),
       isTooltip{config_["tooltip"].isBool() ? config_["tooltip"].asBool() : true},
       distance_scrolled_y_(0.0),
       distance_scrolled_x_(0.0) {
-  // Configure module action Map
-  const Json::Value actions{config_["actions"]};
-  for (Json::Value::const_iterator it = actions.begin(); it != actions.end(); ++it) {
-    if (it.key().isString() && it->isString())
-      if (eventActionMap_.count(it.key().asString()) == 0) {
-        eventActionMap_.insert({it.key().asString(), it->asString()});
-        enable_click = true;
-        enable_scroll = true;
-      } else
-        spdlog::warn("Dublicate action is ignored: {0}", it.key().asString());
-    else
-      spdlog::warn("Wrong actions section configuration. See config by index: {}", it.index());
+  // Module actions need the events they may be bound to
+  if (!config_view_.actions().empty()) {
+    enable_click = true;
+    enable_scroll = true;
   }
 
   // configure events' user commands
   // hasUserEvent is true if any element from eventMap_ is satisfying the condition in the lambda
   bool hasUserEvent =
-      std::find_if(eventMap_.cbegin(), eventMap_.cend(), [&config](const auto& eventEntry) {
+      std::find_if(eventMap_.cbegin(), eventMap_.cend(), [this](const auto& eventEntry) {
         // True if there is any non-release type event
         return eventEntry.first.second != GdkEventType::GDK_BUTTON_RELEASE &&
-               config[eventEntry.second].isString();
+               config_view_.command(eventEntry.second) != nullptr;
       }) != eventMap_.cend();
 
   if (enable_click || hasUserEvent) {
@@ -42,17 +36,17 @@ AModule::AModule(const Json::Value& config, const std::string& name, const std::
   }
 
   bool hasReleaseEvent =
-      std::find_if(eventMap_.cbegin(), eventMap_.cend(), [&config](const auto& eventEntry) {
+      std::find_if(eventMap_.cbegin(), eventMap_.cend(), [this](const auto& eventEntry) {
         // True if there is any non-release type event
         return eventEntry.first.second == GdkEventType::GDK_BUTTON_RELEASE &&
-               config[eventEntry.second].isString();
+               config_view_.command(eventEntry.second) != nullptr;
       }) != eventMap_.cend();
   if (hasReleaseEvent) {
     event_box_.add_events(Gdk::BUTTON_RELEASE_MASK);
     event_box_.signal_button_release_event().connect(sigc::mem_fun(*this, &AModule::handleRelease));
   }
-  if (config_["on-scroll-up"].isString() || config_["on-scroll-down"].isString() ||
-      config_["on-scroll-left"].isString() || config_["on-scroll-right"].isString() ||
+  if (config_view_.command("on-scroll-up") || config_view_.command("on-scroll-down") ||
+      config_view_.command("on-scroll-left") || config_view_.command("on-scroll-right") ||
       enable_scroll) {
     event_box_.add_events(Gdk::SCROLL_MASK | Gdk::SMOOTH_SCROLL_MASK);
     event_box_.signal_scroll_event().connect(sigc::mem_fun(*this, &AModule::handleScroll));
@@ -60,26 +54,41 @@ AModule::AModule(const Json::Value& config, const std::string& name, const std::
 }
 
 AModule::~AModule() {
-  for (const auto& pid : pid_) {
-    if (pid != -1) {
-      killpg(pid, SIGTERM);
+  for (const auto& child : children_) {
+    if (!child->exited()) {
+      killpg(child->pid(), SIGTERM);
     }
   }
 }
 
+void AModule::forkExec(const std::string& cmd) {
+  util::Metrics::Scope scope(metrics_);
+  auto child = util::command::forkExec(cmd, [name = name_, cmd](int status) {
+    if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
+      spdlog::debug("{}: '{}' exited with {}", name, cmd, WEXITSTATUS(status));
+    }
+  });
+  // Only keep the ones to terminate with the module
+  std::erase_if(children_, [](const auto& child) { return child->exited(); });
+  if (child) {
+    children_.push_back(std::move(child));
+  }
+}
+
 auto AModule::update() -> void {
   // Run user-provided update handler if configured
-  if (config_["on-update"].isString()) {
-    pid_.push_back(util::command::forkExec(config_["on-update"].asString()));
+  if (const auto* command = config_view_.command("on-update")) {
+    forkExec(*command);
   }
 }
 // Get mapping between event name and module action name
 // Then call overrided doAction in order to call appropriate module action
 auto AModule::doAction(const std::string& name) -> void {
   if (!name.empty()) {
-    const std::map<std::string, std::string>::const_iterator& recA{eventActionMap_.find(name)};
+    const auto& actions = config_view_.actions();
+    const std::map<std::string, std::string>::const_iterator& recA{actions.find(name)};
     // Call overrided action if derrived class has implemented it
-    if (recA != eventActionMap_.cend() && name != recA->second) this->doAction(recA->second);
+    if (recA != actions.cend() && name != recA->second) this->doAction(recA->second);
   }
 }
 
@@ -99,13 +108,9 @@ bool AModule::handleUserEvent(GdkEventButton* const& e) {
   }
   // Second call user scripts
   if (!format.empty()) {
-    if (config_[format].isString())
-      format = config_[format].asString();
-    else
-      format.clear();
-  }
-  if (!format.empty()) {
-    pid_.push_back(util::command::forkExec(format));
+    if (const auto* command = config_view_.command(format)) {
+      forkExec(*command);
+    }
   }
   dp.emit();
   return true;
@@ -189,8 +194,9 @@ bool AModule::handleScroll(GdkEventScroll* e) {
   // First call module actions
   this->AModule::doAction(eventName);
   // Second call user scripts
-  if (config_[eventName].isString())
-    pid_.push_back(util::command::forkExec(config_[eventName].asString()));
+  if (const auto* command = config_view_.command(eventName)) {
+    forkExec(*command);
+  }
 
   dp.emit();
   return true;
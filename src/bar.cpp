@@ -3,17 +3,32 @@
 #include <gtk-layer-shell.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <iterator>
+#include <optional>
+#include <set>
 #include <type_traits>
 
+#include "ALabel.hpp"
 #include "client.hpp"
 #include "factory.hpp"
 #include "group.hpp"
+#include "util/metrics.hpp"
+#include "util/profiler.hpp"
+#include "util/state_cache.hpp"
+#include "util/update_queue.hpp"
 
 #ifdef HAVE_SWAY
 #include "modules/sway/bar.hpp"
 #endif
 
 namespace wabar {
+static constexpr std::array<const char*, 3> MODULE_POSITIONS = {"modules-left", "modules-center",
+                                                                 "modules-right"};
+
 static constexpr const char* MIN_HEIGHT_MSG =
     "Requested height: {} is less than the minimum height: {} required by the modules";
 
@@ -277,6 +292,7 @@ wabar::Bar::Bar(struct wabar_output* w_output, const Json::Value& w_config)
 #endif
 
   setupWidgets();
+  util::UpdateQueue::inst().attach(window);
   window.show_all();
 
   if (spdlog::should_log(spdlog::level::debug)) {
@@ -290,8 +306,24 @@ wabar::Bar::Bar(struct wabar_output* w_output, const Json::Value& w_config)
   }
 }
 
+wabar::Bar::Bar(struct wabar_output* w_output, const Json::Value& w_config, Headless)
+    : output(w_output),
+      config(w_config),
+      surface(nullptr),
+      window{Gtk::WindowType::WINDOW_TOPLEVEL},
+      x_global(0),
+      y_global(0),
+      width_(0),
+      height_(0),
+      passthrough_(false) {
+  from_json(config["position"], position);
+  orientation = (position == Gtk::POS_LEFT || position == Gtk::POS_RIGHT)
+                    ? Gtk::ORIENTATION_VERTICAL
+                    : Gtk::ORIENTATION_HORIZONTAL;
+}
+
 /* Need to define it here because of forward declared members */
-wabar::Bar::~Bar() = default;
+wabar::Bar::~Bar() { util::UpdateQueue::inst().detach(window); }
 
 void wabar::Bar::setMode(const std::string& mode) {
   using namespace std::literals::string_literals;
@@ -416,7 +448,7 @@ void wabar::Bar::setVisible(bool value) {
 void wabar::Bar::toggle() { setVisible(!visible); }
 
 // Converting string to button code rn as to avoid doing it later
-void wabar::Bar::setupAltFormatKeyForModule(const std::string& module_name) {
+void wabar::Bar::setupAltFormatKeyForModule(Json::Value& config, const std::string& module_name) {
   if (config.isMember(module_name)) {
     Json::Value& module = config[module_name];
     if (module.isMember("format-alt")) {
@@ -444,7 +476,8 @@ void wabar::Bar::setupAltFormatKeyForModule(const std::string& module_name) {
   }
 }
 
-void wabar::Bar::setupAltFormatKeyForModuleList(const char* module_list_name) {
+void wabar::Bar::setupAltFormatKeyForModuleList(Json::Value& config,
+                                                 const char* module_list_name) {
   if (config.isMember(module_list_name)) {
     Json::Value& modules = config[module_list_name];
     for (const Json::Value& module_name : modules) {
@@ -454,17 +487,177 @@ void wabar::Bar::setupAltFormatKeyForModuleList(const char* module_list_name) {
           Json::Value& group_modules = config[ref]["modules"];
           for (const Json::Value& module_name : group_modules) {
             if (module_name.isString()) {
-              setupAltFormatKeyForModule(module_name.asString());
+              setupAltFormatKeyForModule(config, module_name.asString());
             }
           }
         } else {
-          setupAltFormatKeyForModule(ref);
+          setupAltFormatKeyForModule(config, ref);
         }
       }
     }
   }
 }
 
+namespace {
+bool isGroup(const std::string& ref) { return ref.compare(0, 6, "group/") == 0 && ref.size() > 6; }
+
+// Config keys of every module in the list, including group members
+void collectModuleRefs(const Json::Value& config, const Json::Value& list,
+                       std::set<std::string>& refs) {
+  if (!list.isArray()) {
+    return;
+  }
+  for (const auto& name : list) {
+    if (!name.isString() || !refs.insert(name.asString()).second) {
+      continue;
+    }
+    if (isGroup(name.asString())) {
+      collectModuleRefs(config, config[name.asString()]["modules"], refs);
+    }
+  }
+}
+
+// Whether a module, and all of its members for a group, is configured the same way
+bool sameModuleConfig(const Json::Value& a, const Json::Value& b, const std::string& ref) {
+  if (a[ref] != b[ref]) {
+    return false;
+  }
+  if (isGroup(ref)) {
+    for (const auto& name : a[ref]["modules"]) {
+      if (name.isString() && name.asString() != ref && !sameModuleConfig(a, b, name.asString())) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+}  // namespace
+
+bool wabar::Bar::reload(const Json::Value& new_config) {
+  auto updated = new_config;
+  for (const auto* pos : MODULE_POSITIONS) {
+    setupAltFormatKeyForModuleList(updated, pos);
+  }
+  const Json::Value& next = updated;
+  const Json::Value& current = config;
+
+  // Anything besides the modules needs a new bar
+  std::set<std::string> refs;
+  for (const auto* pos : MODULE_POSITIONS) {
+    collectModuleRefs(current, current[pos], refs);
+    collectModuleRefs(next, next[pos], refs);
+    refs.insert(pos);
+  }
+  auto current_settings = current;
+  auto next_settings = next;
+  for (const auto& ref : refs) {
+    current_settings.removeMember(ref);
+    next_settings.removeMember(ref);
+  }
+  if (current_settings != next_settings) {
+    return false;
+  }
+
+  // Take the running modules out of the boxes, keeping the unchanged ones for reuse
+  std::map<std::pair<std::string, std::string>, std::deque<ModuleEntry>> reusable;
+  std::vector<ModuleEntry> dropped;
+  for (const auto* pos : MODULE_POSITIONS) {
+    for (auto& entry : getModuleEntries(pos)) {
+      getModuleBox(pos).remove(*entry.module);
+      if (sameModuleConfig(current, next, entry.ref)) {
+        reusable[{pos, entry.ref}].push_back(std::move(entry));
+      } else {
+        dropped.push_back(std::move(entry));
+      }
+    }
+    getModuleEntries(pos).clear();
+  }
+
+  struct Slot {
+    std::string pos;
+    std::string ref;
+    std::optional<ModuleEntry> entry;
+  };
+  std::vector<Slot> layout;
+  for (const auto* pos : MODULE_POSITIONS) {
+    if (!next[pos].isArray()) {
+      continue;
+    }
+    for (const auto& name : next[pos]) {
+      if (!name.isString()) {
+        continue;
+      }
+      auto& pool = reusable[{pos, name.asString()}];
+      if (pool.empty()) {
+        layout.push_back({pos, name.asString(), std::nullopt});
+      } else {
+        layout.push_back({pos, name.asString(), std::move(pool.front())});
+        pool.pop_front();
+      }
+    }
+  }
+  for (auto& [key, pool] : reusable) {
+    std::move(pool.begin(), pool.end(), std::back_inserter(dropped));
+  }
+  reusable.clear();
+
+  // Stop the obsolete modules before touching the config they are reading
+  for (const auto& entry : dropped) {
+    std::erase_if(modules_all_, [&entry](const auto& module) {
+      return module == entry.module ||
+             std::find(entry.children.begin(), entry.children.end(), module) !=
+                 entry.children.end();
+    });
+  }
+  dropped.clear();
+
+  // Unchanged subtrees are left alone, the kept modules hold references into them
+  for (const auto& key : current.getMemberNames()) {
+    if (!next.isMember(key)) {
+      config.removeMember(key);
+    }
+  }
+  for (const auto& key : next.getMemberNames()) {
+    if (current[key] != next[key]) {
+      config[key] = next[key];
+    }
+  }
+
+  Factory factory(*this, config);
+  for (auto& slot : layout) {
+    auto& entries = getModuleEntries(slot.pos);
+    if (slot.entry) {
+      entries.push_back(std::move(*slot.entry));
+      continue;
+    }
+    auto count = entries.size();
+    addModule(factory, Json::Value(slot.ref), slot.pos, nullptr);
+    if (entries.size() > count) {
+      static_cast<Gtk::Widget&>(*entries.back().module).show_all();
+    }
+  }
+  packModules();
+  return true;
+}
+
+bool wabar::Bar::restoresState() const {
+  return config["restore-state"].isBool() ? config["restore-state"].asBool() : true;
+}
+
+void wabar::Bar::saveState() {
+  if (!restoresState()) {
+    return;
+  }
+  for (const auto* pos : MODULE_POSITIONS) {
+    for (const auto& entry : getModuleEntries(pos)) {
+      auto* label = dynamic_cast<ALabel*>(entry.module.get());
+      if (label != nullptr && !label->stale()) {
+        util::StateCache::inst().set(output->name, entry.ref, label->saveState());
+      }
+    }
+  }
+}
+
 void wabar::Bar::handleSignal(int signal) {
   for (auto& module : modules_all_) {
     module->refresh(signal);
@@ -476,51 +669,75 @@ void wabar::Bar::getModules(const Factory& factory, const std::string& pos,
   auto module_list = group ? config[pos]["modules"] : config[pos];
   if (module_list.isArray()) {
     for (const auto& name : module_list) {
-      try {
-        auto ref = name.asString();
-        AModule* module;
-
-        if (ref.compare(0, 6, "group/") == 0 && ref.size() > 6) {
-          auto hash_pos = ref.find('#');
-          auto id_name = ref.substr(6, hash_pos - 6);
-          auto class_name = hash_pos != std::string::npos ? ref.substr(hash_pos + 1) : "";
-
-          auto vertical = (group ? group->getBox().get_orientation() : box_.get_orientation()) ==
-                          Gtk::ORIENTATION_VERTICAL;
+      addModule(factory, name, pos, group);
+    }
+  }
+}
 
-          auto group_module = new wabar::Group(id_name, class_name, config[ref], vertical);
-          getModules(factory, ref, group_module);
-          module = group_module;
-        } else {
-          module = factory.makeModule(ref, pos);
-        }
+void wabar::Bar::addModule(const Factory& factory, const Json::Value& name,
+                            const std::string& pos, wabar::Group* group) {
+  try {
+    auto ref = name.asString();
+    AModule* module;
+    auto first_child = modules_all_.size();
+    auto metrics = util::Metrics::inst().add(ref, output->name);
+    // Threads started by the module are attributed to it
+    util::Metrics::Scope scope(metrics);
+
+    if (ref.compare(0, 6, "group/") == 0 && ref.size() > 6) {
+      auto hash_pos = ref.find('#');
+      auto id_name = ref.substr(6, hash_pos - 6);
+      auto class_name = hash_pos != std::string::npos ? ref.substr(hash_pos + 1) : "";
+
+      auto vertical = (group ? group->getBox().get_orientation() : box_.get_orientation()) ==
+                      Gtk::ORIENTATION_VERTICAL;
+
+      auto group_module = new wabar::Group(id_name, class_name, config[ref], vertical);
+      getModules(factory, ref, group_module);
+      module = group_module;
+    } else {
+      module = factory.makeModule(ref, pos);
+    }
 
-        std::shared_ptr<AModule> module_sp(module);
-        modules_all_.emplace_back(module_sp);
-        if (group) {
-          group->addWidget(*module);
+    std::shared_ptr<AModule> module_sp(module);
+    if (group) {
+      group->addWidget(*module);
+    } else {
+      // Group children were added to modules_all_ by the recursive call
+      std::vector<std::shared_ptr<AModule>> children(modules_all_.begin() + first_child,
+                                                     modules_all_.end());
+      getModuleEntries(pos).push_back({ref, module_sp, std::move(children)});
+    }
+    modules_all_.emplace_back(module_sp);
+    // Label modules show what they showed last time until they have data
+    auto* label = dynamic_cast<ALabel*>(module);
+    if (label != nullptr && group == nullptr && restoresState()) {
+      if (auto state = util::StateCache::inst().get(output->name, ref)) {
+        label->restoreState(*state);
+      }
+    }
+    module->dp.connect([module, label, ref, metrics, first = true]() mutable {
+      std::optional<util::Profiler::Span> span;
+      if (first) {
+        first = false;
+        span.emplace("AModule::update (first)", ref);
+      }
+      util::Metrics::Scope scope(metrics);
+      auto start = std::chrono::steady_clock::now();
+      try {
+        if (label != nullptr) {
+          label->updateOverRestored();
         } else {
-          if (pos == "modules-left") {
-            modules_left_.emplace_back(module_sp);
-          }
-          if (pos == "modules-center") {
-            modules_center_.emplace_back(module_sp);
-          }
-          if (pos == "modules-right") {
-            modules_right_.emplace_back(module_sp);
-          }
+          module->update();
         }
-        module->dp.connect([module, ref] {
-          try {
-            module->update();
-          } catch (const std::exception& e) {
-            spdlog::error("{}: {}", ref, e.what());
-          }
-        });
       } catch (const std::exception& e) {
-        spdlog::warn("module {}: {}", name.asString(), e.what());
+        spdlog::error("{}: {}", ref, e.what());
       }
-    }
+      metrics->recordUpdate(std::chrono::steady_clock::now() - start);
+    });
+    module->dp.setLatencyCallback([metrics](auto latency) { metrics->recordLatency(latency); });
+  } catch (const std::exception& e) {
+    spdlog::warn("module {}: {}", name.asString(), e.what());
   }
 }
 
@@ -535,23 +752,46 @@ auto wabar::Bar::setupWidgets() -> void {
   box_.pack_end(right_, false, false);
 
   // Convert to button code for every module that is used.
-  setupAltFormatKeyForModuleList("modules-left");
-  setupAltFormatKeyForModuleList("modules-right");
-  setupAltFormatKeyForModuleList("modules-center");
+  setupAltFormatKeyForModuleList(config, "modules-left");
+  setupAltFormatKeyForModuleList(config, "modules-right");
+  setupAltFormatKeyForModuleList(config, "modules-center");
 
   Factory factory(*this, config);
   getModules(factory, "modules-left");
   getModules(factory, "modules-center");
   getModules(factory, "modules-right");
-  for (auto const& module : modules_left_) {
-    left_.pack_start(*module, false, false);
+  packModules();
+}
+
+auto wabar::Bar::getModuleEntries(const std::string& pos) -> std::vector<ModuleEntry>& {
+  if (pos == "modules-left") {
+    return modules_left_;
+  }
+  if (pos == "modules-center") {
+    return modules_center_;
+  }
+  return modules_right_;
+}
+
+auto wabar::Bar::getModuleBox(const std::string& pos) -> Gtk::Box& {
+  if (pos == "modules-left") {
+    return left_;
+  }
+  if (pos == "modules-center") {
+    return center_;
+  }
+  return right_;
+}
+
+void wabar::Bar::packModules() {
+  for (auto const& entry : modules_left_) {
+    left_.pack_start(*entry.module, false, false);
   }
-  for (auto const& module : modules_center_) {
-    center_.pack_start(*module, false, false);
+  for (auto const& entry : modules_center_) {
+    center_.pack_start(*entry.module, false, false);
   }
-  std::reverse(modules_right_.begin(), modules_right_.end());
-  for (auto const& module : modules_right_) {
-    right_.pack_end(*module, false, false);
+  for (auto it = modules_right_.rbegin(); it != modules_right_.rend(); ++it) {
+    right_.pack_end(*it->module, false, false);
   }
 }
 
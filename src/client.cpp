@@ -1,14 +1,46 @@
 #include "client.hpp"
 
+#include <glibmm/main.h>
+#include <gtkmm/main.h>
 #include <gtk-layer-shell.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <chrono>
+#include <deque>
 #include <iostream>
 
 #include "gtkmm/icontheme.h"
 #include "idle-inhibit-unstable-v1-client-protocol.h"
+#include "util/cached_widget.hpp"
 #include "util/clara.hpp"
 #include "util/format.hpp"
+#include "util/metrics.hpp"
+#include "util/profiler.hpp"
+#include "util/push_server.hpp"
+#include "util/rt_signals.hpp"
+#include "util/scheduler.hpp"
+#include "util/state_cache.hpp"
+#include "util/update_queue.hpp"
+
+extern volatile bool reload;
+
+// Length of the startup trace written by --profile-startup
+static constexpr unsigned STARTUP_PROFILE_SECONDS = 10;
+// How often what the bars show is saved for the next start
+static constexpr unsigned STATE_SAVE_SECONDS = 60;
+
+static GPollFunc default_poll = nullptr;
+
+// Everything the main loop does happens between two polls, time it for the stall metrics
+static gint measuredPoll(GPollFD *fds, guint nfds, gint timeout) {
+  static auto last_return = std::chrono::steady_clock::now();
+  wabar::util::Metrics::inst().recordLoopIteration(std::chrono::steady_clock::now() -
+                                                   last_return);
+  auto res = default_poll(fds, nfds, timeout);
+  last_return = std::chrono::steady_clock::now();
+  return res;
+}
 
 wabar::Client *wabar::Client::inst() {
   static auto c = new Client();
@@ -76,6 +108,7 @@ void wabar::Client::handleOutputDone(void *data, struct zxdg_output_v1 * /*xdg_o
     if (output.xdg_output) {
       output.xdg_output.reset();
       spdlog::debug("Output detection done: {} ({})", output.name, output.identifier);
+      util::Profiler::Span span("Client::handleOutputDone", output.name);
 
       auto configs = client->getOutputConfigs(output);
       if (!configs.empty()) {
@@ -175,19 +208,31 @@ const std::string wabar::Client::getStyle(const std::string &style,
 };
 
 auto wabar::Client::setupCss(const std::string &css_file) -> void {
-  css_provider_ = Gtk::CssProvider::create();
-  style_context_ = Gtk::StyleContext::create();
-
-  // Load our css file, wherever that may be hiding
-  if (!css_provider_->load_from_path(css_file)) {
-    throw std::runtime_error("Can't open style file");
+  util::Profiler::Span span("Client::setupCss", css_file);
+  // Loaded before the current provider is replaced, which stays in place if this fails
+  auto provider = Gtk::CssProvider::create();
+  try {
+    // Load our css file, wherever that may be hiding
+    if (!provider->load_from_path(css_file)) {
+      throw std::runtime_error("Can't open style file");
+    }
+  } catch (const Glib::Error &e) {
+    throw std::runtime_error("Can't load style file: " + std::string(e.what()));
   }
   // there's always only one screen
-  style_context_->add_provider_for_screen(Gdk::Screen::get_default(), css_provider_,
-                                          GTK_STYLE_PROVIDER_PRIORITY_USER);
+  auto screen = Gdk::Screen::get_default();
+  if (css_provider_) {
+    Gtk::StyleContext::remove_provider_for_screen(screen, css_provider_);
+  }
+  if (!style_context_) {
+    style_context_ = Gtk::StyleContext::create();
+  }
+  style_context_->add_provider_for_screen(screen, provider, GTK_STYLE_PROVIDER_PRIORITY_USER);
+  css_provider_ = provider;
 }
 
 void wabar::Client::bindInterfaces() {
+  util::Profiler::Span span("Client::bindInterfaces");
   registry = wl_display_get_registry(wl_display);
   static const struct wl_registry_listener registry_listener = {
       .global = handleGlobal,
@@ -213,20 +258,55 @@ void wabar::Client::bindInterfaces() {
       sigc::mem_fun(*this, &Client::handleMonitorRemoved));
 }
 
+int wabar::Client::runHeadless(int argc, char *argv[], const std::string &config_opt,
+                               HeadlessHost::Options options) {
+  // No Wayland needed, but GTK still wants a display to lay out and draw widgets
+  if (!gtk_init_check(&argc, &argv)) {
+    spdlog::error("Can't open a display, run under Xvfb or with GDK_BACKEND=broadway");
+    return 1;
+  }
+  Gtk::Main::init_gtkmm_internals();
+  try {
+    config.load(config_opt);
+  } catch (const std::exception &e) {
+    spdlog::warn("{}, running the modules with their defaults", e.what());
+  }
+  auto bar_config = config.getConfig();
+  if (bar_config.isArray()) {
+    bar_config = bar_config.empty() ? Json::Value(Json::objectValue) : bar_config[0];
+  }
+  return HeadlessHost(bar_config, std::move(options)).run();
+}
+
 int wabar::Client::main(int argc, char *argv[]) {
   bool show_help = false;
   bool show_version = false;
+  bool show_stats = false;
   std::string config_opt;
   std::string style_opt;
   std::string log_level;
+  std::string profile_opt;
+  bool headless = false;
+  HeadlessHost::Options headless_opt;
+  auto interval_ms = static_cast<unsigned>(headless_opt.interval.count());
   auto cli = clara::detail::Help(show_help) |
              clara::detail::Opt(show_version)["-v"]["--version"]("Show version") |
+             clara::detail::Opt(show_stats)["--stats"](
+                 "Print the runtime metrics of the running instances") |
              clara::detail::Opt(config_opt, "config")["-c"]["--config"]("Config path") |
              clara::detail::Opt(style_opt, "style")["-s"]["--style"]("Style path") |
              clara::detail::Opt(
                  log_level,
                  "trace|debug|info|warning|error|critical|off")["-l"]["--log-level"]("Log level") |
-             clara::detail::Opt(bar_id, "id")["-b"]["--bar"]("Bar id");
+             clara::detail::Opt(bar_id, "id")["-b"]["--bar"]("Bar id") |
+             clara::detail::Opt(profile_opt, "file")["--profile-startup"](
+                 "Write a Chrome trace of the startup to file") |
+             clara::detail::Opt(headless)["--headless"](
+                 "Run the given modules offscreen and print their update times") |
+             clara::detail::Opt(headless_opt.modules, "module")["-m"]["--module"](
+                 "Module to run headless, can be repeated") |
+             clara::detail::Opt(headless_opt.ticks, "count")["--ticks"]("Headless updates") |
+             clara::detail::Opt(interval_ms, "ms")["--interval"]("Time between headless updates");
   auto res = cli.parse(clara::detail::Args(argc, argv));
   if (!res) {
     spdlog::error("Error in command line: {}", res.errorMessage());
@@ -240,9 +320,19 @@ int wabar::Client::main(int argc, char *argv[]) {
     std::cout << "Wabar v" << VERSION << std::endl;
     return 0;
   }
+  if (show_stats) {
+    return util::Metrics::query();
+  }
   if (!log_level.empty()) {
     spdlog::set_level(spdlog::level::from_str(log_level));
   }
+  if (!profile_opt.empty()) {
+    util::Profiler::inst().start(profile_opt);
+  }
+  if (headless) {
+    headless_opt.interval = std::chrono::milliseconds(interval_ms);
+    return runHeadless(argc, argv, config_opt, std::move(headless_opt));
+  }
   gtk_app = Gtk::Application::create(argc, argv, "fr.arouillard.wabar",
                                      Gio::APPLICATION_HANDLES_COMMAND_LINE);
 
@@ -282,14 +372,135 @@ int wabar::Client::main(int argc, char *argv[]) {
     }
   }
 
+  applyGlobalSettings();
+  util::Metrics::inst().serve();
+  util::PushServer::inst().serve();
+  util::RtSignals::inst().start([](int signal) {
+    for (auto &bar : Client::inst()->bars) {
+      bar->handleSignal(signal);
+    }
+  });
+  if (default_poll == nullptr) {
+    default_poll = g_main_context_get_poll_func(nullptr);
+    g_main_context_set_poll_func(nullptr, measuredPoll);
+  }
+  reload_dp_ = std::make_unique<Glib::Dispatcher>();
+  reload_dp_->connect(sigc::mem_fun(*this, &Client::reload));
+
   bindInterfaces();
+  if (util::Profiler::inst().enabled()) {
+    // Leave the modules time for their first update, slow ones are cut off
+    Glib::signal_timeout().connect_seconds_once([] { util::Profiler::inst().finish(); },
+                                                STARTUP_PROFILE_SECONDS);
+  }
+  auto state_save = Glib::signal_timeout().connect_seconds(
+      [this] {
+        saveState();
+        return true;
+      },
+      STATE_SAVE_SECONDS);
   gtk_app->hold();
   gtk_app->run();
+  state_save.disconnect();
+  saveState();
+  util::Profiler::inst().finish();
+  spdlog::debug("Widget mutations: {} applied, {} skipped", util::RenderStats::applied.load(),
+                util::RenderStats::skipped.load());
   m_cssReloadHelper.reset();  // stop watching css file
   bars.clear();
   return 0;
 }
 
+void wabar::Client::applyGlobalSettings() {
+  // The scheduler and the update queue are shared by every bar, the first bar's settings win
+  const auto &m_config = config.getConfig();
+  const auto &global_config = m_config.isArray() && !m_config.empty() ? m_config[0] : m_config;
+  if (global_config.isObject() && global_config["timer-slack"].isUInt()) {
+    util::Scheduler::inst().setSlack(
+        std::chrono::milliseconds(global_config["timer-slack"].asUInt()));
+  }
+  if (global_config.isObject() && global_config["max-fps"].isUInt()) {
+    util::UpdateQueue::inst().setMaxFps(global_config["max-fps"].asUInt());
+  }
+}
+
+void wabar::Client::saveState() {
+  for (const auto &bar : bars) {
+    bar->saveState();
+  }
+  util::StateCache::inst().save();
+}
+
+void wabar::Client::requestReload() {
+  if (reload_dp_) {
+    reload_dp_->emit();
+  } else {
+    ::reload = true;
+    reset();
+  }
+}
+
+static bool reloadsStyleOnChange(const Json::Value &config) {
+  if (config.isArray()) {
+    return std::any_of(config.begin(), config.end(), [](const auto &conf) {
+      return conf["reload_style_on_change"].asBool();
+    });
+  }
+  return config.isObject() && config["reload_style_on_change"].asBool();
+}
+
+void wabar::Client::reload() {
+  Config next;
+  try {
+    next.load(config.getConfigFile());
+    // Swapped in only once it loaded, a broken style keeps the current one
+    setupCss(m_cssFile);
+  } catch (const std::exception &e) {
+    spdlog::error("Failed to reload the config, keeping the current one: {}", e.what());
+    return;
+  }
+  if (reloadsStyleOnChange(next.getConfig()) != reloadsStyleOnChange(config.getConfig())) {
+    // The style watcher is only set up on startup
+    ::reload = true;
+    reset();
+    return;
+  }
+  config = std::move(next);
+  applyGlobalSettings();
+
+  try {
+    std::vector<std::unique_ptr<Bar>> bars_next;
+    for (auto &output : outputs_) {
+      if (output.xdg_output) {
+        // Bars are created with the new config once the output is done
+        continue;
+      }
+      std::deque<std::unique_ptr<Bar>> current;
+      for (auto &bar : bars) {
+        if (bar && bar->output == &output) {
+          current.push_back(std::move(bar));
+        }
+      }
+      for (const auto &bar_config : getOutputConfigs(output)) {
+        if (!current.empty()) {
+          auto bar = std::move(current.front());
+          current.pop_front();
+          if (bar->reload(bar_config)) {
+            bars_next.push_back(std::move(bar));
+            continue;
+          }
+        }  // A bar with changed settings is destroyed before its replacement is created
+        bars_next.push_back(std::make_unique<Bar>(&output, bar_config));
+      }
+    }
+    bars = std::move(bars_next);
+  } catch (const std::exception &e) {
+    spdlog::error("Incremental reload failed, restarting: {}", e.what());
+    ::reload = true;
+    reset();
+  }
+}
+
 void wabar::Client::reset() {
   gtk_app->quit();
   // delete signal handler for css changes
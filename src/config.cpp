@@ -9,6 +9,7 @@
 #include <stdexcept>
 
 #include "util/json.hpp"
+#include "util/profiler.hpp"
 
 namespace fs = std::filesystem;
 
@@ -69,6 +70,7 @@ void Config::setupConfig(Json::Value &dst, const std::string &config_file, int d
   if (depth > 100) {
     throw std::runtime_error("Aborting due to likely recursive include in config files");
   }
+  util::Profiler::Span span("Config::setupConfig", config_file);
   std::ifstream file(config_file);
   if (!file.is_open()) {
     throw std::runtime_error("Can't open config file");
@@ -156,6 +158,7 @@ bool isValidOutput(const Json::Value &config, const std::string &name,
 }
 
 void Config::load(const std::string &config) {
+  util::Profiler::Span span("Config::load");
   auto file = config.empty() ? findConfigPath({"config", "config.jsonc"}) : config;
   if (!file) {
     throw std::runtime_error("Missing required resource files");
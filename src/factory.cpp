@@ -109,11 +109,13 @@
 #include "modules/image.hpp"
 #include "modules/temperature.hpp"
 #include "modules/user.hpp"
+#include "util/profiler.hpp"
 
 wabar::Factory::Factory(const Bar& bar, const Json::Value& config) : bar_(bar), config_(config) {}
 
 wabar::AModule* wabar::Factory::makeModule(const std::string& name,
                                              const std::string& pos) const {
+  util::Profiler::Span span("Factory::makeModule", name);
   try {
     auto hash_pos = name.find('#');
     auto ref = name.substr(0, hash_pos);
@@ -0,0 +1,155 @@
+#include "headless.hpp"
+
+#include <cairomm/context.h>
+#include <cairomm/surface.h>
+#include <glibmm/main.h>
+#include <json/writer.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <iostream>
+
+#include "factory.hpp"
+#include "util/histogram.hpp"
+
+namespace wabar {
+
+using clock = std::chrono::steady_clock;
+
+static uint64_t elapsedUs(clock::time_point begin, clock::time_point end) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
+}
+
+// Lay the widget out and draw it, as the bar would on the next frame
+static void render(Gtk::Widget &widget) {
+  Gtk::Requisition minimum;
+  Gtk::Requisition natural;
+  widget.get_preferred_size(minimum, natural);
+  Gtk::Allocation allocation(0, 0, std::max(natural.width, 1), std::max(natural.height, 1));
+  widget.size_allocate(allocation);
+  auto surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, allocation.get_width(),
+                                             allocation.get_height());
+  auto cr = Cairo::Context::create(surface);
+  widget.draw(cr);
+}
+
+// Markup of every visible label, in widget tree order
+static void collectLabels(Gtk::Widget &widget, Json::Value &labels) {
+  if (!widget.get_visible()) {
+    return;
+  }
+  if (auto *label = dynamic_cast<Gtk::Label *>(&widget); label != nullptr) {
+    labels.append(label->get_label().raw());
+    return;
+  }
+  if (auto *container = dynamic_cast<Gtk::Container *>(&widget); container != nullptr) {
+    for (auto *child : container->get_children()) {
+      collectLabels(*child, labels);
+    }
+  }
+}
+
+HeadlessHost::HeadlessHost(const Json::Value &config, Options options)
+    : options_(std::move(options)) {
+  output_.name = "HEADLESS-1";
+  output_.identifier = "headless";
+  if (auto display = Gdk::Display::get_default(); display && display->get_n_monitors() > 0) {
+    output_.monitor = display->get_monitor(0);
+  }
+  bar_ = std::make_unique<Bar>(&output_, config, Bar::Headless{});
+  box_.set_orientation(bar_->orientation);
+  window_.add(box_);
+
+  Factory factory(*bar_, bar_->config);
+  // Slots below point into the vector
+  modules_.reserve(options_.modules.size());
+  for (const auto &name : options_.modules) {
+    try {
+      std::shared_ptr<AModule> module(factory.makeModule(name, "modules-left"));
+      box_.pack_start(*module, false, false);
+      auto &hosted = modules_.emplace_back(Hosted{name, module});
+      // The runner drives the updates, only take note that data came in
+      module->dp.connect([&hosted] { hosted.emitted = true; });
+    } catch (const std::exception &e) {
+      spdlog::error("{}", e.what());
+    }
+  }
+  window_.show_all();
+}
+
+HeadlessHost::~HeadlessHost() = default;
+
+int HeadlessHost::run() {
+  if (modules_.size() != options_.modules.size()) {
+    return 1;
+  }
+  waitForData(std::chrono::seconds(1));
+
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  std::vector<std::pair<util::Histogram, util::Histogram>> stats(modules_.size());
+  for (unsigned tick = 0; tick < options_.ticks; ++tick) {
+    if (tick != 0 && options_.interval.count() > 0) {
+      iterate(options_.interval);
+    }
+    for (size_t i = 0; i < modules_.size(); ++i) {
+      auto &hosted = modules_[i];
+      auto &widget = static_cast<Gtk::Widget &>(*hosted.module);
+      auto begin = clock::now();
+      try {
+        hosted.module->update();
+      } catch (const std::exception &e) {
+        spdlog::error("{}: {}", hosted.name, e.what());
+      }
+      auto updated = clock::now();
+      render(widget);
+      auto rendered = clock::now();
+
+      Json::Value line;
+      line["module"] = hosted.name;
+      line["tick"] = tick;
+      line["update_us"] = static_cast<Json::UInt64>(elapsedUs(begin, updated));
+      line["render_us"] = static_cast<Json::UInt64>(elapsedUs(updated, rendered));
+      collectLabels(widget, line["labels"] = Json::Value(Json::arrayValue));
+      std::cout << Json::writeString(builder, line) << '\n';
+      stats[i].first.record(elapsedUs(begin, updated));
+      stats[i].second.record(elapsedUs(updated, rendered));
+    }
+  }
+
+  for (size_t i = 0; i < modules_.size(); ++i) {
+    Json::Value summary;
+    summary["module"] = modules_[i].name;
+    summary["ticks"] = options_.ticks;
+    summary["update_us"] = stats[i].first.toJson();
+    summary["render_us"] = stats[i].second.toJson();
+    std::cout << Json::writeString(builder, summary) << '\n';
+  }
+  std::cout << std::flush;
+  return 0;
+}
+
+void HeadlessHost::waitForData(std::chrono::milliseconds timeout) {
+  auto loop = Glib::MainLoop::create();
+  auto deadline = clock::now() + timeout;
+  auto check = Glib::signal_timeout().connect(
+      [&] {
+        auto ready = std::all_of(modules_.begin(), modules_.end(),
+                                 [](const auto &hosted) { return hosted.emitted; });
+        if (ready || clock::now() >= deadline) {
+          loop->quit();
+        }
+        return true;
+      },
+      10);
+  loop->run();
+  check.disconnect();
+}
+
+void HeadlessHost::iterate(std::chrono::milliseconds duration) {
+  auto loop = Glib::MainLoop::create();
+  Glib::signal_timeout().connect_once([&loop] { loop->quit(); }, duration.count());
+  loop->run();
+}
+
+}  // namespace wabar
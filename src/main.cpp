@@ -3,13 +3,11 @@
 #include <sys/wait.h>
 
 #include <csignal>
-#include <list>
-#include <mutex>
 
 #include "client.hpp"
+#include "util/child_supervisor.hpp"
+#include "util/rt_signals.hpp"
 
-std::mutex reap_mtx;
-std::list<pid_t> reap;
 volatile bool reload;
 
 void* signalThread(void* args) {
@@ -28,16 +26,8 @@ void* signalThread(void* args) {
     switch (signum) {
       case SIGCHLD:
         spdlog::debug("Received SIGCHLD in signalThread");
-        if (!reap.empty()) {
-          reap_mtx.lock();
-          for (auto it = reap.begin(); it != reap.end(); ++it) {
-            if (waitpid(*it, nullptr, WNOHANG) == *it) {
-              spdlog::debug("Reaped child with PID: {}", *it);
-              it = reap.erase(it);
-            }
-          }
-          reap_mtx.unlock();
-        }
+        // Only children without a pidfd, the others are reaped on the reactor thread
+        wabar::util::ChildSupervisor::inst().reapPolled();
         break;
       default:
         spdlog::debug("Received signal with number {}, but not handling", signum);
@@ -81,8 +71,7 @@ int main(int argc, char* argv[]) {
 
     std::signal(SIGUSR2, [](int /*signal*/) {
       spdlog::info("Reloading...");
-      reload = true;
-      wabar::Client::inst()->reset();
+      wabar::Client::inst()->requestReload();
     });
 
     std::signal(SIGINT, [](int /*signal*/) {
@@ -91,13 +80,8 @@ int main(int argc, char* argv[]) {
       wabar::Client::inst()->reset();
     });
 
-    for (int sig = SIGRTMIN + 1; sig <= SIGRTMAX; ++sig) {
-      std::signal(sig, [](int sig) {
-        for (auto& bar : wabar::Client::inst()->bars) {
-          bar->handleSignal(sig);
-        }
-      });
-    }
+    // Handled by the main loop once it runs
+    wabar::util::RtSignals::block();
     startSignalThread();
 
     auto ret = 0;
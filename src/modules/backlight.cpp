@@ -19,6 +19,20 @@ wabar::modules::Backlight::Backlight(const std::string &id, const Json::Value &c
       backend(interval_, [this] { dp.emit(); }) {
   dp.emit();
 
+  if (tooltipEnabled()) {
+    setTooltipCallback([this]() -> std::string {
+      std::string tooltip_format;
+      if (config_["tooltip-format"].isString()) {
+        tooltip_format = config_["tooltip-format"].asString();
+      }
+      if (desc_.empty() || tooltip_format.empty()) {
+        return desc_;
+      }
+      return fmt::format(fmt::runtime(tooltip_format), fmt::arg("percent", percent_),
+                         fmt::arg("icon", getIcon(percent_)));
+    });
+  }
+
   // Set up scroll handler
   event_box_.add_events(Gdk::SCROLL_MASK | Gdk::SMOOTH_SCROLL_MASK);
   event_box_.signal_scroll_event().connect(sigc::mem_fun(*this, &Backlight::handleScroll));
@@ -42,19 +56,8 @@ auto wabar::modules::Backlight::update() -> void {
                                      fmt::arg("icon", getIcon(percent)));
       label_.set_markup(desc);
       getState(percent);
-      if (tooltipEnabled()) {
-        std::string tooltip_format;
-        if (config_["tooltip-format"].isString()) {
-          tooltip_format = config_["tooltip-format"].asString();
-        }
-        if (!tooltip_format.empty()) {
-          label_.set_tooltip_text(fmt::format(fmt::runtime(tooltip_format),
-                                              fmt::arg("percent", percent),
-                                              fmt::arg("icon", getIcon(percent))));
-        } else {
-          label_.set_tooltip_text(desc);
-        }
-      }
+      percent_ = percent;
+      desc_ = std::move(desc);
     } else {
       event_box_.hide();
     }
@@ -63,6 +66,7 @@ auto wabar::modules::Backlight::update() -> void {
       return;
     }
     label_.set_markup("");
+    desc_.clear();
   }
   backend.set_previous_best_device(best);
   previous_format_ = format_;
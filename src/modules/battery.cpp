@@ -9,6 +9,15 @@
 #include <iostream>
 wabar::modules::Battery::Battery(const std::string& id, const Bar& bar, const Json::Value& config)
     : ALabel(config, "battery", id, "{capacity}%", 60), bar_(bar) {
+  if (tooltipEnabled()) {
+    // The tooltip falls back on the time left
+    fields_.add("{timeTo}");
+    setTooltipCallback([this] {
+      return fmt::format(fmt::runtime(tooltip_.format), fmt::arg("timeTo", tooltip_.time_to),
+                         fmt::arg("power", tooltip_.power), fmt::arg("capacity", tooltip_.capacity),
+                         fmt::arg("time", tooltip_.time));
+    });
+  }
 #if defined(__linux__)
   battery_watch_fd_ = inotify_init1(IN_CLOEXEC);
   if (battery_watch_fd_ == -1) {
@@ -30,6 +39,7 @@ wabar::modules::Battery::Battery(const std::string& id, const Bar& bar, const Js
 }
 
 wabar::modules::Battery::~Battery() {
+  timer_.stop();
 #if defined(__linux__)
   std::lock_guard<std::mutex> guard(battery_list_mutex_);
 
@@ -52,18 +62,14 @@ wabar::modules::Battery::~Battery() {
 
 void wabar::modules::Battery::worker() {
 #if defined(__FreeBSD__)
-  thread_timer_ = [this] {
-    dp.emit();
-    thread_timer_.sleep_for(interval_);
-  };
+  timer_.start(interval_, [this] { dp.emit(); });
 #else
-  thread_timer_ = [this] {
+  timer_.start(interval_, [this] {
     // Make sure we eventually update the list of batteries even if we miss an
     // inotify event for some reason
     refreshBatteries();
     dp.emit();
-    thread_timer_.sleep_for(interval_);
-  };
+  });
   thread_ = [this] {
     struct inotify_event event = {0};
     int nbytes = read(battery_watch_fd_, &event, sizeof(event));
@@ -644,50 +650,59 @@ auto wabar::modules::Battery::update() -> void {
   auto format = format_;
   auto state = getState(capacity, true);
   setBarClass(state);
-  auto time_remaining_formatted = formatTimeRemaining(time_remaining);
+  auto time_remaining_formatted = shows("time") || shows("timeTo")
+                                      ? formatTimeRemaining(time_remaining)
+                                      : std::string();
   if (tooltipEnabled()) {
-    std::string tooltip_text_default;
-    std::string tooltip_format = "{timeTo}";
     if (time_remaining != 0) {
       std::string time_to = std::string("Time to ") + ((time_remaining > 0) ? "empty" : "full");
-      tooltip_text_default = time_to + ": " + time_remaining_formatted;
+      tooltip_.time_to = time_to + ": " + time_remaining_formatted;
     } else {
-      tooltip_text_default = status_pretty;
+      tooltip_.time_to = status_pretty;
     }
-    if (!state.empty() && config_["tooltip-format-" + status + "-" + state].isString()) {
-      tooltip_format = config_["tooltip-format-" + status + "-" + state].asString();
-    } else if (config_["tooltip-format-" + status].isString()) {
-      tooltip_format = config_["tooltip-format-" + status].asString();
-    } else if (!state.empty() && config_["tooltip-format-" + state].isString()) {
-      tooltip_format = config_["tooltip-format-" + state].asString();
+    const auto* status_state_tooltip =
+        state.empty() ? nullptr : config_view_.tooltipFormat(status + "-" + state);
+    if (status_state_tooltip != nullptr) {
+      tooltip_.format = *status_state_tooltip;
+    } else if (const auto* configured = config_view_.tooltipFormat(status)) {
+      tooltip_.format = *configured;
+    } else if (const auto* configured = config_view_.tooltipFormat(state)) {
+      tooltip_.format = *configured;
     } else if (config_["tooltip-format"].isString()) {
-      tooltip_format = config_["tooltip-format"].asString();
+      tooltip_.format = config_["tooltip-format"].asString();
+    } else {
+      tooltip_.format = "{timeTo}";
     }
-    label_.set_tooltip_text(fmt::format(fmt::runtime(tooltip_format),
-                                        fmt::arg("timeTo", tooltip_text_default),
-                                        fmt::arg("power", power), fmt::arg("capacity", capacity),
-                                        fmt::arg("time", time_remaining_formatted)));
+    tooltip_.power = power;
+    tooltip_.capacity = capacity;
+    tooltip_.time = time_remaining_formatted;
   }
   if (!old_status_.empty()) {
     label_.get_style_context()->remove_class(old_status_);
   }
   label_.get_style_context()->add_class(status);
   old_status_ = status;
-  if (!state.empty() && config_["format-" + status + "-" + state].isString()) {
-    format = config_["format-" + status + "-" + state].asString();
-  } else if (config_["format-" + status].isString()) {
-    format = config_["format-" + status].asString();
-  } else if (!state.empty() && config_["format-" + state].isString()) {
-    format = config_["format-" + state].asString();
+  const auto* status_state_format =
+      state.empty() ? nullptr : config_view_.format(status + "-" + state);
+  if (status_state_format != nullptr) {
+    format = *status_state_format;
+  } else if (const auto* configured = config_view_.format(status)) {
+    format = *configured;
+  } else if (const auto* configured = config_view_.format(state)) {
+    format = *configured;
   }
   if (format.empty()) {
     event_box_.hide();
   } else {
     event_box_.show();
-    auto icons = std::vector<std::string>{status + "-" + state, status, state};
-    label_.set_markup(fmt::format(
-        fmt::runtime(format), fmt::arg("capacity", capacity), fmt::arg("power", power),
-        fmt::arg("icon", getIcon(capacity, icons)), fmt::arg("time", time_remaining_formatted)));
+    std::string icon;
+    if (shows("icon")) {
+      auto icons = std::vector<std::string>{status + "-" + state, status, state};
+      icon = getIcon(capacity, icons);
+    }
+    label_.set_markup(fmt::format(fmt::runtime(format), fmt::arg("capacity", capacity),
+                                  fmt::arg("power", power), fmt::arg("icon", icon),
+                                  fmt::arg("time", time_remaining_formatted)));
   }
   // Call parent update
   ALabel::update();
@@ -123,6 +123,9 @@ wabar::modules::Bluetooth::Bluetooth(const std::string& id, const Json::Value& c
 #endif
   }
 
+  if (tooltipEnabled()) {
+    setTooltipCallback([this] { return tooltipText(); });
+  }
   dp.emit();
 }
 
@@ -151,7 +154,6 @@ auto wabar::modules::Bluetooth::update() -> void {
   }
 
   std::string state;
-  std::string tooltip_format;
   if (cur_controller_) {
     if (!cur_controller_->powered)
       state = "off";
@@ -176,14 +178,14 @@ auto wabar::modules::Bluetooth::update() -> void {
   std::string icon = getIcon(0, state);
 #endif
   std::string icon_label = icon;
-  std::string icon_tooltip = icon;
+  tooltip_icon_ = icon;
 
   if (!alt_) {
     if (battery_available && config_["format-connected-battery"].isString()) {
       format_ = config_["format-connected-battery"].asString();
       icon_label = getIcon(cur_focussed_device_.battery_percentage.value_or(0));
-    } else if (config_["format-" + state].isString()) {
-      format_ = config_["format-" + state].asString();
+    } else if (const auto* configured = config_view_.format(state)) {
+      format_ = *configured;
     } else if (config_["format"].isString()) {
       format_ = config_["format"].asString();
     } else {
@@ -191,12 +193,14 @@ auto wabar::modules::Bluetooth::update() -> void {
     }
   }
   if (battery_available && config_["tooltip-format-connected-battery"].isString()) {
-    tooltip_format = config_["tooltip-format-connected-battery"].asString();
-    icon_tooltip = getIcon(cur_focussed_device_.battery_percentage.value_or(0));
-  } else if (config_["tooltip-format-" + state].isString()) {
-    tooltip_format = config_["tooltip-format-" + state].asString();
+    tooltip_format_ = config_["tooltip-format-connected-battery"].asString();
+    tooltip_icon_ = getIcon(cur_focussed_device_.battery_percentage.value_or(0));
+  } else if (const auto* configured = config_view_.tooltipFormat(state)) {
+    tooltip_format_ = *configured;
   } else if (config_["tooltip-format"].isString()) {
-    tooltip_format = config_["tooltip-format"].asString();
+    tooltip_format_ = config_["tooltip-format"].asString();
+  } else {
+    tooltip_format_.clear();
   }
 
   auto update_style_context = [this](const std::string& style_class, bool in_next_state) {
@@ -233,53 +237,55 @@ auto wabar::modules::Bluetooth::update() -> void {
                  cur_focussed_device_.battery_percentage.value_or(0))));
   }
 
-  if (tooltipEnabled()) {
-    bool tooltip_enumerate_connections_ = config_["tooltip-format-enumerate-connected"].isString();
-    bool tooltip_enumerate_connections_battery_ =
-        config_["tooltip-format-enumerate-connected-battery"].isString();
-    if (tooltip_enumerate_connections_ || tooltip_enumerate_connections_battery_) {
-      std::stringstream ss;
-      for (DeviceInfo dev : connected_devices_) {
-        if ((tooltip_enumerate_connections_battery_ && dev.battery_percentage.has_value()) ||
-            tooltip_enumerate_connections_) {
-          ss << "\n";
-          std::string enumerate_format;
-          std::string enumerate_icon;
-          if (tooltip_enumerate_connections_battery_ && dev.battery_percentage.has_value()) {
-            enumerate_format = config_["tooltip-format-enumerate-connected-battery"].asString();
-            enumerate_icon = getIcon(dev.battery_percentage.value_or(0));
-          } else {
-            enumerate_format = config_["tooltip-format-enumerate-connected"].asString();
-          }
-          ss << fmt::format(
-              fmt::runtime(enumerate_format), fmt::arg("device_address", dev.address),
-              fmt::arg("device_address_type", dev.address_type),
-              fmt::arg("device_alias", dev.alias), fmt::arg("icon", enumerate_icon),
-              fmt::arg("device_battery_percentage", dev.battery_percentage.value_or(0)));
+  // Call parent update
+  ALabel::update();
+}
+
+// Built when the tooltip shows, from the devices of the last update
+std::string wabar::modules::Bluetooth::tooltipText() {
+  bool tooltip_enumerate_connections_ = config_["tooltip-format-enumerate-connected"].isString();
+  bool tooltip_enumerate_connections_battery_ =
+      config_["tooltip-format-enumerate-connected-battery"].isString();
+  std::string device_enumerate;
+  if (tooltip_enumerate_connections_ || tooltip_enumerate_connections_battery_) {
+    std::stringstream ss;
+    for (DeviceInfo dev : connected_devices_) {
+      if ((tooltip_enumerate_connections_battery_ && dev.battery_percentage.has_value()) ||
+          tooltip_enumerate_connections_) {
+        ss << "\n";
+        std::string enumerate_format;
+        std::string enumerate_icon;
+        if (tooltip_enumerate_connections_battery_ && dev.battery_percentage.has_value()) {
+          enumerate_format = config_["tooltip-format-enumerate-connected-battery"].asString();
+          enumerate_icon = getIcon(dev.battery_percentage.value_or(0));
+        } else {
+          enumerate_format = config_["tooltip-format-enumerate-connected"].asString();
         }
-      }
-      device_enumerate_ = ss.str();
-      // don't start the connected devices text with a new line
-      if (!device_enumerate_.empty()) {
-        device_enumerate_.erase(0, 1);
+        ss << fmt::format(
+            fmt::runtime(enumerate_format), fmt::arg("device_address", dev.address),
+            fmt::arg("device_address_type", dev.address_type),
+            fmt::arg("device_alias", dev.alias), fmt::arg("icon", enumerate_icon),
+            fmt::arg("device_battery_percentage", dev.battery_percentage.value_or(0)));
       }
     }
-    label_.set_tooltip_text(fmt::format(
-        fmt::runtime(tooltip_format), fmt::arg("status", state_),
-        fmt::arg("num_connections", connected_devices_.size()),
-        fmt::arg("controller_address", cur_controller_ ? cur_controller_->address : "null"),
-        fmt::arg("controller_address_type",
-                 cur_controller_ ? cur_controller_->address_type : "null"),
-        fmt::arg("controller_alias", cur_controller_ ? cur_controller_->alias : "null"),
-        fmt::arg("device_address", cur_focussed_device_.address),
-        fmt::arg("device_address_type", cur_focussed_device_.address_type),
-        fmt::arg("device_alias", cur_focussed_device_.alias), fmt::arg("icon", icon_tooltip),
-        fmt::arg("device_battery_percentage", cur_focussed_device_.battery_percentage.value_or(0)),
-        fmt::arg("device_enumerate", device_enumerate_)));
+    device_enumerate = ss.str();
+    // don't start the connected devices text with a new line
+    if (!device_enumerate.empty()) {
+      device_enumerate.erase(0, 1);
+    }
   }
-
-  // Call parent update
-  ALabel::update();
+  return fmt::format(
+      fmt::runtime(tooltip_format_), fmt::arg("status", state_),
+      fmt::arg("num_connections", connected_devices_.size()),
+      fmt::arg("controller_address", cur_controller_ ? cur_controller_->address : "null"),
+      fmt::arg("controller_address_type",
+               cur_controller_ ? cur_controller_->address_type : "null"),
+      fmt::arg("controller_alias", cur_controller_ ? cur_controller_->alias : "null"),
+      fmt::arg("device_address", cur_focussed_device_.address),
+      fmt::arg("device_address_type", cur_focussed_device_.address_type),
+      fmt::arg("device_alias", cur_focussed_device_.alias), fmt::arg("icon", tooltip_icon_),
+      fmt::arg("device_battery_percentage", cur_focussed_device_.battery_percentage.value_or(0)),
+      fmt::arg("device_enumerate", device_enumerate));
 }
 
 // NOTE: only for when the org.bluez.Battery1 interface is added/removed after/before a device is
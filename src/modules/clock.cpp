@@ -24,8 +24,6 @@ wabar::modules::Clock::Clock(const std::string& id, const Json::Value& config)
       tzInTooltip_{tlpFmt_.find("{" + kTZPlaceholder + "}") != std::string::npos},
       tzCurrIdx_{0},
       ordInTooltip_{tlpFmt_.find("{" + kOrdPlaceholder + "}") != std::string::npos} {
-  tlpText_ = tlpFmt_;
-
   if (config_["timezones"].isArray() && !config_["timezones"].empty()) {
     for (const auto& zone_name : config_["timezones"]) {
       if (!zone_name.isString()) continue;
@@ -124,10 +122,11 @@ wabar::modules::Clock::Clock(const std::string& id, const Json::Value& config)
     }
   }
 
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_ - system_clock::now().time_since_epoch() % interval_);
-  };
+  if (tooltipEnabled()) {
+    setTooltipCallback([this] { return getTooltip(); }, true);
+  }
+
+  timer_.start(interval_, [this] { dp.emit(); }, util::Scheduler::Align::INTERVAL);
 }
 
 auto wabar::modules::Clock::update() -> void {
@@ -136,30 +135,29 @@ auto wabar::modules::Clock::update() -> void {
 
   label_.set_markup(fmt_lib::vformat(locale_, format_, fmt_lib::make_format_args(now)));
 
-  if (tooltipEnabled()) {
-    const year_month_day today{floor<days>(now.get_local_time())};
-    const auto shiftedDay{today + cldCurrShift_};
-    const zoned_time shiftedNow{
-        tz, local_days(shiftedDay) + (now.get_local_time() - floor<days>(now.get_local_time()))};
-
-    if (tzInTooltip_) tzText_ = getTZtext(now.get_sys_time());
-    if (cldInTooltip_) cldText_ = get_calendar(today, shiftedDay, tz);
-    if (ordInTooltip_) ordText_ = get_ordinal_date(shiftedDay);
-    if (tzInTooltip_ || cldInTooltip_ || ordInTooltip_) {
-      // std::vformat doesn't support named arguments.
-      tlpText_ = std::regex_replace(tlpFmt_, std::regex("\\{" + kTZPlaceholder + "\\}"), tzText_);
-      tlpText_ =
-          std::regex_replace(tlpText_, std::regex("\\{" + kCldPlaceholder + "\\}"), cldText_);
-      tlpText_ =
-          std::regex_replace(tlpText_, std::regex("\\{" + kOrdPlaceholder + "\\}"), ordText_);
-    }
-
-    tlpText_ = fmt_lib::vformat(locale_, tlpText_, fmt_lib::make_format_args(shiftedNow));
+  ALabel::update();
+}
 
-    label_.set_tooltip_markup(tlpText_);
+auto wabar::modules::Clock::getTooltip() -> std::string {
+  const auto* tz = tzList_[tzCurrIdx_] != nullptr ? tzList_[tzCurrIdx_] : current_zone();
+  const zoned_time now{tz, floor<seconds>(system_clock::now())};
+  const year_month_day today{floor<days>(now.get_local_time())};
+  const auto shiftedDay{today + cldCurrShift_};
+  const zoned_time shiftedNow{
+      tz, local_days(shiftedDay) + (now.get_local_time() - floor<days>(now.get_local_time()))};
+
+  std::string tlpText{tlpFmt_};
+  if (tzInTooltip_) tzText_ = getTZtext(now.get_sys_time());
+  if (cldInTooltip_) cldText_ = get_calendar(today, shiftedDay, tz);
+  if (ordInTooltip_) ordText_ = get_ordinal_date(shiftedDay);
+  if (tzInTooltip_ || cldInTooltip_ || ordInTooltip_) {
+    // std::vformat doesn't support named arguments.
+    tlpText = std::regex_replace(tlpText, std::regex("\\{" + kTZPlaceholder + "\\}"), tzText_);
+    tlpText = std::regex_replace(tlpText, std::regex("\\{" + kCldPlaceholder + "\\}"), cldText_);
+    tlpText = std::regex_replace(tlpText, std::regex("\\{" + kOrdPlaceholder + "\\}"), ordText_);
   }
 
-  ALabel::update();
+  return fmt_lib::vformat(locale_, tlpText, fmt_lib::make_format_args(shiftedNow));
 }
 
 auto wabar::modules::Clock::getTZtext(sys_seconds now) -> std::string {
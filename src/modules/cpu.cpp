@@ -15,46 +15,59 @@
 
 wabar::modules::Cpu::Cpu(const std::string& id, const Json::Value& config)
     : ALabel(config, "cpu", id, "{usage}%", 10) {
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  // Only the providers of a shown placeholder are sampled: reading /proc/cpuinfo for the
+  // frequencies costs more than everything else
+  bool load = shows("load");
+  // The states and the tooltip follow the usage too
+  bool usage = fields_.containsPrefix("usage") || fields_.containsPrefix("icon") ||
+               !config_view_.states().empty() || tooltipEnabled();
+  bool frequency = shows("max_frequency") || shows("min_frequency") || shows("avg_frequency");
+  source_ = util::DataSource<Sample>::subscribe(
+      util::makeSourceKey("cpu", interval_.count(), load, usage, frequency), interval_,
+      [load, usage, frequency, prev_times = std::vector<std::tuple<size_t, size_t>>()]() mutable {
+        Sample sample;
+        if (load) {
+          sample.load1 = std::get<0>(Load::getLoad());
+        }
+        if (usage) {
+          sample.usage = CpuUsage::getCpuUsage(prev_times);
+        }
+        if (frequency) {
+          std::tie(sample.max_frequency, sample.min_frequency, sample.avg_frequency) =
+              CpuFrequency::getCpuFrequency();
+        }
+        return sample;
+      },
+      [this] { dp.emit(); });
+  if (tooltipEnabled()) {
+    setTooltipCallback([this] { return CpuUsage::getTooltip(source_.get().usage); });
+  }
 }
 
 auto wabar::modules::Cpu::update() -> void {
   // TODO: as creating dynamic fmt::arg arrays is buggy we have to calc both
-  auto [load1, load5, load15] = Load::getLoad();
-  auto [cpu_usage, tooltip] = CpuUsage::getCpuUsage(prev_times_);
-  auto [max_frequency, min_frequency, avg_frequency] = CpuFrequency::getCpuFrequency();
-  if (tooltipEnabled()) {
-    label_.set_tooltip_text(tooltip);
-  }
+  auto [load1, cpu_usage, max_frequency, min_frequency, avg_frequency] = source_.get();
   auto format = format_;
   auto total_usage = cpu_usage.empty() ? 0 : cpu_usage[0];
   auto state = getState(total_usage);
-  if (!state.empty() && config_["format-" + state].isString()) {
-    format = config_["format-" + state].asString();
+  if (const auto* configured = config_view_.format(state)) {
+    format = *configured;
   }
 
   if (format.empty()) {
     event_box_.hide();
   } else {
     event_box_.show();
-    auto icons = std::vector<std::string>{state};
+    // Looked up once for all the cores
+    const auto* icons = iconTable({state});
     fmt::dynamic_format_arg_store<fmt::format_context> store;
     store.push_back(fmt::arg("load", load1));
     store.push_back(fmt::arg("usage", total_usage));
-    store.push_back(fmt::arg("icon", getIcon(total_usage, icons)));
+    store.push_back(fmt::arg("icon", iconAt(icons, total_usage)));
     store.push_back(fmt::arg("max_frequency", max_frequency));
     store.push_back(fmt::arg("min_frequency", min_frequency));
     store.push_back(fmt::arg("avg_frequency", avg_frequency));
-    for (size_t i = 1; i < cpu_usage.size(); ++i) {
-      auto core_i = i - 1;
-      auto core_format = fmt::format("usage{}", core_i);
-      store.push_back(fmt::arg(core_format.c_str(), cpu_usage[i]));
-      auto icon_format = fmt::format("icon{}", core_i);
-      store.push_back(fmt::arg(icon_format.c_str(), getIcon(cpu_usage[i], icons)));
-    }
+    CpuUsage::pushCoreArgs(store, cpu_usage, icons);
     label_.set_markup(fmt::vformat(format, store));
   }
 
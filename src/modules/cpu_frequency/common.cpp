@@ -11,25 +11,25 @@
 
 wabar::modules::CpuFrequency::CpuFrequency(const std::string& id, const Json::Value& config)
     : ALabel(config, "cpu_frequency", id, "{avg_frequency}", 10) {
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  source_ = util::DataSource<std::tuple<float, float, float>>::subscribe(
+      util::makeSourceKey("cpu_frequency", interval_.count()), interval_,
+      &CpuFrequency::getCpuFrequency, [this] { dp.emit(); });
+  if (tooltipEnabled()) {
+    setTooltipCallback([this] {
+      auto [max_frequency, min_frequency, avg_frequency] = source_.get();
+      return fmt::format("Minimum frequency: {}\nAverage frequency: {}\nMaximum frequency: {}\n",
+                         min_frequency, avg_frequency, max_frequency);
+    });
+  }
 }
 
 auto wabar::modules::CpuFrequency::update() -> void {
   // TODO: as creating dynamic fmt::arg arrays is buggy we have to calc both
-  auto [max_frequency, min_frequency, avg_frequency] = CpuFrequency::getCpuFrequency();
-  if (tooltipEnabled()) {
-    auto tooltip =
-        fmt::format("Minimum frequency: {}\nAverage frequency: {}\nMaximum frequency: {}\n",
-                    min_frequency, avg_frequency, max_frequency);
-    label_.set_tooltip_text(tooltip);
-  }
+  auto [max_frequency, min_frequency, avg_frequency] = source_.get();
   auto format = format_;
   auto state = getState(avg_frequency);
-  if (!state.empty() && config_["format-" + state].isString()) {
-    format = config_["format-" + state].asString();
+  if (const auto* configured = config_view_.format(state)) {
+    format = *configured;
   }
 
   if (format.empty()) {
@@ -11,40 +11,50 @@
 
 wabar::modules::CpuUsage::CpuUsage(const std::string& id, const Json::Value& config)
     : ALabel(config, "cpu_usage", id, "{usage}%", 10) {
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  source_ = util::DataSource<std::vector<uint16_t>>::subscribe(
+      util::makeSourceKey("cpu_usage", interval_.count()), interval_,
+      [prev_times = std::vector<std::tuple<size_t, size_t>>()]() mutable {
+        return CpuUsage::getCpuUsage(prev_times);
+      },
+      [this] { dp.emit(); });
+  if (tooltipEnabled()) {
+    setTooltipCallback([this] { return getTooltip(source_.get()); });
+  }
+}
+
+void wabar::modules::CpuUsage::pushCoreArgs(
+    fmt::dynamic_format_arg_store<fmt::format_context>& store, const std::vector<uint16_t>& usage,
+    const util::ConfigView::IconTable* icons) {
+  for (size_t i = 1; i < usage.size(); ++i) {
+    auto core_i = i - 1;
+    // The store copies the names
+    auto core_format = fmt::format("usage{}", core_i);
+    store.push_back(fmt::arg(core_format.c_str(), usage[i]));
+    auto icon_format = fmt::format("icon{}", core_i);
+    store.push_back(fmt::arg(icon_format.c_str(), iconAt(icons, usage[i])));
+  }
 }
 
 auto wabar::modules::CpuUsage::update() -> void {
   // TODO: as creating dynamic fmt::arg arrays is buggy we have to calc both
-  auto [cpu_usage, tooltip] = CpuUsage::getCpuUsage(prev_times_);
-  if (tooltipEnabled()) {
-    label_.set_tooltip_text(tooltip);
-  }
+  auto cpu_usage = source_.get();
   auto format = format_;
   auto total_usage = cpu_usage.empty() ? 0 : cpu_usage[0];
   auto state = getState(total_usage);
-  if (!state.empty() && config_["format-" + state].isString()) {
-    format = config_["format-" + state].asString();
+  if (const auto* configured = config_view_.format(state)) {
+    format = *configured;
   }
 
   if (format.empty()) {
     event_box_.hide();
   } else {
     event_box_.show();
-    auto icons = std::vector<std::string>{state};
+    // Looked up once for all the cores
+    const auto* icons = iconTable({state});
     fmt::dynamic_format_arg_store<fmt::format_context> store;
     store.push_back(fmt::arg("usage", total_usage));
-    store.push_back(fmt::arg("icon", getIcon(total_usage, icons)));
-    for (size_t i = 1; i < cpu_usage.size(); ++i) {
-      auto core_i = i - 1;
-      auto core_format = fmt::format("usage{}", core_i);
-      store.push_back(fmt::arg(core_format.c_str(), cpu_usage[i]));
-      auto icon_format = fmt::format("icon{}", core_i);
-      store.push_back(fmt::arg(icon_format.c_str(), getIcon(cpu_usage[i], icons)));
-    }
+    store.push_back(fmt::arg("icon", iconAt(icons, total_usage)));
+    pushCoreArgs(store, cpu_usage, icons);
     label_.set_markup(fmt::vformat(format, store));
   }
 
@@ -52,14 +62,13 @@ auto wabar::modules::CpuUsage::update() -> void {
   ALabel::update();
 }
 
-std::tuple<std::vector<uint16_t>, std::string> wabar::modules::CpuUsage::getCpuUsage(
+std::vector<uint16_t> wabar::modules::CpuUsage::getCpuUsage(
     std::vector<std::tuple<size_t, size_t>>& prev_times) {
   if (prev_times.empty()) {
     prev_times = CpuUsage::parseCpuinfo();
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
   }
   std::vector<std::tuple<size_t, size_t>> curr_times = CpuUsage::parseCpuinfo();
-  std::string tooltip;
   std::vector<uint16_t> usage;
   for (size_t i = 0; i < curr_times.size(); ++i) {
     auto [curr_idle, curr_total] = curr_times[i];
@@ -67,13 +76,20 @@ std::tuple<std::vector<uint16_t>, std::string> wabar::modules::CpuUsage::getCpuU
     const float delta_idle = curr_idle - prev_idle;
     const float delta_total = curr_total - prev_total;
     uint16_t tmp = 100 * (1 - delta_idle / delta_total);
+    usage.push_back(tmp);
+  }
+  prev_times = curr_times;
+  return usage;
+}
+
+std::string wabar::modules::CpuUsage::getTooltip(const std::vector<uint16_t>& usage) {
+  std::string tooltip;
+  for (size_t i = 0; i < usage.size(); ++i) {
     if (i == 0) {
-      tooltip = fmt::format("Total: {}%", tmp);
+      tooltip = fmt::format("Total: {}%", usage[i]);
     } else {
-      tooltip = tooltip + fmt::format("\nCore{}: {}%", i - 1, tmp);
+      tooltip += fmt::format("\nCore{}: {}%", i - 1, usage[i]);
     }
-    usage.push_back(tmp);
   }
-  prev_times = curr_times;
-  return {usage, tooltip};
+  return tooltip;
 }
@@ -8,6 +8,11 @@ std::vector<std::tuple<size_t, size_t>> wabar::modules::CpuUsage::parseCpuinfo()
   if (!info.is_open()) {
     throw std::runtime_error("Can't open " + data_dir_);
   }
+  return parseCpuinfo(info);
+}
+
+std::vector<std::tuple<size_t, size_t>> wabar::modules::CpuUsage::parseCpuinfo(
+    std::istream& info) {
   std::vector<std::tuple<size_t, size_t>> cpuinfo;
   std::string line;
   while (getline(info, line)) {
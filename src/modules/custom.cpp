@@ -2,135 +2,256 @@
 
 #include <spdlog/spdlog.h>
 
-#include "util/scope_guard.hpp"
+#include <algorithm>
 
 wabar::modules::Custom::Custom(const std::string& name, const std::string& id,
                                 const Json::Value& config, const std::string& output_name)
     : ALabel(config, "custom-" + name, id, "{}"),
       name_(name),
       output_name_(output_name),
+      hides_on_failure_(config["exec"].isString() || config["exec"].isArray() ||
+                        config["exec-if"].isString() || config["watch-file"].isString()),
+      json_output_(config["return-type"].asString() == "json"),
+      escape_(config["escape"].isBool() && config["escape"].asBool()),
+      tooltip_format_(config["tooltip-format"].isString()
+                          ? std::optional(config["tooltip-format"].asString())
+                          : std::nullopt),
       id_(id),
       percentage_(0),
       fp_(nullptr),
       pid_(-1) {
+  label_.get_style_context()->add_class("flat");
+  label_.get_style_context()->add_class("text-button");
   dp.emit();
-  if (!config_["signal"].empty() && config_["interval"].empty() &&
+  if (tooltipEnabled()) {
+    // Reads what the last update parsed, only update() changes it
+    setTooltipCallback(
+        [this]() -> std::string {
+          if (text_ == tooltip_) {
+            return label_.get_label();
+          }
+          if (tooltip_format_) {
+            return fmt::format(fmt::runtime(*tooltip_format_), text_, fmt::arg("alt", alt_),
+                               fmt::arg("icon", getIcon(percentage_, alt_)),
+                               fmt::arg("percentage", percentage_));
+          }
+          return tooltip_;
+        },
+        true);
+  }
+  push_ = util::PushServer::inst().subscribe("custom/" + name_, [this](const Json::Value& payload) {
+    // Same path as the output of a script with "return-type": "json", which is read per line
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "";
+    post({0, Json::writeString(writer, payload)}, true);
+  });
+  if (config_["watch-file"].isString()) {
+    fileWorker();
+  } else if (!config_["signal"].empty() && config_["interval"].empty() &&
       config_["restart-interval"].empty()) {
     waitingWorker();
   } else if (interval_.count() > 0) {
     delayWorker();
-  } else if (config_["exec"].isString()) {
+  } else if (config_["exec"].isString() || config_["exec"].isArray()) {
     continuousWorker();
   }
 }
 
 wabar::modules::Custom::~Custom() {
-  if (pid_ != -1) {
-    killpg(pid_, SIGTERM);
-    waitpid(pid_, NULL, 0);
+  // Before the callbacks could run on a destroyed module
+  push_.reset();
+  watcher_.reset();
+  reader_.stop();
+  if (exec_) {
+    // Waits for an exit callback in progress. The ChildSupervisor reaps the script, a pid it
+    // already reported may belong to another process by now.
+    std::lock_guard lock(exec_->mutex);
+    exec_->module = nullptr;
+    if (pid_ != -1 && !exec_->status) {
+      killpg(pid_, SIGTERM);
+    }
     pid_ = -1;
   }
+  if (fp_) {
+    fclose(fp_);
+  }
 }
 
-void wabar::modules::Custom::delayWorker() {
-  thread_ = [this] {
-    bool can_update = true;
-    if (config_["exec-if"].isString()) {
-      output_ = util::command::execNoRead(config_["exec-if"].asString());
-      if (output_.exit_code != 0) {
-        can_update = false;
-        dp.emit();
-      }
-    }
-    if (can_update) {
-      if (config_["exec"].isString()) {
-        output_ = util::command::exec(config_["exec"].asString(), output_name_);
-      }
-      dp.emit();
+void wabar::modules::Custom::delayWorker() { sharedWorker(interval_); }
+
+// `exec` is either a shell command or an array with a program and its arguments
+static std::vector<std::string> execArgs(const Json::Value& exec) {
+  std::vector<std::string> args;
+  if (exec.isArray()) {
+    for (const auto& arg : exec) {
+      args.push_back(arg.asString());
     }
-    thread_.sleep_for(interval_);
-  };
+  }
+  return args;
 }
 
-void wabar::modules::Custom::continuousWorker() {
-  auto cmd = config_["exec"].asString();
-  pid_ = -1;
-  fp_ = util::command::open(cmd, pid_, output_name_);
-  if (!fp_) {
+FILE* wabar::modules::Custom::openExec() {
+  auto args = execArgs(config_["exec"]);
+  auto cmd = args.empty() ? config_["exec"].asString() : args.front();
+  auto* fp = args.empty() ? util::command::open(cmd, pid_, output_name_)
+                          : util::command::open(args, pid_, output_name_);
+  if (!fp) {
     throw std::runtime_error("Unable to open " + cmd);
   }
-  thread_ = [this, cmd] {
-    char* buff = nullptr;
-    wabar::util::ScopeGuard buff_deleter([buff]() {
-      if (buff) {
-        free(buff);
-      }
-    });
-    size_t len = 0;
-    if (getline(&buff, &len, fp_) == -1) {
-      int exit_code = 1;
-      if (fp_) {
-        exit_code = WEXITSTATUS(util::command::close(fp_, pid_));
-        fp_ = nullptr;
-      }
-      if (exit_code != 0) {
-        output_ = {exit_code, ""};
-        dp.emit();
-        spdlog::error("{} stopped unexpectedly, is it endless?", name_);
-      }
-      if (config_["restart-interval"].isUInt()) {
-        pid_ = -1;
-        thread_.sleep_for(std::chrono::seconds(config_["restart-interval"].asUInt()));
-        fp_ = util::command::open(cmd, pid_, output_name_);
-        if (!fp_) {
-          throw std::runtime_error("Unable to open " + cmd);
-        }
-      } else {
-        thread_.stop();
-        return;
-      }
-    } else {
-      std::string output = buff;
+  return fp;
+}
 
-      // Remove last newline
-      if (!output.empty() && output[output.length() - 1] == '\n') {
-        output.erase(output.length() - 1);
-      }
-      output_ = {0, output};
-      dp.emit();
+// Output is the content of the file, read again on change instead of on an interval
+void wabar::modules::Custom::fileWorker() {
+  watcher_ = std::make_unique<util::FileWatcher>(config_["watch-file"].asString(),
+                                                 [this](const std::string& content) {
+                                                   post({0, content}, false);
+                                                 });
+}
+
+void wabar::modules::Custom::continuousWorker() {
+  pid_ = -1;
+  restarting_ = false;
+  fp_ = openExec();
+  auto exec = std::make_shared<Exec>();
+  exec->module = this;
+  exec_ = exec;
+  // Lines are read on the shared reactor thread rather than a thread per script
+  reader_.readLines(
+      fileno(fp_), [this](std::string_view line) { post({0, std::string(line)}, false); },
+      [exec] {
+        std::lock_guard lock(exec->mutex);
+        exec->eof = true;
+        if (exec->module != nullptr && exec->status) {
+          exec->module->execDone(*exec);
+        }
+      });
+  // Reaped through a pidfd on the reactor thread, or on SIGCHLD
+  util::ChildSupervisor::inst().watch(pid_, [exec](int status) {
+    std::lock_guard lock(exec->mutex);
+    exec->status = status;
+    if (exec->module != nullptr && exec->eof) {
+      exec->module->execDone(*exec);
     }
-  };
+  });
+}
+
+// Called with exec.mutex held, once the script both closed its output and exited
+void wabar::modules::Custom::execDone(const Exec& exec) {
+  fclose(fp_);
+  fp_ = nullptr;
+  pid_ = -1;
+  int status = *exec.status;
+  int exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+  if (exit_code != 0) {
+    post({exit_code, ""}, false);
+    spdlog::error("{} stopped unexpectedly, is it endless?", name_);
+  }
+  if (config_["restart-interval"].isUInt()) {
+    restarting_ = true;
+    reader_.after(std::chrono::seconds(config_["restart-interval"].asUInt()),
+                  [this] { continuousWorker(); });
+  }
 }
 
 void wabar::modules::Custom::waitingWorker() {
-  thread_ = [this] {
-    bool can_update = true;
-    if (config_["exec-if"].isString()) {
-      output_ = util::command::execNoRead(config_["exec-if"].asString());
-      if (output_.exit_code != 0) {
-        can_update = false;
+  // Run once, then only when woken up by a signal or an event
+  sharedWorker(std::chrono::seconds::max());
+}
+
+void wabar::modules::Custom::sharedWorker(std::chrono::seconds interval) {
+  // Identical modules on other outputs run the command once for all of them
+  auto exec = config_["exec"].isString() ? config_["exec"].asString() : "";
+  auto exec_args = execArgs(config_["exec"]);
+  auto exec_if = config_["exec-if"].isString() ? config_["exec-if"].asString() : "";
+  // Results shared with other modules running the same command, off by default
+  std::optional<util::command::ExecCache::clock::duration> cache_ttl;
+  if (config_["exec-cache-ttl"].isNumeric()) {
+    cache_ttl = std::chrono::duration_cast<util::command::ExecCache::clock::duration>(
+        std::chrono::duration<double>(std::max(config_["exec-cache-ttl"].asDouble(), 0.0)));
+  }
+  util::command::Limits limits;
+  if (config_["exec-max-output"].isUInt() && config_["exec-max-output"].asUInt() > 0) {
+    limits.max_output = config_["exec-max-output"].asUInt();
+  } else if (!config_["exec-max-output"].isNull()) {
+    spdlog::warn("{}: exec-max-output must be a positive number of bytes, using {}", name_,
+                 limits.max_output);
+  }
+  if (config_["exec-timeout"].isNumeric()) {
+    limits.timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::duration<double>(std::max(config_["exec-timeout"].asDouble(), 0.0)));
+  }
+  source_ = util::DataSource<util::command::res>::subscribe(
+      util::makeSourceKey("custom", interval.count(), exec, exec_args, exec_if, output_name_,
+                          cache_ttl ? cache_ttl->count() : -1, limits.max_output,
+                          limits.timeout.count()),
+      interval,
+      [exec, exec_args, exec_if, cache_ttl, limits,
+       output_name = output_name_]() -> util::command::res {
+        if (!exec_if.empty()) {
+          auto res = util::command::execNoRead(exec_if);
+          if (res.exit_code != 0) {
+            return res;
+          }
+        }
+        if (exec.empty() && exec_args.empty()) {
+          return {0, ""};
+        }
+        auto run = [&] {
+          return exec_args.empty() ? util::command::exec(exec, output_name, limits)
+                                   : util::command::exec(exec_args, output_name, limits);
+        };
+        if (!cache_ttl) {
+          return run();
+        }
+        return util::command::ExecCache::inst().get(
+            util::makeSourceKey("exec", exec, exec_args, output_name, limits.max_output,
+                                limits.timeout.count()),
+            *cache_ttl, run);
+      },
+      [this] {
+        {
+          // The new run replaces a push that wasn't shown yet
+          std::lock_guard lock(pending_mutex_);
+          pending_.reset();
+          sampled_ = true;
+        }
         dp.emit();
-      }
-    }
-    if (can_update) {
-      if (config_["exec"].isString()) {
-        output_ = util::command::exec(config_["exec"].asString(), output_name_);
-      }
-      dp.emit();
-    }
-    thread_.sleep();
-  };
+      });
+}
+
+// Called off the main thread, output_ is only set by update()
+void wabar::modules::Custom::post(util::command::res output, bool pushed) {
+  {
+    std::lock_guard lock(pending_mutex_);
+    pending_ = std::move(output);
+    pending_pushed_ = pushed;
+  }
+  dp.emit();
 }
 
 void wabar::modules::Custom::refresh(int sig) {
   if (sig == SIGRTMIN + config_["signal"].asInt()) {
-    thread_.wake_up();
+    wakeUp();
   }
 }
 
 void wabar::modules::Custom::handleEvent() {
   if (!config_["exec-on-event"].isBool() || config_["exec-on-event"].asBool()) {
-    thread_.wake_up();
+    wakeUp();
+  }
+}
+
+void wabar::modules::Custom::wakeUp() {
+  if (source_) {
+    source_.refresh();
+  } else if (restarting_) {
+    // Cut the restart interval short
+    reader_.after(std::chrono::seconds(0), [this] {
+      if (restarting_) {
+        continuousWorker();
+      }
+    });
   }
 }
 
@@ -147,12 +268,26 @@ bool wabar::modules::Custom::handleToggle(GdkEventButton* const& e) {
 }
 
 auto wabar::modules::Custom::update() -> void {
+  {
+    std::lock_guard lock(pending_mutex_);
+    if (pending_) {
+      output_ = std::move(*pending_);
+      pushed_ = pending_pushed_;
+      pending_.reset();
+    } else if (sampled_) {
+      pushed_ = false;
+    }
+    sampled_ = false;
+  }
+  // A push stands until the next run of the script
+  if (source_ && !pushed_) {
+    output_ = source_.get();
+  }
   // Hide label if output is empty
-  if ((config_["exec"].isString() || config_["exec-if"].isString()) &&
-      (output_.out.empty() || output_.exit_code != 0)) {
+  if (hides_on_failure_ && (output_.out.empty() || output_.exit_code != 0)) {
     event_box_.hide();
   } else {
-    if (config_["return-type"].asString() == "json") {
+    if (json_output_ || pushed_) {
       parseOutputJson();
     } else {
       parseOutputRaw();
@@ -165,35 +300,7 @@ auto wabar::modules::Custom::update() -> void {
       event_box_.hide();
     } else {
       label_.set_markup(str);
-      if (tooltipEnabled()) {
-        if (text_ == tooltip_) {
-          if (label_.get_tooltip_markup() != str) {
-            label_.set_tooltip_markup(str);
-          }
-        } else if (config_["tooltip-format"].isString()) {
-          auto tooltip = config_["tooltip-format"].asString();
-          tooltip = fmt::format(fmt::runtime(tooltip), text_, fmt::arg("alt", alt_),
-                                fmt::arg("icon", getIcon(percentage_, alt_)),
-                                fmt::arg("percentage", percentage_));
-          label_.set_tooltip_markup(tooltip);
-        } else {
-          if (label_.get_tooltip_markup() != tooltip_) {
-            label_.set_tooltip_markup(tooltip_);
-          }
-        }
-      }
-      auto style = label_.get_style_context();
-      auto classes = style->list_classes();
-      for (auto const& c : classes) {
-        if (c == id_) continue;
-        style->remove_class(c);
-      }
-      for (auto const& c : class_) {
-        style->add_class(c);
-      }
-      style->add_class("flat");
-      style->add_class("text-button");
-      style->add_class(MODULE_CLASS);
+      applyClasses();
       event_box_.show();
     }
   }
@@ -201,6 +308,28 @@ auto wabar::modules::Custom::update() -> void {
   ALabel::update();
 }
 
+// Only restyle when the classes of the output changed since the last update
+void wabar::modules::Custom::applyClasses() {
+  if (!util::RenderStats::count(class_ != applied_classes_)) {
+    return;
+  }
+  auto fixed = [this](const std::string& c) {
+    return c == id_ || c == "flat" || c == "text-button" || c == MODULE_CLASS;
+  };
+  auto style = label_.get_style_context();
+  for (const auto& c : applied_classes_) {
+    if (!fixed(c) && std::ranges::find(class_, c) == class_.end()) {
+      style->remove_class(c);
+    }
+  }
+  for (const auto& c : class_) {
+    if (std::ranges::find(applied_classes_, c) == applied_classes_.end()) {
+      style->add_class(c);
+    }
+  }
+  applied_classes_ = class_;
+}
+
 void wabar::modules::Custom::parseOutputRaw() {
   std::istringstream output(output_.out);
   std::string line;
@@ -212,7 +341,7 @@ void wabar::modules::Custom::parseOutputRaw() {
     }
 
     if (i == 0) {
-      if (config_["escape"].isBool() && config_["escape"].asBool()) {
+      if (escape_) {
         text_ = Glib::Markup::escape_text(validated_line);
       } else {
         text_ = validated_line;
@@ -236,12 +365,12 @@ void wabar::modules::Custom::parseOutputJson() {
   class_.clear();
   while (getline(output, line)) {
     auto parsed = parser_.parse(line);
-    if (config_["escape"].isBool() && config_["escape"].asBool()) {
+    if (escape_) {
       text_ = Glib::Markup::escape_text(parsed["text"].asString());
     } else {
       text_ = parsed["text"].asString();
     }
-    if (config_["escape"].isBool() && config_["escape"].asBool()) {
+    if (escape_) {
       alt_ = Glib::Markup::escape_text(parsed["alt"].asString());
     } else {
       alt_ = parsed["alt"].asString();
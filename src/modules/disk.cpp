@@ -4,20 +4,38 @@ using namespace wabar::util;
 
 wabar::modules::Disk::Disk(const std::string& id, const Json::Value& config)
     : ALabel(config, "disk", id, "{}%", 30), path_("/") {
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
   if (config["path"].isString()) {
     path_ = config["path"].asString();
   }
   if (config["unit"].isString()) {
     unit_ = config["unit"].asString();
   }
+  source_ = util::DataSource<std::optional<struct statvfs>>::subscribe(
+      util::makeSourceKey("disk", interval_.count(), path_), interval_,
+      [path = path_]() -> std::optional<struct statvfs> {
+        struct statvfs stats;
+        if (statvfs(path.c_str(), &stats) != 0) {
+          return std::nullopt;
+        }
+        return stats;
+      },
+      [this] { dp.emit(); });
+  if (tooltipEnabled()) {
+    setTooltipCallback([this]() -> std::string {
+      if (!stats_) {
+        return "";
+      }
+      std::string tooltip_format = "{used} used out of {total} on {path} ({percentage_used}%)";
+      if (config_["tooltip-format"].isString()) {
+        tooltip_format = config_["tooltip-format"].asString();
+      }
+      return formatStats(tooltip_format, *stats_);
+    });
+  }
 }
 
 auto wabar::modules::Disk::update() -> void {
-  struct statvfs /* {
+  std::optional<struct statvfs> /* {
       unsigned long  f_bsize;    // filesystem block size
       unsigned long  f_frsize;   // fragment size
       fsblkcnt_t     f_blocks;   // size of fs in f_frsize units
@@ -30,8 +48,7 @@ auto wabar::modules::Disk::update() -> void {
       unsigned long  f_flag;     // mount flags
       unsigned long  f_namemax;  // maximum filename length
   }; */
-      stats;
-  int err = statvfs(path_.c_str(), &stats);
+      sample = source_.get();
 
   /* Conky options
     fs_bar - Bar that shows how much space is used
@@ -41,57 +58,51 @@ auto wabar::modules::Disk::update() -> void {
     fs_used - File system used space
   */
 
-  if (err != 0) {
+  stats_ = sample;
+  if (!sample) {
     event_box_.hide();
     return;
   }
-
-  float specific_free, specific_used, specific_total, divisor;
-
-  divisor = calc_specific_divisor(unit_);
-  specific_free = (stats.f_bavail * stats.f_frsize) / divisor;
-  specific_used = ((stats.f_blocks - stats.f_bfree) * stats.f_frsize) / divisor;
-  specific_total = (stats.f_blocks * stats.f_frsize) / divisor;
-
-  auto free = pow_format(stats.f_bavail * stats.f_frsize, "B", true);
-  auto used = pow_format((stats.f_blocks - stats.f_bfree) * stats.f_frsize, "B", true);
-  auto total = pow_format(stats.f_blocks * stats.f_frsize, "B", true);
+  const auto& stats = *sample;
   auto percentage_used = (stats.f_blocks - stats.f_bfree) * 100 / stats.f_blocks;
 
   auto format = format_;
   auto state = getState(percentage_used);
-  if (!state.empty() && config_["format-" + state].isString()) {
-    format = config_["format-" + state].asString();
+  if (const auto* configured = config_view_.format(state)) {
+    format = *configured;
   }
 
   if (format.empty()) {
     event_box_.hide();
   } else {
     event_box_.show();
-    label_.set_markup(fmt::format(
-        fmt::runtime(format), stats.f_bavail * 100 / stats.f_blocks, fmt::arg("free", free),
-        fmt::arg("percentage_free", stats.f_bavail * 100 / stats.f_blocks), fmt::arg("used", used),
-        fmt::arg("percentage_used", percentage_used), fmt::arg("total", total),
-        fmt::arg("path", path_), fmt::arg("specific_free", specific_free),
-        fmt::arg("specific_used", specific_used), fmt::arg("specific_total", specific_total)));
-  }
-
-  if (tooltipEnabled()) {
-    std::string tooltip_format = "{used} used out of {total} on {path} ({percentage_used}%)";
-    if (config_["tooltip-format"].isString()) {
-      tooltip_format = config_["tooltip-format"].asString();
-    }
-    label_.set_tooltip_text(fmt::format(
-        fmt::runtime(tooltip_format), stats.f_bavail * 100 / stats.f_blocks, fmt::arg("free", free),
-        fmt::arg("percentage_free", stats.f_bavail * 100 / stats.f_blocks), fmt::arg("used", used),
-        fmt::arg("percentage_used", percentage_used), fmt::arg("total", total),
-        fmt::arg("path", path_), fmt::arg("specific_free", specific_free),
-        fmt::arg("specific_used", specific_used), fmt::arg("specific_total", specific_total)));
+    label_.set_markup(formatStats(format, stats));
   }
   // Call parent update
   ALabel::update();
 }
 
+std::string wabar::modules::Disk::formatStats(const std::string& format,
+                                              const struct statvfs& stats) {
+  float divisor = calc_specific_divisor(unit_);
+  float specific_free = (stats.f_bavail * stats.f_frsize) / divisor;
+  float specific_used = ((stats.f_blocks - stats.f_bfree) * stats.f_frsize) / divisor;
+  float specific_total = (stats.f_blocks * stats.f_frsize) / divisor;
+
+  auto free = pow_format(stats.f_bavail * stats.f_frsize, "B", true);
+  auto used = pow_format((stats.f_blocks - stats.f_bfree) * stats.f_frsize, "B", true);
+  auto total = pow_format(stats.f_blocks * stats.f_frsize, "B", true);
+  auto percentage_free = stats.f_bavail * 100 / stats.f_blocks;
+  auto percentage_used = (stats.f_blocks - stats.f_bfree) * 100 / stats.f_blocks;
+
+  return fmt::format(fmt::runtime(format), percentage_free, fmt::arg("free", free),
+                     fmt::arg("percentage_free", percentage_free), fmt::arg("used", used),
+                     fmt::arg("percentage_used", percentage_used), fmt::arg("total", total),
+                     fmt::arg("path", path_), fmt::arg("specific_free", specific_free),
+                     fmt::arg("specific_used", specific_used),
+                     fmt::arg("specific_total", specific_total));
+}
+
 float wabar::modules::Disk::calc_specific_divisor(std::string divisor) {
   if (divisor == "kB") {
     return 1000.0;
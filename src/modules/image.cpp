@@ -28,16 +28,12 @@ wabar::modules::Image::Image(const std::string& id, const Json::Value& config)
 }
 
 void wabar::modules::Image::delayWorker() {
-  thread_ = [this] {
-    dp.emit();
-    auto interval = std::chrono::seconds(interval_);
-    thread_.sleep_for(interval);
-  };
+  timer_.start(std::chrono::seconds(interval_), [this] { dp.emit(); });
 }
 
 void wabar::modules::Image::refresh(int sig) {
   if (sig == SIGRTMIN + config_["signal"].asInt()) {
-    thread_.wake_up();
+    timer_.wake_up();
   }
 }
 
@@ -7,10 +7,23 @@ JACK::JACK(const std::string &id, const Json::Value &config)
   running_ = false;
   client_ = NULL;
 
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  if (tooltipEnabled()) {
+    setTooltipCallback([this] {
+      std::string tooltip_format = "{bufsize}/{samplerate} {latency}ms";
+      if (config_["tooltip-format"].isString())
+        tooltip_format = config_["tooltip-format"].asString();
+      return formatShown(tooltip_format);
+    });
+  }
+
+  timer_.start(interval_, [this] { dp.emit(); });
+}
+
+std::string JACK::formatShown(const std::string &format) const {
+  return fmt::format(fmt::runtime(format), fmt::arg("load", shown_.load),
+                     fmt::arg("bufsize", shown_.bufsize), fmt::arg("samplerate", shown_.samplerate),
+                     fmt::arg("latency", fmt::format("{:.2f}", shown_.latency)),
+                     fmt::arg("xruns", shown_.xruns));
 }
 
 std::string JACK::JACKState() {
@@ -65,26 +78,16 @@ auto JACK::update() -> void {
   label_.get_style_context()->add_class(state);
   state_ = state;
 
-  if (config_["format-" + state].isString()) {
-    format = config_["format-" + state].asString();
+  if (const auto *configured = config_view_.format(state)) {
+    format = *configured;
   } else if (config_["format"].isString()) {
     format = config_["format"].asString();
   } else
     format = "{load}%";
 
-  label_.set_markup(fmt::format(fmt::runtime(format), fmt::arg("load", std::round(load_)),
-                                fmt::arg("bufsize", bufsize_), fmt::arg("samplerate", samplerate_),
-                                fmt::arg("latency", fmt::format("{:.2f}", latency)),
-                                fmt::arg("xruns", xruns_)));
-
-  if (tooltipEnabled()) {
-    std::string tooltip_format = "{bufsize}/{samplerate} {latency}ms";
-    if (config_["tooltip-format"].isString()) tooltip_format = config_["tooltip-format"].asString();
-    label_.set_tooltip_text(fmt::format(
-        fmt::runtime(tooltip_format), fmt::arg("load", std::round(load_)),
-        fmt::arg("bufsize", bufsize_), fmt::arg("samplerate", samplerate_),
-        fmt::arg("latency", fmt::format("{:.2f}", latency)), fmt::arg("xruns", xruns_)));
-  }
+  // The JACK callbacks keep changing the members, the tooltip formats the same values
+  shown_ = {std::round(load_), bufsize_, samplerate_, latency, xruns_};
+  label_.set_markup(formatShown(format));
 
   // Call parent update
   ALabel::update();
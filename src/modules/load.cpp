@@ -11,23 +11,24 @@
 
 wabar::modules::Load::Load(const std::string& id, const Json::Value& config)
     : ALabel(config, "load", id, "{load1}", 10) {
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  source_ = util::DataSource<std::tuple<double, double, double>>::subscribe(
+      util::makeSourceKey("load", interval_.count()), interval_, &Load::getLoad,
+      [this] { dp.emit(); });
+  if (tooltipEnabled()) {
+    setTooltipCallback([this] {
+      auto [load1, load5, load15] = source_.get();
+      return fmt::format("Load 1: {}\nLoad 5: {}\nLoad 15: {}", load1, load5, load15);
+    });
+  }
 }
 
 auto wabar::modules::Load::update() -> void {
   // TODO: as creating dynamic fmt::arg arrays is buggy we have to calc both
-  auto [load1, load5, load15] = Load::getLoad();
-  if (tooltipEnabled()) {
-    auto tooltip = fmt::format("Load 1: {}\nLoad 5: {}\nLoad 15: {}", load1, load5, load15);
-    label_.set_tooltip_text(tooltip);
-  }
+  auto [load1, load5, load15] = source_.get();
   auto format = format_;
   auto state = getState(load1);
-  if (!state.empty() && config_["format-" + state].isString()) {
-    format = config_["format-" + state].asString();
+  if (const auto* configured = config_view_.format(state)) {
+    format = *configured;
   }
 
   if (format.empty()) {
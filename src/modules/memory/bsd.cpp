@@ -79,7 +79,9 @@ static uint64_t get_free_memory() {
 #endif
 }
 
-void wabar::modules::Memory::parseMeminfo() {
-  meminfo_["MemTotal"] = get_total_memory() / 1024;
-  meminfo_["MemAvailable"] = get_free_memory() / 1024;
+wabar::modules::Memory::Meminfo wabar::modules::Memory::parseMeminfo() {
+  Meminfo meminfo;
+  meminfo["MemTotal"] = get_total_memory() / 1024;
+  meminfo["MemAvailable"] = get_free_memory() / 1024;
+  return meminfo;
 }
@@ -2,14 +2,34 @@
 
 wabar::modules::Memory::Memory(const std::string& id, const Json::Value& config)
     : ALabel(config, "memory", id, "{}%", 30) {
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  source_ = util::DataSource<Meminfo>::subscribe(util::makeSourceKey("memory", interval_.count()),
+                                                  interval_, [] { return parseMeminfo(); },
+                                                  [this] { dp.emit(); });
+  if (tooltipEnabled()) {
+    // Registered once, reads what the last update showed
+    setTooltipCallback([this] { return tooltipText(); });
+  }
+}
+
+std::string wabar::modules::Memory::tooltipText() const {
+  const auto& u = usage_;
+  if (!u.valid) {
+    return "";
+  }
+  if (!config_["tooltip-format"].isString()) {
+    return fmt::format("{:.{}f}GiB used", u.used_ram_gigabytes, 1);
+  }
+  return fmt::format(
+      fmt::runtime(config_["tooltip-format"].asString()), u.used_ram_percentage,
+      fmt::arg("total", u.total_ram_gigabytes), fmt::arg("swapTotal", u.total_swap_gigabytes),
+      fmt::arg("percentage", u.used_ram_percentage),
+      fmt::arg("swapPercentage", u.used_swap_percentage), fmt::arg("used", u.used_ram_gigabytes),
+      fmt::arg("swapUsed", u.used_swap_gigabytes), fmt::arg("avail", u.available_ram_gigabytes),
+      fmt::arg("swapAvail", u.available_swap_gigabytes));
 }
 
 auto wabar::modules::Memory::update() -> void {
-  parseMeminfo();
+  meminfo_ = source_.get();
 
   unsigned long memtotal = meminfo_["MemTotal"];
   unsigned long swaptotal = 0;
@@ -30,24 +50,26 @@ auto wabar::modules::Memory::update() -> void {
               meminfo_["SReclaimable"] - meminfo_["Shmem"] + meminfo_["zfs_size"];
   }
 
-  if (memtotal > 0 && memfree >= 0) {
-    float total_ram_gigabytes =
+  usage_.valid = memtotal > 0 && memfree >= 0;
+  if (usage_.valid) {
+    auto& u = usage_;
+    u.total_ram_gigabytes =
         0.01 * round(memtotal / 10485.76);  // 100*10485.76 = 2^20 = 1024^2 = GiB/KiB
-    float total_swap_gigabytes = 0.01 * round(swaptotal / 10485.76);
-    int used_ram_percentage = 100 * (memtotal - memfree) / memtotal;
-    int used_swap_percentage = 0;
+    u.total_swap_gigabytes = 0.01 * round(swaptotal / 10485.76);
+    u.used_ram_percentage = 100 * (memtotal - memfree) / memtotal;
+    u.used_swap_percentage = 0;
     if (swaptotal && swapfree) {
-      used_swap_percentage = 100 * (swaptotal - swapfree) / swaptotal;
+      u.used_swap_percentage = 100 * (swaptotal - swapfree) / swaptotal;
     }
-    float used_ram_gigabytes = 0.01 * round((memtotal - memfree) / 10485.76);
-    float used_swap_gigabytes = 0.01 * round((swaptotal - swapfree) / 10485.76);
-    float available_ram_gigabytes = 0.01 * round(memfree / 10485.76);
-    float available_swap_gigabytes = 0.01 * round(swapfree / 10485.76);
+    u.used_ram_gigabytes = 0.01 * round((memtotal - memfree) / 10485.76);
+    u.used_swap_gigabytes = 0.01 * round((swaptotal - swapfree) / 10485.76);
+    u.available_ram_gigabytes = 0.01 * round(memfree / 10485.76);
+    u.available_swap_gigabytes = 0.01 * round(swapfree / 10485.76);
 
     auto format = format_;
-    auto state = getState(used_ram_percentage);
-    if (!state.empty() && config_["format-" + state].isString()) {
-      format = config_["format-" + state].asString();
+    auto state = getState(u.used_ram_percentage);
+    if (const auto* configured = config_view_.format(state)) {
+      format = *configured;
     }
 
     if (format.empty()) {
@@ -56,28 +78,14 @@ auto wabar::modules::Memory::update() -> void {
       event_box_.show();
       auto icons = std::vector<std::string>{state};
       label_.set_markup(fmt::format(
-          fmt::runtime(format), used_ram_percentage,
-          fmt::arg("icon", getIcon(used_ram_percentage, icons)),
-          fmt::arg("total", total_ram_gigabytes), fmt::arg("swapTotal", total_swap_gigabytes),
-          fmt::arg("percentage", used_ram_percentage),
-          fmt::arg("swapPercentage", used_swap_percentage), fmt::arg("used", used_ram_gigabytes),
-          fmt::arg("swapUsed", used_swap_gigabytes), fmt::arg("avail", available_ram_gigabytes),
-          fmt::arg("swapAvail", available_swap_gigabytes)));
-    }
-
-    if (tooltipEnabled()) {
-      if (config_["tooltip-format"].isString()) {
-        auto tooltip_format = config_["tooltip-format"].asString();
-        label_.set_tooltip_text(fmt::format(
-            fmt::runtime(tooltip_format), used_ram_percentage,
-            fmt::arg("total", total_ram_gigabytes), fmt::arg("swapTotal", total_swap_gigabytes),
-            fmt::arg("percentage", used_ram_percentage),
-            fmt::arg("swapPercentage", used_swap_percentage), fmt::arg("used", used_ram_gigabytes),
-            fmt::arg("swapUsed", used_swap_gigabytes), fmt::arg("avail", available_ram_gigabytes),
-            fmt::arg("swapAvail", available_swap_gigabytes)));
-      } else {
-        label_.set_tooltip_text(fmt::format("{:.{}f}GiB used", used_ram_gigabytes, 1));
-      }
+          fmt::runtime(format), u.used_ram_percentage,
+          fmt::arg("icon", getIcon(u.used_ram_percentage, icons)),
+          fmt::arg("total", u.total_ram_gigabytes), fmt::arg("swapTotal", u.total_swap_gigabytes),
+          fmt::arg("percentage", u.used_ram_percentage),
+          fmt::arg("swapPercentage", u.used_swap_percentage),
+          fmt::arg("used", u.used_ram_gigabytes), fmt::arg("swapUsed", u.used_swap_gigabytes),
+          fmt::arg("avail", u.available_ram_gigabytes),
+          fmt::arg("swapAvail", u.available_swap_gigabytes)));
     }
   } else {
     event_box_.hide();
@@ -21,12 +21,19 @@ static unsigned zfsArcSize() {
   return 0;
 }
 
-void wabar::modules::Memory::parseMeminfo() {
+wabar::modules::Memory::Meminfo wabar::modules::Memory::parseMeminfo() {
   const std::string data_dir_ = "/proc/meminfo";
   std::ifstream info(data_dir_);
   if (!info.is_open()) {
     throw std::runtime_error("Can't open " + data_dir_);
   }
+  auto meminfo = parseMeminfo(info);
+  meminfo["zfs_size"] = zfsArcSize();
+  return meminfo;
+}
+
+wabar::modules::Memory::Meminfo wabar::modules::Memory::parseMeminfo(std::istream& info) {
+  Meminfo meminfo;
   std::string line;
   while (getline(info, line)) {
     auto posDelim = line.find(':');
@@ -36,8 +43,7 @@ void wabar::modules::Memory::parseMeminfo() {
 
     std::string name = line.substr(0, posDelim);
     int64_t value = std::stol(line.substr(posDelim + 1));
-    meminfo_[name] = value;
+    meminfo[name] = value;
   }
-
-  meminfo_["zfs_size"] = zfsArcSize();
+  return meminfo;
 }
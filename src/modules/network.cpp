@@ -21,8 +21,7 @@ constexpr const char *DEFAULT_FORMAT = "{ifname}";
 
 constexpr const char *NETDEV_FILE =
     "/proc/net/dev";  // std::ifstream does not take std::string_view as param
-std::optional<std::pair<unsigned long long, unsigned long long>>
-wabar::modules::Network::readBandwidthUsage() {
+std::optional<wabar::modules::Network::NetDev> wabar::modules::Network::readNetDev() {
   std::ifstream netdev(NETDEV_FILE);
   if (!netdev) {
     spdlog::warn("Failed to open netdev file {}", NETDEV_FILE);
@@ -34,17 +33,13 @@ wabar::modules::Network::readBandwidthUsage() {
   std::getline(netdev, line);
   std::getline(netdev, line);
 
-  unsigned long long receivedBytes = 0ull;
-  unsigned long long transmittedBytes = 0ull;
+  NetDev table;
   while (std::getline(netdev, line)) {
     std::istringstream iss(line);
 
     std::string ifacename;
     iss >> ifacename;      // ifacename contains "eth0:"
     ifacename.pop_back();  // remove trailing ':'
-    if (ifacename != ifname_) {
-      continue;
-    }
 
     // The rest of the line consists of whitespace separated counts divided
     // into two groups (receive and transmit). Each group has the following
@@ -70,11 +65,25 @@ wabar::modules::Network::readBandwidthUsage() {
     // Read transmit bytes
     iss >> t;
 
-    receivedBytes += r;
-    transmittedBytes += t;
+    auto &[received, transmitted] = table[ifacename];
+    received += r;
+    transmitted += t;
   }
 
-  return {{receivedBytes, transmittedBytes}};
+  return table;
+}
+
+std::optional<std::pair<unsigned long long, unsigned long long>>
+wabar::modules::Network::readBandwidthUsage() {
+  auto netdev = netdev_.get();
+  if (!netdev) {
+    return {};
+  }
+  auto it = netdev->find(ifname_);
+  if (it == netdev->end()) {
+    return {{0ull, 0ull}};
+  }
+  return it->second;
 }
 
 wabar::modules::Network::Network(const std::string &id, const Json::Value &config)
@@ -102,6 +111,15 @@ wabar::modules::Network::Network(const std::string &id, const Json::Value &confi
   // the module start with no text, but the event_box_ is shown.
   label_.set_markup("<s></s>");
 
+  if (tooltipEnabled()) {
+    // Without a tooltip format the tooltip repeats the label
+    setTooltipCallback(
+        [this] {
+          return shown_.tooltip_format.empty() ? shown_.text : formatShown(shown_.tooltip_format);
+        },
+        true);
+  }
+
   auto bandwidth = readBandwidthUsage();
   if (bandwidth.has_value()) {
     bandwidth_down_total_ = (*bandwidth).first;
@@ -134,6 +152,8 @@ wabar::modules::Network::Network(const std::string &id, const Json::Value &confi
 }
 
 wabar::modules::Network::~Network() {
+  netdev_.reset();
+  timer_.stop();
   if (ev_fd_ > -1) {
     close(ev_fd_);
   }
@@ -225,23 +245,27 @@ void wabar::modules::Network::createInfoSocket() {
 
 void wabar::modules::Network::worker() {
   // update via here not working
-  thread_timer_ = [this] {
-    {
-      std::lock_guard<std::mutex> lock(mutex_);
-      if (ifid_ > 0) {
-        getInfo();
-        dp.emit();
-      }
+  // Runs whenever the shared /proc/net/dev sample is refreshed, or on demand
+  timer_.start(std::chrono::seconds::max(), [this] {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ifid_ > 0) {
+      getInfo();
+      dp.emit();
     }
-    thread_timer_.sleep_for(interval_);
-  };
+  });
+  // Without a bandwidth placeholder the source only paces the updates, /proc/net/dev isn't read
+  bool bandwidth = fields_.containsPrefix("bandwidth");
+  netdev_ = util::DataSource<std::optional<NetDev>>::subscribe(
+      util::makeSourceKey("network", interval_.count(), bandwidth), interval_,
+      [bandwidth] { return bandwidth ? readNetDev() : std::optional<NetDev>(); },
+      [this] { timer_.wake_up(); });
 #ifdef WANT_RFKILL
   rfkill_.on_update.connect([this](auto &) {
     /* If we are here, it's likely that the network thread already holds the mutex and will be
      * holding it for a next few seconds.
      * Let's delegate the update to the timer thread instead of blocking the main thread.
      */
-    thread_timer_.wake_up();
+    timer_.wake_up();
   });
 #else
   spdlog::warn("Wabar has been built without rfkill support.");
@@ -313,15 +337,15 @@ auto wabar::modules::Network::update() -> void {
     if (!state_.empty() && label_.get_style_context()->has_class(state_)) {
       label_.get_style_context()->remove_class(state_);
     }
-    if (config_["format-" + state].isString()) {
-      default_format_ = config_["format-" + state].asString();
+    if (const auto *configured = config_view_.format(state)) {
+      default_format_ = *configured;
     } else if (config_["format"].isString()) {
       default_format_ = config_["format"].asString();
     } else {
       default_format_ = DEFAULT_FORMAT;
     }
-    if (config_["tooltip-format-" + state].isString()) {
-      tooltip_format = config_["tooltip-format-" + state].asString();
+    if (const auto *configured = config_view_.tooltipFormat(state)) {
+      tooltip_format = *configured;
     }
     if (!label_.get_style_context()->has_class(state)) {
       label_.get_style_context()->add_class(state);
@@ -330,26 +354,23 @@ auto wabar::modules::Network::update() -> void {
     state_ = state;
   }
   getState(signal_strength_);
-
-  auto text = fmt::format(
-      fmt::runtime(format_), fmt::arg("essid", essid_), fmt::arg("signaldBm", signal_strength_dbm_),
-      fmt::arg("signalStrength", signal_strength_),
-      fmt::arg("signalStrengthApp", signal_strength_app_), fmt::arg("ifname", ifname_),
-      fmt::arg("netmask", netmask_), fmt::arg("ipaddr", ipaddr_), fmt::arg("gwaddr", gwaddr_),
-      fmt::arg("cidr", cidr_), fmt::arg("frequency", fmt::format("{:.1f}", frequency_)),
-      fmt::arg("icon", getIcon(signal_strength_, state_)),
-      fmt::arg("bandwidthDownBits", pow_format(bandwidth_down * 8ull / interval_.count(), "b/s")),
-      fmt::arg("bandwidthUpBits", pow_format(bandwidth_up * 8ull / interval_.count(), "b/s")),
-      fmt::arg("bandwidthTotalBits",
-               pow_format((bandwidth_up + bandwidth_down) * 8ull / interval_.count(), "b/s")),
-      fmt::arg("bandwidthDownOctets", pow_format(bandwidth_down / interval_.count(), "o/s")),
-      fmt::arg("bandwidthUpOctets", pow_format(bandwidth_up / interval_.count(), "o/s")),
-      fmt::arg("bandwidthTotalOctets",
-               pow_format((bandwidth_up + bandwidth_down) / interval_.count(), "o/s")),
-      fmt::arg("bandwidthDownBytes", pow_format(bandwidth_down / interval_.count(), "B/s")),
-      fmt::arg("bandwidthUpBytes", pow_format(bandwidth_up / interval_.count(), "B/s")),
-      fmt::arg("bandwidthTotalBytes",
-               pow_format((bandwidth_up + bandwidth_down) / interval_.count(), "B/s")));
+  // Snapshot the state for the tooltip, the netlink thread keeps changing it
+  shown_.essid = essid_;
+  shown_.signal_strength_dbm = signal_strength_dbm_;
+  shown_.signal_strength = signal_strength_;
+  shown_.signal_strength_app = signal_strength_app_;
+  shown_.ifname = ifname_;
+  shown_.netmask = netmask_;
+  shown_.ipaddr = ipaddr_;
+  shown_.gwaddr = gwaddr_;
+  shown_.cidr = cidr_;
+  shown_.frequency = frequency_;
+  shown_.icon = shows("icon") ? getIcon(signal_strength_, state_) : std::string();
+  shown_.bandwidth_down = bandwidth_down;
+  shown_.bandwidth_up = bandwidth_up;
+
+  shown_.text = formatShown(format_);
+  const auto &text = shown_.text;
   if (text.compare(label_.get_label()) != 0) {
     label_.set_markup(text);
     if (text.empty()) {
@@ -358,43 +379,38 @@ auto wabar::modules::Network::update() -> void {
       event_box_.show();
     }
   }
-  if (tooltipEnabled()) {
-    if (tooltip_format.empty() && config_["tooltip-format"].isString()) {
-      tooltip_format = config_["tooltip-format"].asString();
-    }
-    if (!tooltip_format.empty()) {
-      auto tooltip_text = fmt::format(
-          fmt::runtime(tooltip_format), fmt::arg("essid", essid_),
-          fmt::arg("signaldBm", signal_strength_dbm_), fmt::arg("signalStrength", signal_strength_),
-          fmt::arg("signalStrengthApp", signal_strength_app_), fmt::arg("ifname", ifname_),
-          fmt::arg("netmask", netmask_), fmt::arg("ipaddr", ipaddr_), fmt::arg("gwaddr", gwaddr_),
-          fmt::arg("cidr", cidr_), fmt::arg("frequency", fmt::format("{:.1f}", frequency_)),
-          fmt::arg("icon", getIcon(signal_strength_, state_)),
-          fmt::arg("bandwidthDownBits",
-                   pow_format(bandwidth_down * 8ull / interval_.count(), "b/s")),
-          fmt::arg("bandwidthUpBits", pow_format(bandwidth_up * 8ull / interval_.count(), "b/s")),
-          fmt::arg("bandwidthTotalBits",
-                   pow_format((bandwidth_up + bandwidth_down) * 8ull / interval_.count(), "b/s")),
-          fmt::arg("bandwidthDownOctets", pow_format(bandwidth_down / interval_.count(), "o/s")),
-          fmt::arg("bandwidthUpOctets", pow_format(bandwidth_up / interval_.count(), "o/s")),
-          fmt::arg("bandwidthTotalOctets",
-                   pow_format((bandwidth_up + bandwidth_down) / interval_.count(), "o/s")),
-          fmt::arg("bandwidthDownBytes", pow_format(bandwidth_down / interval_.count(), "B/s")),
-          fmt::arg("bandwidthUpBytes", pow_format(bandwidth_up / interval_.count(), "B/s")),
-          fmt::arg("bandwidthTotalBytes",
-                   pow_format((bandwidth_up + bandwidth_down) / interval_.count(), "B/s")));
-      if (label_.get_tooltip_text() != tooltip_text) {
-        label_.set_tooltip_markup(tooltip_text);
-      }
-    } else if (label_.get_tooltip_text() != text) {
-      label_.set_tooltip_markup(text);
-    }
+  if (tooltip_format.empty() && config_["tooltip-format"].isString()) {
+    tooltip_format = config_["tooltip-format"].asString();
   }
+  shown_.tooltip_format = std::move(tooltip_format);
 
   // Call parent update
   ALabel::update();
 }
 
+std::string wabar::modules::Network::formatShown(const std::string &format) const {
+  auto down = shown_.bandwidth_down;
+  auto up = shown_.bandwidth_up;
+  return fmt::format(
+      fmt::runtime(format), fmt::arg("essid", shown_.essid),
+      fmt::arg("signaldBm", shown_.signal_strength_dbm),
+      fmt::arg("signalStrength", shown_.signal_strength),
+      fmt::arg("signalStrengthApp", shown_.signal_strength_app), fmt::arg("ifname", shown_.ifname),
+      fmt::arg("netmask", shown_.netmask), fmt::arg("ipaddr", shown_.ipaddr),
+      fmt::arg("gwaddr", shown_.gwaddr), fmt::arg("cidr", shown_.cidr),
+      fmt::arg("frequency", fmt::format("{:.1f}", shown_.frequency)),
+      fmt::arg("icon", shown_.icon),
+      fmt::arg("bandwidthDownBits", pow_format(down * 8ull / interval_.count(), "b/s")),
+      fmt::arg("bandwidthUpBits", pow_format(up * 8ull / interval_.count(), "b/s")),
+      fmt::arg("bandwidthTotalBits", pow_format((up + down) * 8ull / interval_.count(), "b/s")),
+      fmt::arg("bandwidthDownOctets", pow_format(down / interval_.count(), "o/s")),
+      fmt::arg("bandwidthUpOctets", pow_format(up / interval_.count(), "o/s")),
+      fmt::arg("bandwidthTotalOctets", pow_format((up + down) / interval_.count(), "o/s")),
+      fmt::arg("bandwidthDownBytes", pow_format(down / interval_.count(), "B/s")),
+      fmt::arg("bandwidthUpBytes", pow_format(up / interval_.count(), "B/s")),
+      fmt::arg("bandwidthTotalBytes", pow_format((up + down) / interval_.count(), "B/s")));
+}
+
 bool wabar::modules::Network::checkInterface(std::string name) {
   if (config_["interface"].isString()) {
     return config_["interface"].asString() == name ||
@@ -477,7 +493,7 @@ int wabar::modules::Network::handleEvents(struct nl_msg *msg, void *data) {
           if (net->carrier_ != *carrier) {
             if (*carrier) {
               // Ask for WiFi information
-              net->thread_timer_.wake_up();
+              net->timer_.wake_up();
             } else {
               // clear state related to WiFi connection
               net->essid_.clear();
@@ -501,7 +517,7 @@ int wabar::modules::Network::handleEvents(struct nl_msg *msg, void *data) {
           if (carrier.has_value()) {
             net->carrier_ = carrier.value();
           }
-          net->thread_timer_.wake_up();
+          net->timer_.wake_up();
           /* An address for this new interface should be received via an
            * RTM_NEWADDR event either because we ask for a dump of both links
            * and addrs, or because this interface has just been created and
@@ -684,7 +700,7 @@ int wabar::modules::Network::handleEvents(struct nl_msg *msg, void *data) {
            * addresses. */
           net->want_addr_dump_ = true;
           net->askForStateDump();
-          net->thread_timer_.wake_up();
+          net->timer_.wake_up();
         } else if (is_del_event && temp_idx == net->ifid_ && net->route_priority == priority) {
           spdlog::debug("network: default route deleted {}/if{} metric {}", net->ifname_, temp_idx,
                         priority);
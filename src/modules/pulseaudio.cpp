@@ -7,6 +7,21 @@ wabar::modules::Pulseaudio::Pulseaudio(const std::string &id, const Json::Value
 
   backend = util::AudioBackend::getInstance([this] { this->dp.emit(); });
   backend->setIgnoredSinks(config_["ignored-sinks"]);
+
+  if (tooltipEnabled()) {
+    setTooltipCallback([this]() -> std::string {
+      if (!config_["tooltip-format"].isString() || config_["tooltip-format"].asString().empty()) {
+        return tooltip_.sink_desc;
+      }
+      return fmt::format(fmt::runtime(config_["tooltip-format"].asString()),
+                         fmt::arg("desc", tooltip_.sink_desc),
+                         fmt::arg("volume", tooltip_.sink_volume),
+                         fmt::arg("format_source", tooltip_.format_source),
+                         fmt::arg("source_volume", tooltip_.source_volume),
+                         fmt::arg("source_desc", tooltip_.source_desc),
+                         fmt::arg("icon", tooltip_.icon));
+    });
+  }
 }
 
 bool wabar::modules::Pulseaudio::handleScroll(GdkEventScroll *e) {
@@ -56,7 +71,6 @@ const std::vector<std::string> wabar::modules::Pulseaudio::getPulseIcon() const
 
 auto wabar::modules::Pulseaudio::update() -> void {
   auto format = format_;
-  std::string tooltip_format;
   auto sink_volume = backend->getSinkVolume();
   if (!alt_) {
     std::string format_name = "format";
@@ -104,10 +118,11 @@ auto wabar::modules::Pulseaudio::update() -> void {
   auto source_desc = backend->getSourceDesc();
 
   format_source = fmt::format(fmt::runtime(format_source), fmt::arg("volume", source_volume));
+  auto icon = getIcon(sink_volume, getPulseIcon());
   auto text = fmt::format(
       fmt::runtime(format), fmt::arg("desc", sink_desc), fmt::arg("volume", sink_volume),
       fmt::arg("format_source", format_source), fmt::arg("source_volume", source_volume),
-      fmt::arg("source_desc", source_desc), fmt::arg("icon", getIcon(sink_volume, getPulseIcon())));
+      fmt::arg("source_desc", source_desc), fmt::arg("icon", icon));
   if (text.empty()) {
     label_.hide();
   } else {
@@ -115,20 +130,13 @@ auto wabar::modules::Pulseaudio::update() -> void {
     label_.show();
   }
 
-  if (tooltipEnabled()) {
-    if (tooltip_format.empty() && config_["tooltip-format"].isString()) {
-      tooltip_format = config_["tooltip-format"].asString();
-    }
-    if (!tooltip_format.empty()) {
-      label_.set_tooltip_text(fmt::format(
-          fmt::runtime(tooltip_format), fmt::arg("desc", sink_desc),
-          fmt::arg("volume", sink_volume), fmt::arg("format_source", format_source),
-          fmt::arg("source_volume", source_volume), fmt::arg("source_desc", source_desc),
-          fmt::arg("icon", getIcon(sink_volume, getPulseIcon()))));
-    } else {
-      label_.set_tooltip_text(sink_desc);
-    }
-  }
+  // The backend keeps changing, the tooltip shows what the label does
+  tooltip_.sink_volume = sink_volume;
+  tooltip_.source_volume = source_volume;
+  tooltip_.sink_desc = std::move(sink_desc);
+  tooltip_.source_desc = std::move(source_desc);
+  tooltip_.format_source = std::move(format_source);
+  tooltip_.icon = std::move(icon);
 
   // Call parent update
   ALabel::update();
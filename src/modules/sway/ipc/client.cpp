@@ -48,6 +48,7 @@ const std::string Ipc::getSocketPath() const {
     if ((in = popen("sway --get-socketpath 2>/dev/null", "r")) == nullptr) {
       throw std::runtime_error("Failed to get socket path");
     }
+    util::Metrics::processSpawned();
     while (fgets(buf, sizeof(buf), in) != nullptr) {
       str_buf.append(buf, sizeof(buf));
     }
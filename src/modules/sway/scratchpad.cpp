@@ -60,14 +60,18 @@ auto Scratchpad::getTree() -> void {
 auto Scratchpad::onCmd(const struct Ipc::ipc_response& res) -> void {
   try {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto tree = parser_.parse(res.payload);
-    count_ = tree["nodes"][0]["nodes"][0]["floating_nodes"].size();
+    auto tree = Tree::decode(res.payload);
+    // The scratchpad is the only workspace of the hidden "__i3" output
+    auto outputs = tree->nodes(tree->root());
+    auto workspaces = outputs.empty() ? outputs : tree->nodes(outputs[0]);
+    auto windows = workspaces.empty() ? workspaces : tree->floatingNodes(workspaces[0]);
+    count_ = windows.size();
     if (tooltip_enabled_) {
       tooltip_text_.clear();
-      for (const auto& window : tree["nodes"][0]["nodes"][0]["floating_nodes"]) {
+      for (const auto& window : windows) {
         tooltip_text_.append(fmt::format(fmt::runtime(tooltip_format_ + '\n'),
-                                         fmt::arg("app", window["app_id"].asString()),
-                                         fmt::arg("title", window["name"].asString())));
+                                         fmt::arg("app", window.app_id),
+                                         fmt::arg("title", window.name)));
       }
       if (!tooltip_text_.empty()) {
         tooltip_text_.pop_back();
@@ -0,0 +1,461 @@
+#include "modules/sway/tree.hpp"
+
+#include <charconv>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+namespace wabar::modules::sway {
+
+/**
+ * Scans a GET_TREE reply in one pass, filling a Tree with the containers as they are met.
+ *
+ * Values of the fields Node doesn't have are skipped over without being checked.
+ */
+class TreeDecoder {
+ public:
+  TreeDecoder(std::string_view payload, Tree &tree)
+      : begin_(payload.data()), p_(begin_), end_(begin_ + payload.size()), tree_(tree) {}
+
+  void decode() {
+    // Unescaping never makes a string longer, so the strings fit in the size of the reply
+    tree_.strings_.reserve(end_ - begin_);
+    skipSpace();
+    node(0);
+    skipSpace();
+    if (p_ != end_) {
+      fail("trailing data");
+    }
+  }
+
+ private:
+  uint32_t node(int depth);
+  void children(int depth, size_t list);
+  void rect(Node::Rect &rect);
+  void windowProperties(Node &node);
+
+  std::string_view key();
+  std::string_view string();
+  void stringField(std::string_view &field);
+  template <typename T>
+  void integerField(T &field);
+  void boolField(bool &field);
+  void skipValue();
+  void skipString();
+
+  void unescape(std::string &out);
+  uint32_t hex(int digits);
+  static void appendUtf8(std::string &out, uint32_t code_point);
+
+  void skipSpace() {
+    while (p_ != end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) {
+      ++p_;
+    }
+  }
+  char peek() {
+    skipSpace();
+    if (p_ == end_) {
+      fail("unexpected end");
+    }
+    return *p_;
+  }
+  bool consume(char c) {
+    if (peek() != c) {
+      return false;
+    }
+    ++p_;
+    return true;
+  }
+  void expect(char c) {
+    if (!consume(c)) {
+      fail(std::string("expected '") + c + "'");
+    }
+  }
+  [[noreturn]] void fail(const std::string &what) const {
+    throw std::runtime_error("Invalid sway tree at offset " + std::to_string(p_ - begin_) + ": " +
+                             what);
+  }
+
+  const char *const begin_;
+  const char *p_;
+  const char *const end_;
+  Tree &tree_;
+  // Children of the nodes being decoded, tiled then floating for each depth
+  std::vector<std::vector<uint32_t>> pending_;
+  std::string key_;
+};
+
+uint32_t TreeDecoder::node(int depth) {
+  if (depth >= Tree::MAX_DEPTH) {
+    fail("containers nested too deep");
+  }
+  // The node is filled once its children are in, as they may move the array
+  auto index = static_cast<uint32_t>(tree_.nodes_.size());
+  tree_.nodes_.emplace_back();
+  size_t tiled = 2 * depth;
+  size_t floating = tiled + 1;
+  if (pending_.size() <= floating) {
+    pending_.resize(floating + 1);
+  }
+  pending_[tiled].clear();
+  pending_[floating].clear();
+
+  Node node;
+  expect('{');
+  if (!consume('}')) {
+    do {
+      auto name = key();
+      expect(':');
+      if (name == "id") {
+        integerField(node.id);
+      } else if (name == "type") {
+        stringField(node.type);
+      } else if (name == "name") {
+        stringField(node.name);
+      } else if (name == "app_id") {
+        stringField(node.app_id);
+      } else if (name == "shell") {
+        stringField(node.shell);
+      } else if (name == "layout") {
+        stringField(node.layout);
+      } else if (name == "output") {
+        stringField(node.output);
+      } else if (name == "current_workspace") {
+        stringField(node.current_workspace);
+      } else if (name == "num") {
+        integerField(node.num);
+      } else if (name == "focused") {
+        boolField(node.focused);
+      } else if (name == "visible") {
+        boolField(node.visible);
+      } else if (name == "urgent") {
+        boolField(node.urgent);
+      } else if (name == "rect") {
+        rect(node.rect);
+      } else if (name == "window_properties") {
+        windowProperties(node);
+      } else if (name == "nodes") {
+        children(depth, tiled);
+      } else if (name == "floating_nodes") {
+        children(depth, floating);
+      } else {
+        skipValue();
+      }
+    } while (consume(','));
+    expect('}');
+  }
+
+  auto &children = tree_.children_;
+  node.children = static_cast<uint32_t>(children.size());
+  node.nodes_count = static_cast<uint32_t>(pending_[tiled].size());
+  node.floating_nodes_count = static_cast<uint32_t>(pending_[floating].size());
+  children.insert(children.end(), pending_[tiled].begin(), pending_[tiled].end());
+  children.insert(children.end(), pending_[floating].begin(), pending_[floating].end());
+  tree_.nodes_[index] = node;
+  return index;
+}
+
+void TreeDecoder::children(int depth, size_t list) {
+  if (peek() != '[') {
+    skipValue();
+    return;
+  }
+  ++p_;
+  if (consume(']')) {
+    return;
+  }
+  do {
+    // Indexed after the call, the child may grow pending_
+    auto child = node(depth + 1);
+    pending_[list].push_back(child);
+  } while (consume(','));
+  expect(']');
+}
+
+void TreeDecoder::rect(Node::Rect &rect) {
+  if (peek() != '{') {
+    skipValue();
+    return;
+  }
+  ++p_;
+  if (consume('}')) {
+    return;
+  }
+  do {
+    auto name = key();
+    expect(':');
+    if (name == "x") {
+      integerField(rect.x);
+    } else if (name == "y") {
+      integerField(rect.y);
+    } else if (name == "width") {
+      integerField(rect.width);
+    } else if (name == "height") {
+      integerField(rect.height);
+    } else {
+      skipValue();
+    }
+  } while (consume(','));
+  expect('}');
+}
+
+void TreeDecoder::windowProperties(Node &node) {
+  if (peek() != '{') {
+    skipValue();
+    return;
+  }
+  ++p_;
+  if (consume('}')) {
+    return;
+  }
+  do {
+    auto name = key();
+    expect(':');
+    if (name == "class") {
+      stringField(node.window_class);
+    } else if (name == "instance") {
+      stringField(node.window_instance);
+    } else {
+      skipValue();
+    }
+  } while (consume(','));
+  expect('}');
+}
+
+std::string_view TreeDecoder::key() {
+  if (peek() != '"') {
+    fail("expected a key");
+  }
+  const char *begin = ++p_;
+  while (p_ != end_ && *p_ != '"' && *p_ != '\\') {
+    ++p_;
+  }
+  if (p_ == end_) {
+    fail("unterminated key");
+  }
+  if (*p_ == '"') {
+    return {begin, static_cast<size_t>(p_++ - begin)};
+  }
+  // Keys are plain in practice, escaped ones are unescaped aside
+  key_.assign(begin, p_);
+  unescape(key_);
+  return key_;
+}
+
+std::string_view TreeDecoder::string() {
+  ++p_;
+  auto &strings = tree_.strings_;
+  auto offset = strings.size();
+  unescape(strings);
+  return {strings.data() + offset, strings.size() - offset};
+}
+
+void TreeDecoder::stringField(std::string_view &field) {
+  if (peek() == '"') {
+    field = string();
+  } else {
+    skipValue();
+  }
+}
+
+template <typename T>
+void TreeDecoder::integerField(T &field) {
+  char c = peek();
+  if (c != '-' && (c < '0' || c > '9')) {
+    skipValue();
+    return;
+  }
+  auto [end, ec] = std::from_chars(p_, end_, field);
+  if (ec != std::errc()) {
+    fail("invalid integer");
+  }
+  p_ = end;
+  // Fractions and exponents are dropped
+  skipValue();
+}
+
+void TreeDecoder::boolField(bool &field) {
+  peek();
+  if (end_ - p_ >= 4 && std::memcmp(p_, "true", 4) == 0) {
+    field = true;
+    p_ += 4;
+  } else if (end_ - p_ >= 5 && std::memcmp(p_, "false", 5) == 0) {
+    field = false;
+    p_ += 5;
+  } else {
+    skipValue();
+  }
+}
+
+void TreeDecoder::skipValue() {
+  char c = peek();
+  if (c == '"') {
+    skipString();
+    return;
+  }
+  if (c != '{' && c != '[') {
+    // Numbers and literals
+    while (p_ != end_ && std::strchr(",:]} \n\r\t", *p_) == nullptr) {
+      ++p_;
+    }
+    return;
+  }
+  int depth = 0;
+  do {
+    if (p_ == end_) {
+      fail("unexpected end");
+    }
+    c = *p_;
+    if (c == '"') {
+      skipString();
+      continue;
+    }
+    if (c == '{' || c == '[') {
+      ++depth;
+    } else if (c == '}' || c == ']') {
+      --depth;
+    }
+    ++p_;
+  } while (depth > 0);
+}
+
+void TreeDecoder::skipString() {
+  ++p_;
+  while (p_ < end_ && *p_ != '"') {
+    // A backslash ending the reply has nothing to escape
+    if (*p_ == '\\' && p_ == end_ - 1) {
+      break;
+    }
+    p_ += *p_ == '\\' ? 2 : 1;
+  }
+  if (p_ >= end_ || *p_ != '"') {
+    fail("unterminated string");
+  }
+  ++p_;
+}
+
+// Append the string starting at p_ to `out` unescaped, up to and past its closing quote
+void TreeDecoder::unescape(std::string &out) {
+  while (true) {
+    const char *begin = p_;
+    while (p_ != end_ && *p_ != '"' && *p_ != '\\') {
+      ++p_;
+    }
+    out.append(begin, p_);
+    if (p_ == end_) {
+      fail("unterminated string");
+    }
+    if (*p_++ == '"') {
+      return;
+    }
+    if (p_ == end_) {
+      fail("unterminated string");
+    }
+    switch (char c = *p_++) {
+      case '"':
+      case '\\':
+      case '/':
+        out.push_back(c);
+        break;
+      case 'b':
+        out.push_back('\b');
+        break;
+      case 'f':
+        out.push_back('\f');
+        break;
+      case 'n':
+        out.push_back('\n');
+        break;
+      case 'r':
+        out.push_back('\r');
+        break;
+      case 't':
+        out.push_back('\t');
+        break;
+      case 'x':
+        // Raw bytes of a name that isn't UTF-8, read as Latin-1 like JsonParser does
+        appendUtf8(out, hex(2));
+        break;
+      case 'u': {
+        auto code_point = hex(4);
+        if (code_point >= 0xD800 && code_point < 0xDC00) {
+          if (end_ - p_ < 6 || p_[0] != '\\' || p_[1] != 'u') {
+            fail("unpaired surrogate");
+          }
+          p_ += 2;
+          auto low = hex(4);
+          if (low < 0xDC00 || low >= 0xE000) {
+            fail("unpaired surrogate");
+          }
+          code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+        }
+        appendUtf8(out, code_point);
+        break;
+      }
+      default:
+        fail("invalid escape");
+    }
+  }
+}
+
+uint32_t TreeDecoder::hex(int digits) {
+  if (end_ - p_ < digits) {
+    fail("unterminated string");
+  }
+  uint32_t value = 0;
+  auto [end, ec] = std::from_chars(p_, p_ + digits, value, 16);
+  if (ec != std::errc() || end != p_ + digits) {
+    fail("invalid escape");
+  }
+  p_ = end;
+  return value;
+}
+
+void TreeDecoder::appendUtf8(std::string &out, uint32_t code_point) {
+  if (code_point < 0x80) {
+    out.push_back(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    out.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+    out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else if (code_point < 0x10000) {
+    out.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+    out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else {
+    out.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+    out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  }
+}
+
+Tree::Tree(std::string_view payload) { TreeDecoder(payload, *this).decode(); }
+
+std::shared_ptr<const Tree> Tree::decode(const std::string &payload) {
+  static std::mutex mutex;
+  static std::string last_payload;
+  static std::shared_ptr<const Tree> last;
+
+  // Held while decoding, so modules asking at once wait for the first one instead of decoding too
+  std::lock_guard lock(mutex);
+  if (last && payload == last_payload) {
+    return last;
+  }
+  last = std::make_shared<const Tree>(payload);
+  last_payload = payload;
+  return last;
+}
+
+bool Tree::hasFlag(const Node &node, bool Node::*flag) const {
+  if (node.*flag) {
+    return true;
+  }
+  for (const auto &child : allNodes(node)) {
+    if (hasFlag(child, flag)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace wabar::modules::sway
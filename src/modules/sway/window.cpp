@@ -39,10 +39,10 @@ void Window::onEvent(const struct Ipc::ipc_response& res) { getTree(); }
 void Window::onCmd(const struct Ipc::ipc_response& res) {
   try {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto payload = parser_.parse(res.payload);
-    auto output = payload["output"].isString() ? payload["output"].asString() : "";
+    auto tree = Tree::decode(res.payload);
+    std::string output(tree->root().output);
     std::tie(app_nb_, floating_count_, windowId_, window_, app_id_, app_class_, shell_, layout_) =
-        getFocusedNode(payload["nodes"], output);
+        getFocusedNode(*tree, output);
     updateAppIconName(app_id_, app_class_);
     dp.emit();
   } catch (const std::exception& e) {
@@ -118,13 +118,13 @@ void Window::setClass(std::string classname, bool enable) {
   }
 }
 
-std::pair<int, int> leafNodesInWorkspace(const Json::Value& node) {
-  auto const& nodes = node["nodes"];
-  auto const& floating_nodes = node["floating_nodes"];
+std::pair<int, int> leafNodesInWorkspace(const Tree& tree, const Node& node) {
+  auto nodes = tree.nodes(node);
+  auto floating_nodes = tree.floatingNodes(node);
   if (nodes.empty() && floating_nodes.empty()) {
-    if (node["type"].asString() == "workspace")
+    if (node.type == "workspace")
       return {0, 0};
-    else if (node["type"].asString() == "floating_con") {
+    else if (node.type == "floating_con") {
       return {0, 1};
     } else {
       return {1, 0};
@@ -132,103 +132,84 @@ std::pair<int, int> leafNodesInWorkspace(const Json::Value& node) {
   }
   int sum = 0;
   int floating_sum = 0;
-  for (auto const& node : nodes) {
-    std::pair all_leaf_nodes = leafNodesInWorkspace(node);
-    sum += all_leaf_nodes.first;
-    floating_sum += all_leaf_nodes.second;
-  }
-  for (auto const& node : floating_nodes) {
-    std::pair all_leaf_nodes = leafNodesInWorkspace(node);
+  for (auto const& node : tree.allNodes(node)) {
+    std::pair all_leaf_nodes = leafNodesInWorkspace(tree, node);
     sum += all_leaf_nodes.first;
     floating_sum += all_leaf_nodes.second;
   }
   return {sum, floating_sum};
 }
 
-std::optional<std::reference_wrapper<const Json::Value>> getSingleChildNode(
-    const Json::Value& node) {
-  auto const& nodes = node["nodes"];
+const Node* getSingleChildNode(const Tree& tree, const Node& node) {
+  auto nodes = tree.nodes(node);
   if (nodes.empty()) {
-    if (node["type"].asString() == "workspace")
-      return {};
-    else if (node["type"].asString() == "floating_con") {
-      return {};
-    } else {
-      return {std::cref(node)};
+    if (node.type == "workspace" || node.type == "floating_con") {
+      return nullptr;
     }
+    return &node;
   }
-  auto it = std::cbegin(nodes);
-  if (it == std::cend(nodes)) {
-    return {};
-  }
-  auto const& child = *it;
-  ++it;
-  if (it != std::cend(nodes)) {
-    return {};
+  if (nodes.size() != 1) {
+    return nullptr;
   }
-  return {getSingleChildNode(child)};
+  return getSingleChildNode(tree, nodes[0]);
 }
 
-std::tuple<std::string, std::string, std::string> getWindowInfo(const Json::Value& node) {
-  const auto app_id = node["app_id"].isString() ? node["app_id"].asString()
-                                                : node["window_properties"]["instance"].asString();
-  const auto app_class = node["window_properties"]["class"].isString()
-                             ? node["window_properties"]["class"].asString()
-                             : "";
-  const auto shell = node["shell"].isString() ? node["shell"].asString() : "";
+std::tuple<std::string, std::string, std::string> getWindowInfo(const Node& node) {
+  std::string app_id(node.app_id.data() != nullptr ? node.app_id : node.window_instance);
+  std::string app_class(node.window_class);
+  std::string shell(node.shell);
   return {app_id, app_class, shell};
 }
 
 std::tuple<std::size_t, int, int, std::string, std::string, std::string, std::string, std::string>
-gfnWithWorkspace(const Json::Value& nodes, std::string& output, const Json::Value& config_,
-                 const Bar& bar_, Json::Value& parentWorkspace,
-                 const Json::Value& immediateParent) {
+gfnWithWorkspace(const Tree& tree, Tree::Children nodes, std::string& output,
+                 const Json::Value& config_, const Bar& bar_, const Node*& parentWorkspace,
+                 const Node* const& immediateParent) {
   for (auto const& node : nodes) {
-    if (node["type"].asString() == "output") {
+    if (node.type == "output") {
       if ((!config_["all-outputs"].asBool() || config_["offscreen-css"].asBool()) &&
-          (node["name"].asString() != bar_.output->name)) {
+          (node.name != bar_.output->name)) {
         continue;
       }
-      output = node["name"].asString();
-    } else if (node["type"].asString() == "workspace") {
+      output = node.name;
+    } else if (node.type == "workspace") {
       // needs to be a string comparison, because filterWorkspace is the current_workspace
-      if (node["name"].asString() != immediateParent["current_workspace"].asString()) {
+      if (immediateParent == nullptr || node.name != immediateParent->current_workspace) {
         continue;
       }
-      if (node["focused"].asBool()) {
-        std::pair all_leaf_nodes = leafNodesInWorkspace(node);
+      if (node.focused) {
+        std::pair all_leaf_nodes = leafNodesInWorkspace(tree, node);
         return {all_leaf_nodes.first,
                 all_leaf_nodes.second,
-                node["id"].asInt(),
+                static_cast<int>(node.id),
                 (((all_leaf_nodes.first > 0) || (all_leaf_nodes.second > 0)) &&
                  (config_["show-focused-workspace-name"].asBool()))
-                    ? node["name"].asString()
+                    ? std::string(node.name)
                     : "",
                 "",
                 "",
                 "",
-                node["layout"].asString()};
+                std::string(node.layout)};
       }
-      parentWorkspace = node;
-    } else if ((node["type"].asString() == "con" || node["type"].asString() == "floating_con") &&
-               (node["focused"].asBool())) {
+      parentWorkspace = &node;
+    } else if ((node.type == "con" || node.type == "floating_con") && node.focused) {
       // found node
       spdlog::trace("actual output {}, output found {}, node (focused) found {}", bar_.output->name,
-                    output, node["name"].asString());
+                    output, node.name);
       const auto [app_id, app_class, shell] = getWindowInfo(node);
-      int nb = node.size();
+      int nb = 1;
       int floating_count = 0;
       std::string workspace_layout = "";
-      if (!parentWorkspace.isNull()) {
-        std::pair all_leaf_nodes = leafNodesInWorkspace(parentWorkspace);
+      if (parentWorkspace != nullptr) {
+        std::pair all_leaf_nodes = leafNodesInWorkspace(tree, *parentWorkspace);
         nb = all_leaf_nodes.first;
         floating_count = all_leaf_nodes.second;
-        workspace_layout = parentWorkspace["layout"].asString();
+        workspace_layout = parentWorkspace->layout;
       }
       return {nb,
               floating_count,
-              node["id"].asInt(),
-              Glib::Markup::escape_text(node["name"].asString()),
+              static_cast<int>(node.id),
+              Glib::Markup::escape_text(std::string(node.name)),
               app_id,
               app_class,
               shell,
@@ -236,10 +217,10 @@ gfnWithWorkspace(const Json::Value& nodes, std::string& output, const Json::Valu
     }
 
     // iterate
-    auto [nb, f, id, name, app_id, app_class, shell, workspace_layout] =
-        gfnWithWorkspace(node["nodes"], output, config_, bar_, parentWorkspace, node);
-    auto [nb2, f2, id2, name2, app_id2, app_class2, shell2, workspace_layout2] =
-        gfnWithWorkspace(node["floating_nodes"], output, config_, bar_, parentWorkspace, node);
+    auto [nb, f, id, name, app_id, app_class, shell, workspace_layout] = gfnWithWorkspace(
+        tree, tree.nodes(node), output, config_, bar_, parentWorkspace, &node);
+    auto [nb2, f2, id2, name2, app_id2, app_class2, shell2, workspace_layout2] = gfnWithWorkspace(
+        tree, tree.floatingNodes(node), output, config_, bar_, parentWorkspace, &node);
 
     //    if ((id > 0 || ((id2 < 0 || name2.empty()) && id > -1)) && !name.empty()) {
     if ((id > 0) || (id2 < 0 && id > -1)) {
@@ -251,17 +232,17 @@ gfnWithWorkspace(const Json::Value& nodes, std::string& output, const Json::Valu
 
   // this only comes into effect when no focused children are present
   if (config_["all-outputs"].asBool() && config_["offscreen-css"].asBool() &&
-      immediateParent["type"].asString() == "workspace") {
-    std::pair all_leaf_nodes = leafNodesInWorkspace(immediateParent);
+      immediateParent != nullptr && immediateParent->type == "workspace") {
+    std::pair all_leaf_nodes = leafNodesInWorkspace(tree, *immediateParent);
     // using an empty string as default ensures that no window depending styles are set due to the
     // checks above for !name.empty()
     std::string app_id = "";
     std::string app_class = "";
     std::string workspace_layout = "";
     if (all_leaf_nodes.first == 1) {
-      const auto single_child = getSingleChildNode(immediateParent);
-      if (single_child.has_value()) {
-        std::tie(app_id, app_class, workspace_layout) = getWindowInfo(single_child.value());
+      const auto* single_child = getSingleChildNode(tree, *immediateParent);
+      if (single_child != nullptr) {
+        std::tie(app_id, app_class, workspace_layout) = getWindowInfo(*single_child);
       }
     }
     return {all_leaf_nodes.first,
@@ -273,16 +254,18 @@ gfnWithWorkspace(const Json::Value& nodes, std::string& output, const Json::Valu
             app_id,
             app_class,
             workspace_layout,
-            immediateParent["layout"].asString()};
+            std::string(immediateParent->layout)};
   }
 
   return {0, 0, -1, "", "", "", "", ""};
 }
 
 std::tuple<std::size_t, int, int, std::string, std::string, std::string, std::string, std::string>
-Window::getFocusedNode(const Json::Value& nodes, std::string& output) {
-  Json::Value placeholder = Json::Value::null;
-  return gfnWithWorkspace(nodes, output, config_, bar_, placeholder, placeholder);
+Window::getFocusedNode(const Tree& tree, std::string& output) {
+  // Also the parent of the outputs, so that the last workspace met gets the offscreen-css fallback
+  const Node* workspace = nullptr;
+  return gfnWithWorkspace(tree, tree.nodes(tree.root()), output, config_, bar_, workspace,
+                          workspace);
 }
 
 void Window::getTree() {
@@ -45,12 +45,25 @@ int Workspaces::windowRewritePriorityFunction(std::string const &window_rule) {
 Workspaces::Workspaces(const std::string &id, const Bar &bar, const Json::Value &config)
     : AModule(config, "workspaces", id, false, !config["disable-scroll"].asBool()),
       bar_(bar),
+      all_outputs_(config["all-outputs"].asBool()),
+      disable_markup_(config["disable-markup"].asBool()),
+      show_windows_(config["window-format"].isString()),
       box_(bar.orientation, 0) {
   if (config["format-icons"]["high-priority-named"].isArray()) {
     for (auto &it : config["format-icons"]["high-priority-named"]) {
       high_priority_named_.push_back(it.asString());
     }
   }
+  if (config["format-icons"].isObject()) {
+    for (const auto &key : config["format-icons"].getMemberNames()) {
+      if (config["format-icons"][key].isString()) {
+        icons_.emplace(key, config["format-icons"][key].asString());
+      }
+    }
+  }
+  if (config["format"].isString()) {
+    format_ = config["format"].asString();
+  }
   box_.set_name("workspaces");
   if (!id.empty()) {
     box_.get_style_context()->add_class(id);
@@ -104,26 +117,17 @@ void Workspaces::onCmd(const struct Ipc::ipc_response &res) {
     try {
       {
         std::lock_guard<std::mutex> lock(mutex_);
-        auto payload = parser_.parse(res.payload);
+        // Workspaces point into the tree, which is kept until the next one
+        tree_ = Tree::decode(res.payload);
         workspaces_.clear();
-        std::vector<Json::Value> outputs;
-        bool alloutputs = config_["all-outputs"].asBool();
-        std::copy_if(payload["nodes"].begin(), payload["nodes"].end(), std::back_inserter(outputs),
-                     [&](const auto &output) {
-                       if (alloutputs && output["name"].asString() != "__i3") {
-                         return true;
-                       }
-                       if (output["name"].asString() == bar_.output->name) {
-                         return true;
-                       }
-                       return false;
-                     });
-
-        for (auto &output : outputs) {
-          std::copy(output["nodes"].begin(), output["nodes"].end(),
-                    std::back_inserter(workspaces_));
-          std::copy(output["floating_nodes"].begin(), output["floating_nodes"].end(),
-                    std::back_inserter(workspaces_));
+        bool alloutputs = all_outputs_;
+        for (const auto &output : tree_->nodes(tree_->root())) {
+          if ((!alloutputs || output.name == "__i3") && output.name != bar_.output->name) {
+            continue;
+          }
+          for (const auto &workspace : tree_->allNodes(output)) {
+            workspaces_.push_back({std::string(workspace.name), workspace.num, 0, {}, &workspace});
+          }
         }
         if (config_["persistent_workspaces"].isObject()) {
           spdlog::warn(
@@ -141,10 +145,9 @@ void Workspaces::onCmd(const struct Ipc::ipc_response &res) {
 
           for (const std::string &p_w_name : p_workspaces_names) {
             const Json::Value &p_w = p_workspaces[p_w_name];
-            auto it = std::find_if(workspaces_.begin(), workspaces_.end(),
-                                   [&p_w_name](const Json::Value &node) {
-                                     return node["name"].asString() == p_w_name;
-                                   });
+            auto it = std::find_if(
+                workspaces_.begin(), workspaces_.end(),
+                [&p_w_name](const Workspace &workspace) { return workspace.name == p_w_name; });
 
             if (it != workspaces_.end()) {
               continue;  // already displayed by some bar
@@ -154,21 +157,14 @@ void Workspaces::onCmd(const struct Ipc::ipc_response &res) {
               // Adding to target outputs
               for (const Json::Value &output : p_w) {
                 if (output.asString() == bar_.output->name) {
-                  Json::Value v;
-                  v["name"] = p_w_name;
-                  v["target_output"] = bar_.output->name;
-                  v["num"] = convertWorkspaceNameToNum(p_w_name);
-                  workspaces_.emplace_back(std::move(v));
+                  workspaces_.push_back(
+                      {p_w_name, convertWorkspaceNameToNum(p_w_name), 0, bar_.output->name});
                   break;
                 }
               }
             } else {
               // Adding to all outputs
-              Json::Value v;
-              v["name"] = p_w_name;
-              v["target_output"] = "";
-              v["num"] = convertWorkspaceNameToNum(p_w_name);
-              workspaces_.emplace_back(std::move(v));
+              workspaces_.push_back({p_w_name, convertWorkspaceNameToNum(p_w_name), 0, ""});
             }
           }
         }
@@ -196,22 +192,21 @@ void Workspaces::onCmd(const struct Ipc::ipc_response &res) {
         // the order displayed in Wabar.
         int max_num = -1;
         for (auto &workspace : workspaces_) {
-          max_num = std::max(workspace["num"].asInt(), max_num);
+          max_num = std::max(workspace.num, max_num);
         }
         for (auto &workspace : workspaces_) {
-          auto workspace_num = workspace["num"].asInt();
-          if (workspace_num > -1) {
-            workspace["sort"] = workspace_num;
+          if (workspace.num > -1) {
+            workspace.sort = workspace.num;
           } else {
-            workspace["sort"] = ++max_num;
+            workspace.sort = ++max_num;
           }
         }
         std::sort(workspaces_.begin(), workspaces_.end(),
-                  [this](const Json::Value &lhs, const Json::Value &rhs) {
-                    auto lname = lhs["name"].asString();
-                    auto rname = rhs["name"].asString();
-                    int l = lhs["sort"].asInt();
-                    int r = rhs["sort"].asInt();
+                  [this](const Workspace &lhs, const Workspace &rhs) {
+                    const auto &lname = lhs.name;
+                    const auto &rname = rhs.name;
+                    int l = lhs.sort;
+                    int r = rhs.sort;
 
                     if (l == r || config_["alphabetical_sort"].asBool()) {
                       // In case both integers are the same, lexicographical
@@ -237,9 +232,9 @@ bool Workspaces::filterButtons() {
   bool needReorder = false;
   for (auto it = buttons_.begin(); it != buttons_.end();) {
     auto ws = std::find_if(workspaces_.begin(), workspaces_.end(),
-                           [it](const auto &node) { return node["name"].asString() == it->first; });
+                           [it](const auto &workspace) { return workspace.name == it->first; });
     if (ws == workspaces_.end() ||
-        (!config_["all-outputs"].asBool() && (*ws)["output"].asString() != bar_.output->name)) {
+        (!all_outputs_ && outputOf(*ws) != bar_.output->name)) {
       it = buttons_.erase(it);
       needReorder = true;
     } else {
@@ -249,28 +244,22 @@ bool Workspaces::filterButtons() {
   return needReorder;
 }
 
-bool Workspaces::hasFlag(const Json::Value &node, const std::string &flag) {
-  if (node[flag].asBool()) {
-    return true;
-  }
+bool Workspaces::hasFlag(const Workspace &workspace, bool Node::*flag) const {
+  return workspace.node != nullptr && tree_->hasFlag(*workspace.node, flag);
+}
 
-  if (std::any_of(node["nodes"].begin(), node["nodes"].end(),
-                  [&](auto const &e) { return hasFlag(e, flag); })) {
-    return true;
-  }
-  if (std::any_of(node["floating_nodes"].begin(), node["floating_nodes"].end(),
-                  [&](auto const &e) { return hasFlag(e, flag); })) {
-    return true;
-  }
-  return false;
+bool Workspaces::isEmpty(const Workspace &workspace) const {
+  return workspace.node == nullptr || tree_->allNodes(*workspace.node).empty();
+}
+
+std::string_view Workspaces::outputOf(const Workspace &workspace) {
+  return workspace.node != nullptr ? workspace.node->output : std::string_view();
 }
 
-void Workspaces::updateWindows(const Json::Value &node, std::string &windows) {
-  auto format = config_["window-format"].asString();
-  if ((node["type"].asString() == "con" || node["type"].asString() == "floating_con") &&
-      node["name"].isString()) {
-    std::string title = g_markup_escape_text(node["name"].asString().c_str(), -1);
-    std::string windowClass = node["app_id"].asString();
+void Workspaces::updateWindows(const Node &node, std::string &windows) {
+  if ((node.type == "con" || node.type == "floating_con") && node.name.data() != nullptr) {
+    std::string title = g_markup_escape_text(node.name.data(), node.name.size());
+    std::string windowClass(node.app_id);
     std::string windowReprKey = fmt::format("class<{}> title<{}>", windowClass, title);
     std::string window = m_windowRewriteRules.get(windowReprKey);
     // allow result to have formatting
@@ -279,10 +268,7 @@ void Workspaces::updateWindows(const Json::Value &node, std::string &windows) {
     windows.append(window);
     windows.append(m_formatWindowSeperator);
   }
-  for (const Json::Value &child : node["nodes"]) {
-    updateWindows(child, windows);
-  }
-  for (const Json::Value &child : node["floating_nodes"]) {
+  for (const auto &child : tree_->allNodes(node)) {
     updateWindows(child, windows);
   }
 }
@@ -291,7 +277,7 @@ auto Workspaces::update() -> void {
   std::lock_guard<std::mutex> lock(mutex_);
   bool needReorder = filterButtons();
   for (auto it = workspaces_.begin(); it != workspaces_.end(); ++it) {
-    auto bit = buttons_.find((*it)["name"].asString());
+    auto bit = buttons_.find(it->name);
     if (bit == buttons_.end()) {
       needReorder = true;
     }
@@ -299,23 +285,24 @@ auto Workspaces::update() -> void {
     if (needReorder) {
       box_.reorder_child(button, it - workspaces_.begin());
     }
-    bool noNodes = (*it)["nodes"].empty() && (*it)["floating_nodes"].empty();
-    if (hasFlag((*it), "focused")) {
+    bool noNodes = isEmpty(*it);
+    auto output_name = outputOf(*it);
+    if (hasFlag(*it, &Node::focused)) {
       button.get_style_context()->add_class("focused");
     } else {
       button.get_style_context()->remove_class("focused");
     }
-    if (hasFlag((*it), "visible") || ((*it)["output"].isString() && noNodes )) {
+    if (hasFlag(*it, &Node::visible) || (output_name.data() != nullptr && noNodes)) {
       button.get_style_context()->add_class("visible");
     } else {
       button.get_style_context()->remove_class("visible");
     }
-    if (hasFlag((*it), "urgent")) {
+    if (hasFlag(*it, &Node::urgent)) {
       button.get_style_context()->add_class("urgent");
     } else {
       button.get_style_context()->remove_class("urgent");
     }
-    if ((*it)["target_output"].isString()) {
+    if (it->target_output.has_value()) {
       button.get_style_context()->add_class("persistent");
     } else {
       button.get_style_context()->remove_class("persistent");
@@ -325,8 +312,8 @@ auto Workspaces::update() -> void {
     } else {
       button.get_style_context()->remove_class("empty");
     }
-    if ((*it)["output"].isString()) {
-      if (((*it)["output"].asString()) == bar_.output->name) {
+    if (output_name.data() != nullptr) {
+      if (output_name == bar_.output->name) {
         button.get_style_context()->add_class("current_output");
       } else {
         button.get_style_context()->remove_class("current_output");
@@ -334,21 +321,20 @@ auto Workspaces::update() -> void {
     } else {
       button.get_style_context()->remove_class("current_output");
     }
-    std::string output = (*it)["name"].asString();
+    std::string output = it->name;
     std::string windows = "";
-    if (config_["window-format"].isString()) {
-      updateWindows((*it), windows);
+    if (show_windows_ && it->node != nullptr) {
+      updateWindows(*it->node, windows);
     }
-    if (config_["format"].isString()) {
-      auto format = config_["format"].asString();
+    if (format_) {
       output = fmt::format(
-          fmt::runtime(format), fmt::arg("icon", getIcon(output, *it)), fmt::arg("value", output),
-          fmt::arg("name", trimWorkspaceName(output)), fmt::arg("index", (*it)["num"].asString()),
+          fmt::runtime(*format_), fmt::arg("icon", getIcon(output, *it)), fmt::arg("value", output),
+          fmt::arg("name", trimWorkspaceName(output)), fmt::arg("index", std::to_string(it->num)),
           fmt::arg("windows",
                    windows.substr(0, windows.length() - m_formatWindowSeperator.length())),
-          fmt::arg("output", (*it)["output"].asString()));
+          fmt::arg("output", output_name));
     }
-    if (!config_["disable-markup"].asBool()) {
+    if (!disable_markup_) {
       static_cast<Gtk::Label *>(button.get_children()[0])->set_markup(output);
     } else {
       button.set_label(output);
@@ -359,26 +345,26 @@ auto Workspaces::update() -> void {
   AModule::update();
 }
 
-Gtk::Button &Workspaces::addButton(const Json::Value &node) {
-  auto pair = buttons_.emplace(node["name"].asString(), node["name"].asString());
+Gtk::Button &Workspaces::addButton(const Workspace &workspace) {
+  auto pair = buttons_.emplace(workspace.name, workspace.name);
   auto &&button = pair.first->second;
   box_.pack_start(button, false, false, 0);
-  button.set_name("sway-workspace-" + node["name"].asString());
+  button.set_name("sway-workspace-" + workspace.name);
   button.set_relief(Gtk::RELIEF_NONE);
   if (!config_["disable-click"].asBool()) {
-    button.signal_pressed().connect([this, node] {
+    button.signal_pressed().connect([this, name = workspace.name,
+                                     target_output = workspace.target_output] {
       try {
-        if (node["target_output"].isString()) {
-          ipc_.sendCmd(IPC_COMMAND,
-                       fmt::format(persistent_workspace_switch_cmd_, "--no-auto-back-and-forth",
-                                   node["name"].asString(), node["target_output"].asString(),
-                                   "--no-auto-back-and-forth", node["name"].asString()));
+        if (target_output.has_value()) {
+          ipc_.sendCmd(IPC_COMMAND, fmt::format(persistent_workspace_switch_cmd_,
+                                                "--no-auto-back-and-forth", name, *target_output,
+                                                "--no-auto-back-and-forth", name));
         } else {
           ipc_.sendCmd(IPC_COMMAND, fmt::format("workspace {} \"{}\"",
                                                 config_["disable-auto-back-and-forth"].asBool()
                                                     ? "--no-auto-back-and-forth"
                                                     : "",
-                                                node["name"].asString()));
+                                                name));
         }
       } catch (const std::exception &e) {
         spdlog::error("Workspaces: {}", e.what());
@@ -388,14 +374,15 @@ Gtk::Button &Workspaces::addButton(const Json::Value &node) {
   return button;
 }
 
-std::string Workspaces::getIcon(const std::string &name, const Json::Value &node) {
+std::string Workspaces::getIcon(const std::string &name, const Workspace &workspace) {
   std::vector<std::string> keys = {"high-priority-named", "urgent", "focused", name, "default"};
   for (auto const &key : keys) {
     if (key == "high-priority-named") {
       auto it = std::find_if(high_priority_named_.begin(), high_priority_named_.end(),
                              [&](const std::string &member) { return member == name; });
       if (it != high_priority_named_.end()) {
-        return config_["format-icons"][name].asString();
+        const auto *named = icon(name);
+        return named != nullptr ? *named : "";
       }
 
       it = std::find_if(high_priority_named_.begin(), high_priority_named_.end(),
@@ -403,25 +390,32 @@ std::string Workspaces::getIcon(const std::string &name, const Json::Value &node
                           return trimWorkspaceName(member) == trimWorkspaceName(name);
                         });
       if (it != high_priority_named_.end()) {
-        return config_["format-icons"][trimWorkspaceName(name)].asString();
+        const auto *named = icon(trimWorkspaceName(name));
+        return named != nullptr ? *named : "";
       }
     }
     if (key == "focused" || key == "urgent") {
-      if (config_["format-icons"][key].isString() && hasFlag(node, key)) {
-        return config_["format-icons"][key].asString();
+      auto flag = key == "focused" ? &Node::focused : &Node::urgent;
+      if (const auto *flagged = icon(key); flagged != nullptr && hasFlag(workspace, flag)) {
+        return *flagged;
       }
-    } else if (config_["format-icons"]["persistent"].isString() &&
-               node["target_output"].isString()) {
-      return config_["format-icons"]["persistent"].asString();
-    } else if (config_["format-icons"][key].isString()) {
-      return config_["format-icons"][key].asString();
-    } else if (config_["format-icons"][trimWorkspaceName(key)].isString()) {
-      return config_["format-icons"][trimWorkspaceName(key)].asString();
+    } else if (const auto *persistent = icon("persistent");
+               persistent != nullptr && workspace.target_output.has_value()) {
+      return *persistent;
+    } else if (const auto *keyed = icon(key)) {
+      return *keyed;
+    } else if (const auto *trimmed = icon(trimWorkspaceName(key))) {
+      return *trimmed;
     }
   }
   return name;
 }
 
+const std::string *Workspaces::icon(std::string_view key) const {
+  auto it = icons_.find(key);
+  return it == icons_.end() ? nullptr : &it->second;
+}
+
 bool Workspaces::handleScroll(GdkEventScroll *e) {
   if (gdk_event_get_pointer_emulated((GdkEvent *)e)) {
     /**
@@ -436,8 +430,9 @@ bool Workspaces::handleScroll(GdkEventScroll *e) {
   std::string name;
   {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto it = std::find_if(workspaces_.begin(), workspaces_.end(),
-                           [](const auto &workspace) { return hasFlag(workspace, "focused"); });
+    auto it = std::find_if(workspaces_.begin(), workspaces_.end(), [this](const auto &workspace) {
+      return hasFlag(workspace, &Node::focused);
+    });
     if (it == workspaces_.end()) {
       return true;
     }
@@ -448,7 +443,7 @@ bool Workspaces::handleScroll(GdkEventScroll *e) {
     } else {
       return true;
     }
-    if (name == (*it)["name"].asString()) {
+    if (name == it->name) {
       return true;
     }
   }
@@ -466,10 +461,10 @@ bool Workspaces::handleScroll(GdkEventScroll *e) {
   return true;
 }
 
-const std::string Workspaces::getCycleWorkspace(std::vector<Json::Value>::iterator it,
+const std::string Workspaces::getCycleWorkspace(std::vector<Workspace>::iterator it,
                                                 bool prev) const {
   if (prev && it == workspaces_.begin() && !config_["disable-scroll-wraparound"].asBool()) {
-    return (*(--workspaces_.end()))["name"].asString();
+    return (*(--workspaces_.end())).name;
   }
   if (prev && it != workspaces_.begin())
     --it;
@@ -479,10 +474,10 @@ const std::string Workspaces::getCycleWorkspace(std::vector<Json::Value>::iterat
     if (config_["disable-scroll-wraparound"].asBool()) {
       --it;
     } else {
-      return (*(workspaces_.begin()))["name"].asString();
+      return (*(workspaces_.begin())).name;
     }
   }
-  return (*it)["name"].asString();
+  return it->name;
 }
 
 std::string Workspaces::trimWorkspaceName(std::string name) {
@@ -493,9 +488,9 @@ std::string Workspaces::trimWorkspaceName(std::string name) {
   return name;
 }
 
-void Workspaces::onButtonReady(const Json::Value &node, Gtk::Button &button) {
+void Workspaces::onButtonReady(const Workspace &workspace, Gtk::Button &button) {
   if (config_["current-only"].asBool()) {
-    if (node["focused"].asBool()) {
+    if (workspace.node != nullptr && workspace.node->focused) {
       button.show();
     } else {
       button.hide();
@@ -50,10 +50,22 @@ wabar::modules::Temperature::Temperature(const std::string& id, const Json::Valu
   temp.close();
 #endif
 
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  if (tooltipEnabled()) {
+    setTooltipCallback([this]() -> std::string {
+      if (!temperature_) {
+        return "";
+      }
+      std::string tooltip_format = "{temperatureC}°C";
+      if (config_["tooltip-format"].isString()) {
+        tooltip_format = config_["tooltip-format"].asString();
+      }
+      return fmt::format(fmt::runtime(tooltip_format),
+                         fmt::arg("temperatureC", temperature_->celsius),
+                         fmt::arg("temperatureF", temperature_->fahrenheit),
+                         fmt::arg("temperatureK", temperature_->kelvin));
+    });
+  }
+  timer_.start(interval_, [this] { dp.emit(); });
 }
 
 auto wabar::modules::Temperature::update() -> void {
@@ -61,6 +73,7 @@ auto wabar::modules::Temperature::update() -> void {
   uint16_t temperature_c = std::round(temperature);
   uint16_t temperature_f = std::round(temperature * 1.8 + 32);
   uint16_t temperature_k = std::round(temperature + 273.15);
+  temperature_ = {temperature_c, temperature_f, temperature_k};
   auto critical = isCritical(temperature_c);
   auto format = format_;
   if (critical) {
@@ -82,15 +95,6 @@ auto wabar::modules::Temperature::update() -> void {
                                 fmt::arg("temperatureF", temperature_f),
                                 fmt::arg("temperatureK", temperature_k),
                                 fmt::arg("icon", getIcon(temperature_c, "", max_temp))));
-  if (tooltipEnabled()) {
-    std::string tooltip_format = "{temperatureC}°C";
-    if (config_["tooltip-format"].isString()) {
-      tooltip_format = config_["tooltip-format"].asString();
-    }
-    label_.set_tooltip_text(fmt::format(
-        fmt::runtime(tooltip_format), fmt::arg("temperatureC", temperature_c),
-        fmt::arg("temperatureF", temperature_f), fmt::arg("temperatureK", temperature_k)));
-  }
   // Call parent update
   ALabel::update();
 }
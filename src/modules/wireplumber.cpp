@@ -36,6 +36,21 @@ wabar::modules::Wireplumber::Wireplumber(const std::string& id, const Json::Valu
   g_signal_connect_swapped(om_, "installed", (GCallback)onObjectManagerInstalled, this);
 
   asyncLoadRequiredApiModules();
+
+  if (tooltipEnabled()) {
+    setTooltipCallback([this]() -> std::string {
+      std::string tooltipFormat;
+      if (config_["tooltip-format"].isString()) {
+        tooltipFormat = config_["tooltip-format"].asString();
+      }
+      if (tooltipFormat.empty()) {
+        return node_name_;
+      }
+      return fmt::format(fmt::runtime(tooltipFormat), fmt::arg("node_name", node_name_),
+                         fmt::arg("volume", shown_volume_),
+                         fmt::arg("icon", getIcon(shown_volume_)));
+    });
+  }
 }
 
 wabar::modules::Wireplumber::~Wireplumber() {
@@ -305,7 +320,6 @@ void wabar::modules::Wireplumber::asyncLoadRequiredApiModules() {
 
 auto wabar::modules::Wireplumber::update() -> void {
   auto format = format_;
-  std::string tooltipFormat;
 
   if (muted_) {
     format = config_["format-muted"].isString() ? config_["format-muted"].asString() : format;
@@ -321,19 +335,7 @@ auto wabar::modules::Wireplumber::update() -> void {
 
   getState(vol);
 
-  if (tooltipEnabled()) {
-    if (tooltipFormat.empty() && config_["tooltip-format"].isString()) {
-      tooltipFormat = config_["tooltip-format"].asString();
-    }
-
-    if (!tooltipFormat.empty()) {
-      label_.set_tooltip_text(fmt::format(fmt::runtime(tooltipFormat),
-                                          fmt::arg("node_name", node_name_),
-                                          fmt::arg("volume", vol), fmt::arg("icon", getIcon(vol))));
-    } else {
-      label_.set_tooltip_text(node_name_);
-    }
-  }
+  shown_volume_ = vol;
 
   // Call parent update
   ALabel::update();
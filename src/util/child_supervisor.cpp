@@ -0,0 +1,119 @@
+#include "util/child_supervisor.hpp"
+
+#include <spdlog/spdlog.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "util/reactor.hpp"
+
+// Not in the headers of older C libraries
+#ifndef P_PIDFD
+#define P_PIDFD 3
+#endif
+
+namespace wabar::util {
+
+ChildSupervisor &ChildSupervisor::inst() {
+  static ChildSupervisor instance;
+  return instance;
+}
+
+std::shared_ptr<const Child> ChildSupervisor::watch(pid_t pid, ExitHandler on_exit) {
+  auto child = std::make_shared<Child>(pid);
+  child->on_exit_ = std::move(on_exit);
+  if (child->owner_) {
+    auto running = child->owner_->children.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (running == RUNAWAY_CHILDREN + 1) {
+      spdlog::warn("{} has more than {} commands still running", child->owner_->name(),
+                   RUNAWAY_CHILDREN);
+    }
+  }
+
+#ifdef SYS_pidfd_open
+  if (pidfd_supported_.load(std::memory_order_relaxed)) {
+    // Close on exec by default, and valid for a zombie as long as it isn't reaped
+    child->pidfd_ = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+    if (child->pidfd_ != -1) {
+      Reactor::inst().readable(child->pidfd_, [this, child] {
+        // The only reaper of the child, through the pidfd so a reused pid can't be mistaken for it
+        siginfo_t info{};
+        auto ret = waitid(static_cast<idtype_t>(P_PIDFD), child->pidfd_, &info, WEXITED | WNOHANG);
+        ::close(child->pidfd_);
+        if (ret == -1 || info.si_pid == 0) {
+          spdlog::error("Can't reap child with PID {}: {}", child->pid_,
+                        ret == -1 ? strerror(errno) : "not exited");
+          forget(child);
+          return;
+        }
+        exited(child, waitStatus(info));
+      });
+      return child;
+    }
+    if (errno == ENOSYS) {
+      spdlog::debug("No pidfd support, polling children on SIGCHLD");
+      pidfd_supported_ = false;
+    }
+  }
+#endif
+
+  {
+    std::lock_guard lock(mutex_);
+    polled_.push_back(child);
+  }
+  // The SIGCHLD may have come before it was added
+  reapPolled();
+  return child;
+}
+
+void ChildSupervisor::reapPolled() {
+  std::vector<std::pair<std::shared_ptr<Child>, int>> done;
+  {
+    std::lock_guard lock(mutex_);
+    std::erase_if(polled_, [&done](const auto &child) {
+      int status = 0;
+      auto ret = waitpid(child->pid_, &status, WNOHANG);
+      if (ret == child->pid_) {
+        done.emplace_back(child, status);
+        return true;
+      }
+      return false;
+    });
+  }
+  for (const auto &[child, status] : done) {
+    exited(child, status);
+  }
+}
+
+int ChildSupervisor::waitStatus(const siginfo_t &info) {
+  switch (info.si_code) {
+    case CLD_EXITED:
+      return W_EXITCODE(info.si_status, 0);
+    case CLD_DUMPED:
+      return W_EXITCODE(0, info.si_status) | WCOREFLAG;
+    default:
+      return W_EXITCODE(0, info.si_status);
+  }
+}
+
+void ChildSupervisor::forget(const std::shared_ptr<Child> &child) {
+  if (child->owner_) {
+    child->owner_->children.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+void ChildSupervisor::exited(const std::shared_ptr<Child> &child, int status) {
+  spdlog::debug("Reaped child with PID: {}", child->pid_);
+  child->status_ = status;
+  child->exited_.store(true, std::memory_order_release);
+  forget(child);
+  if (child->on_exit_) {
+    Metrics::Scope scope(child->owner_);
+    child->on_exit_(status);
+  }
+}
+
+}  // namespace wabar::util
@@ -0,0 +1,119 @@
+#include "util/config_view.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+namespace wabar::util {
+
+ConfigView::ConfigView(const Json::Value &config, const std::string &module) {
+  if (!config.isObject()) {
+    return;
+  }
+  static constexpr std::string_view FORMAT = "format-";
+  static constexpr std::string_view TOOLTIP_FORMAT = "tooltip-format-";
+  for (auto it = config.begin(); it != config.end(); ++it) {
+    auto key = it.name();
+    std::string_view name(key);
+    if (name.starts_with("on-")) {
+      if (std::find(EVENTS.begin(), EVENTS.end(), name) == EVENTS.end()) {
+        spdlog::warn("{}: unknown event '{}' is ignored", module, name);
+      } else if (it->isString()) {
+        commands_.emplace(key, it->asString());
+      }
+    } else if (!it->isString() || name == FORMAT || name == TOOLTIP_FORMAT) {
+      continue;
+    } else if (name == "format" || name == "tooltip-format") {
+      fields_.add(it->asString());
+    } else if (name.starts_with(FORMAT)) {
+      auto format = it->asString();
+      fields_.add(format);
+      formats_.emplace(name.substr(FORMAT.size()), std::move(format));
+    } else if (name.starts_with(TOOLTIP_FORMAT)) {
+      auto format = it->asString();
+      fields_.add(format);
+      tooltip_formats_.emplace(name.substr(TOOLTIP_FORMAT.size()), std::move(format));
+    }
+  }
+
+  const auto &states = config["states"];
+  for (auto it = states.begin(); it != states.end(); ++it) {
+    if (it->isUInt() && it.key().isString()) {
+      states_.push_back({it.name(), it->asUInt()});
+    } else {
+      spdlog::warn("{}: state '{}' has no threshold and is ignored", module, it.name());
+    }
+  }
+  std::stable_sort(states_.begin(), states_.end(),
+                   [](const auto &a, const auto &b) { return a.threshold < b.threshold; });
+  auto duplicates = std::unique(states_.begin(), states_.end(), [](const auto &a, const auto &b) {
+    return a.threshold == b.threshold;
+  });
+  states_.erase(duplicates, states_.end());
+
+  const auto &icons = config["format-icons"];
+  icons_by_alt_ = icons.isObject();
+  if (icons_by_alt_) {
+    for (auto it = icons.begin(); it != icons.end(); ++it) {
+      // Alts of any other type fall back to the default icons
+      if (it->isString() || it->isArray()) {
+        icons_.emplace(it.name(), iconTable(*it));
+      }
+    }
+  } else if (icons.isString() || icons.isArray()) {
+    icons_.emplace("", iconTable(icons));
+  }
+
+  const auto &actions = config["actions"];
+  for (auto it = actions.begin(); it != actions.end(); ++it) {
+    if (it.key().isString() && it->isString()) {
+      if (!actions_.emplace(it.key().asString(), it->asString()).second) {
+        spdlog::warn("Dublicate action is ignored: {0}", it.key().asString());
+      }
+    } else {
+      spdlog::warn("Wrong actions section configuration. See config by index: {}", it.index());
+    }
+  }
+}
+
+ConfigView::IconTable ConfigView::iconTable(const Json::Value &icons) {
+  if (icons.isString()) {
+    return {icons.asString()};
+  }
+  IconTable table;
+  table.reserve(icons.size());
+  for (const auto &icon : icons) {
+    // An icon that isn't a string shows nothing
+    table.push_back(icon.isString() ? icon.asString() : "");
+  }
+  return table;
+}
+
+const ConfigView::IconTable *ConfigView::altIcons(std::string_view alt) const {
+  if (!icons_by_alt_ || alt.empty()) {
+    return nullptr;
+  }
+  auto it = icons_.find(alt);
+  return it == icons_.end() ? nullptr : &it->second;
+}
+
+const ConfigView::IconTable *ConfigView::defaultIcons() const {
+  auto it = icons_.find(icons_by_alt_ ? "default" : "");
+  return it == icons_.end() ? nullptr : &it->second;
+}
+
+const ConfigView::IconTable *ConfigView::icons(std::string_view alt) const {
+  const auto *table = altIcons(alt);
+  return table != nullptr ? table : defaultIcons();
+}
+
+const ConfigView::IconTable *ConfigView::icons(const std::vector<std::string> &alts) const {
+  for (const auto &alt : alts) {
+    if (const auto *table = altIcons(alt)) {
+      return table;
+    }
+  }
+  return defaultIcons();
+}
+
+}  // namespace wabar::util
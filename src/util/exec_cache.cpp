@@ -0,0 +1,66 @@
+#include "util/exec_cache.hpp"
+
+#include <algorithm>
+
+namespace wabar::util::command {
+
+ExecCache &ExecCache::inst() {
+  static ExecCache instance;
+  return instance;
+}
+
+res ExecCache::get(const std::string &key, clock::duration ttl, const std::function<res()> &run) {
+  std::unique_lock lock(mutex_);
+  auto now = clock::now();
+  evict(now);
+  // Node based, the reference survives insertions by other callers
+  auto &entry = entries_[key];
+  entry.ttl = std::max(entry.ttl, ttl);
+  if (entry.result && now - entry.finished < ttl) {
+    return *entry.result;
+  }
+  if (entry.running) {
+    // Kept from eviction until every waiter has read the result
+    ++entry.waiters;
+    auto generation = entry.generation;
+    done_cv_.wait(lock, [&entry, generation] { return entry.generation != generation; });
+    --entry.waiters;
+    if (entry.error) {
+      std::rethrow_exception(entry.error);
+    }
+    return *entry.result;
+  }
+
+  entry.running = true;
+  lock.unlock();
+  std::optional<res> result;
+  std::exception_ptr error;
+  try {
+    result = run();
+  } catch (...) {
+    error = std::current_exception();
+  }
+  lock.lock();
+  // Whatever happened, so that the waiters and the next callers don't block on it
+  entry.running = false;
+  entry.result = result;
+  entry.error = error;
+  entry.finished = clock::now();
+  ++entry.generation;
+  done_cv_.notify_all();
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return *result;
+}
+
+/* Drop the results past their ttl, called with mutex_ held */
+void ExecCache::evict(clock::time_point now) {
+  std::erase_if(entries_, [now](const auto &item) {
+    const auto &entry = item.second;
+    return !entry.running && entry.waiters == 0 &&
+           (!entry.result || now - entry.finished >= entry.ttl);
+  });
+}
+
+}  // namespace wabar::util::command
@@ -0,0 +1,156 @@
+#include "util/file_watcher.hpp"
+
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+#ifdef HAVE_INOTIFY
+#include <sys/inotify.h>
+#endif
+#ifdef __linux__
+#include <linux/magic.h>
+#include <sys/vfs.h>
+#endif
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+namespace wabar::util {
+
+FileWatcher::FileWatcher(std::string path, ChangeHandler on_change)
+    : path_(std::move(path)), on_change_(std::move(on_change)) {
+#ifdef __linux__
+  struct statfs fs {};
+  sysfs_ = statfs(path_.c_str(), &fs) == 0 && fs.f_type == SYSFS_MAGIC;
+#endif
+  if (!sysfs_) {
+#ifdef HAVE_INOTIFY
+    // The directory rather than the file, which may not exist yet or be replaced
+    auto dir = std::filesystem::path(path_).parent_path();
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ == -1 ||
+        inotify_add_watch(inotify_fd_, dir.empty() ? "." : dir.c_str(),
+                          IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO) ==
+            -1) {
+      spdlog::error("Unable to watch {}: {}", path_, strerror(errno));
+      if (inotify_fd_ != -1) {
+        ::close(inotify_fd_);
+        inotify_fd_ = -1;
+      }
+    }
+#else
+    spdlog::error("Unable to watch {}: built without inotify", path_);
+#endif
+  }
+  // After adding the watch, so that a file created meanwhile isn't missed
+  open();
+  read(content_);
+  on_change_(content_);
+  arm();
+}
+
+FileWatcher::~FileWatcher() {
+  handle_.stop();
+  if (fd_ != -1) {
+    ::close(fd_);
+  }
+  if (inotify_fd_ != -1) {
+    ::close(inotify_fd_);
+  }
+}
+
+void FileWatcher::open() {
+  if (fd_ != -1) {
+    ::close(fd_);
+  }
+  fd_ = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+void FileWatcher::arm() {
+  if (sysfs_ && fd_ != -1) {
+    handle_.readable(fd_, [this] { changed(); }, true);
+  } else if (inotify_fd_ != -1) {
+    handle_.readable(inotify_fd_, [this] { changed(); });
+  }
+}
+
+void FileWatcher::changed() {
+  if (!sysfs_ && !drainEvents()) {
+    // Another file of the directory
+    arm();
+    return;
+  }
+  std::string content;
+  auto ok = read(content);
+  auto error = errno;
+  if (content != content_) {
+    content_ = std::move(content);
+    on_change_(content_);
+  }
+  if (sysfs_ && !ok) {
+    // The device is gone, its attribute would stay ready forever
+    spdlog::warn("Stopped watching {}: {}", path_, strerror(error));
+    return;
+  }
+  arm();
+}
+
+/* Read the pending inotify events, returns whether one concerns the file */
+bool FileWatcher::drainEvents() {
+#ifdef HAVE_INOTIFY
+  auto name = std::filesystem::path(path_).filename().string();
+  alignas(inotify_event) std::array<char, 4096> buffer;
+  bool relevant = false;
+  bool reopen = false;
+  ssize_t len;
+  while ((len = ::read(inotify_fd_, buffer.data(), buffer.size())) > 0) {
+    for (auto *ptr = buffer.data(); ptr < buffer.data() + len;) {
+      const auto *event = reinterpret_cast<const inotify_event *>(ptr);
+      ptr += sizeof(inotify_event) + event->len;
+      if ((event->mask & IN_Q_OVERFLOW) != 0) {
+        relevant = reopen = true;
+      } else if (event->len != 0 && name == event->name) {
+        relevant = true;
+        // Anything but a write to the file already open replaces it
+        reopen = reopen || (event->mask & ~IN_CLOSE_WRITE) != 0;
+      }
+    }
+  }
+  if (reopen) {
+    open();
+  }
+  return relevant;
+#else
+  return false;
+#endif
+}
+
+/* The whole content of the file, from its start */
+bool FileWatcher::read(std::string &content) const {
+  content.clear();
+  if (fd_ == -1) {
+    return false;
+  }
+  content.resize(MAX_CONTENT);
+  size_t size = 0;
+  while (size < content.size()) {
+    auto len = pread(fd_, content.data() + size, content.size() - size, size);
+    if (len < 0 && errno == EINTR) {
+      continue;
+    }
+    if (len < 0) {
+      content.clear();
+      return false;
+    }
+    if (len == 0) {
+      break;
+    }
+    size += len;
+  }
+  content.resize(size);
+  return true;
+}
+
+}  // namespace wabar::util
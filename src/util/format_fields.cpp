@@ -0,0 +1,75 @@
+#include "util/format_fields.hpp"
+
+namespace wabar::util {
+
+void FormatFields::add(std::string_view format) {
+  size_t i = 0;
+  while (i < format.size()) {
+    char c = format[i];
+    bool doubled = i + 1 < format.size() && format[i + 1] == c;
+    if (c == '{' && !doubled) {
+      i = argument(format, i + 1);
+      if (i == std::string_view::npos) {
+        any_ = true;
+        return;
+      }
+    } else if (c == '{' || c == '}') {
+      // A lone '}' is an error fmt would throw on
+      any_ = any_ || !doubled;
+      i += doubled ? 2 : 1;
+    } else {
+      ++i;
+    }
+  }
+}
+
+void FormatFields::add(const FormatFields &other) {
+  names_.insert(other.names_.begin(), other.names_.end());
+  any_ = any_ || other.any_;
+}
+
+size_t FormatFields::argument(std::string_view format, size_t i) {
+  auto end = format.find_first_of(":}", i);
+  if (end == std::string_view::npos) {
+    return end;
+  }
+  auto name = format.substr(i, end - i);
+  if (name.empty() || (name[0] >= '0' && name[0] <= '9')) {
+    any_ = true;
+  } else {
+    names_.emplace(name);
+  }
+  if (format[end] == '}') {
+    return end + 1;
+  }
+  // The spec may hold arguments of its own, for a dynamic width or precision
+  i = end + 1;
+  while (i < format.size()) {
+    if (format[i] == '}') {
+      return i + 1;
+    }
+    if (format[i] == '{') {
+      i = argument(format, i + 1);
+      if (i == std::string_view::npos) {
+        return i;
+      }
+    } else {
+      ++i;
+    }
+  }
+  return std::string_view::npos;
+}
+
+bool FormatFields::contains(std::string_view name) const {
+  return any_ || names_.find(name) != names_.end();
+}
+
+bool FormatFields::containsPrefix(std::string_view prefix) const {
+  if (any_) {
+    return true;
+  }
+  auto it = names_.lower_bound(prefix);
+  return it != names_.end() && std::string_view(*it).starts_with(prefix);
+}
+
+}  // namespace wabar::util
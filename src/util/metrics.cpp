@@ -0,0 +1,276 @@
+#include "util/metrics.hpp"
+
+#include <fmt/format.h>
+#include <json/writer.h>
+#include <spdlog/spdlog.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+namespace wabar::util {
+
+static constexpr const char *SOCKET_PREFIX = "wabar-stats-";
+static constexpr const char *SOCKET_SUFFIX = ".sock";
+
+static thread_local std::shared_ptr<ModuleMetrics> current_module;
+
+static uint64_t toMicroseconds(std::chrono::steady_clock::duration duration) {
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+  return us < 0 ? 0 : static_cast<uint64_t>(us);
+}
+
+void ModuleMetrics::recordUpdate(clock::duration duration) {
+  std::lock_guard lock(mutex_);
+  update_.record(toMicroseconds(duration));
+}
+
+void ModuleMetrics::recordLatency(clock::duration duration) {
+  std::lock_guard lock(mutex_);
+  latency_.record(toMicroseconds(duration));
+}
+
+Json::Value ModuleMetrics::toJson() const {
+  Json::Value json;
+  json["name"] = name_;
+  json["output"] = output_;
+  json["threads"] = static_cast<Json::Int64>(threads.load());
+  json["processes_spawned"] = static_cast<Json::UInt64>(processes.load());
+  json["children_running"] = static_cast<Json::Int64>(children.load());
+  std::lock_guard lock(mutex_);
+  json["updates"] = static_cast<Json::UInt64>(update_.count());
+  json["update_us"] = update_.toJson();
+  json["latency_us"] = latency_.toJson();
+  return json;
+}
+
+Metrics::Scope::Scope(std::shared_ptr<ModuleMetrics> metrics)
+    : previous_(std::exchange(current_module, std::move(metrics))) {}
+
+Metrics::Scope::~Scope() { current_module = std::move(previous_); }
+
+Metrics &Metrics::inst() {
+  static Metrics instance;
+  return instance;
+}
+
+std::shared_ptr<ModuleMetrics> Metrics::current() { return current_module; }
+
+Metrics::~Metrics() {
+  if (fd_ == -1) {
+    return;
+  }
+  // Wakes up the blocking accept()
+  shutdown(fd_, SHUT_RDWR);
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  close(fd_);
+  unlink(path_.c_str());
+}
+
+std::shared_ptr<ModuleMetrics> Metrics::add(const std::string &name, const std::string &output) {
+  auto metrics = std::make_shared<ModuleMetrics>(name, output);
+  std::lock_guard lock(mutex_);
+  std::erase_if(modules_, [](const auto &module) { return module.expired(); });
+  modules_.push_back(metrics);
+  return metrics;
+}
+
+void Metrics::threadStarted() {
+  inst().threads_.fetch_add(1, std::memory_order_relaxed);
+  if (current_module) {
+    current_module->threads.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void Metrics::threadStopped(const std::shared_ptr<ModuleMetrics> &owner) {
+  inst().threads_.fetch_sub(1, std::memory_order_relaxed);
+  if (owner) {
+    owner->threads.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+void Metrics::processSpawned() {
+  inst().processes_.fetch_add(1, std::memory_order_relaxed);
+  if (current_module) {
+    current_module->processes.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void Metrics::recordLoopIteration(clock::duration duration) {
+  std::lock_guard lock(mutex_);
+  loop_.record(toMicroseconds(duration));
+  if (duration >= STALL_THRESHOLD) {
+    ++stalls_;
+    stall_us_ += toMicroseconds(duration);
+  }
+}
+
+static Json::Value processTotals() {
+  Json::Value json;
+  struct rusage usage {};
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    auto us = [](const timeval &tv) {
+      return static_cast<Json::UInt64>(tv.tv_sec) * 1000000 +
+             static_cast<Json::UInt64>(tv.tv_usec);
+    };
+    json["cpu_user_us"] = us(usage.ru_utime);
+    json["cpu_system_us"] = us(usage.ru_stime);
+    // Kilobytes on Linux and the BSDs
+    json["max_rss_bytes"] = static_cast<Json::UInt64>(usage.ru_maxrss) * 1024;
+  }
+#ifdef __linux__
+  std::ifstream statm("/proc/self/statm");
+  uint64_t size = 0;
+  uint64_t resident = 0;
+  if (statm >> size >> resident) {
+    json["rss_bytes"] = static_cast<Json::UInt64>(resident * sysconf(_SC_PAGESIZE));
+  }
+#endif
+  return json;
+}
+
+Json::Value Metrics::snapshot() {
+  Json::Value json = processTotals();
+  json["pid"] = static_cast<Json::Int>(getpid());
+  json["uptime_s"] = std::chrono::duration<double>(clock::now() - started_).count();
+  json["threads"] = static_cast<Json::Int64>(threads_.load());
+  json["processes_spawned"] = static_cast<Json::UInt64>(processes_.load());
+
+  std::vector<std::shared_ptr<ModuleMetrics>> modules;
+  {
+    std::lock_guard lock(mutex_);
+    auto &loop = json["main_loop"];
+    loop["iteration_us"] = loop_.toJson();
+    loop["stalls"] = static_cast<Json::UInt64>(stalls_);
+    loop["stall_us"] = static_cast<Json::UInt64>(stall_us_);
+    loop["busy_us"] = static_cast<Json::UInt64>(loop_.sum());
+    for (const auto &module : modules_) {
+      if (auto metrics = module.lock()) {
+        modules.push_back(std::move(metrics));
+      }
+    }
+  }
+  auto &list = json["modules"] = Json::Value(Json::arrayValue);
+  for (const auto &module : modules) {
+    list.append(module->toJson());
+  }
+  return json;
+}
+
+static std::string runtimeDir() {
+  const char *runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+  return runtime_dir == nullptr ? "" : runtime_dir;
+}
+
+std::string Metrics::socketPath(pid_t pid) {
+  auto runtime_dir = runtimeDir();
+  if (runtime_dir.empty()) {
+    return "";
+  }
+  return fmt::format("{}/{}{}{}", runtime_dir, SOCKET_PREFIX, pid, SOCKET_SUFFIX);
+}
+
+void Metrics::serve() {
+  if (fd_ != -1) {
+    return;
+  }
+  path_ = socketPath(getpid());
+  struct sockaddr_un addr {};
+  if (path_.empty() || path_.size() >= sizeof(addr.sun_path)) {
+    spdlog::warn("No usable XDG_RUNTIME_DIR, runtime metrics are disabled");
+    return;
+  }
+  fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd_ == -1) {
+    spdlog::warn("Unable to create the metrics socket: {}", strerror(errno));
+    return;
+  }
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, path_.c_str(), sizeof(addr.sun_path) - 1);
+  // Left over by a crashed instance with the same pid
+  unlink(path_.c_str());
+  if (bind(fd_, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1 ||
+      listen(fd_, 4) == -1) {
+    spdlog::warn("Unable to listen on {}: {}", path_, strerror(errno));
+    close(fd_);
+    fd_ = -1;
+    return;
+  }
+  thread_ = std::thread(&Metrics::acceptLoop, this);
+}
+
+void Metrics::acceptLoop() {
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  while (true) {
+    int client = accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client == -1) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      // Socket shut down
+      return;
+    }
+    auto data = Json::writeString(builder, snapshot()) + '\n';
+    for (size_t sent = 0; sent < data.size();) {
+      auto res = send(client, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+      if (res <= 0) {
+        break;
+      }
+      sent += static_cast<size_t>(res);
+    }
+    close(client);
+  }
+}
+
+int Metrics::query() {
+  auto runtime_dir = runtimeDir();
+  if (runtime_dir.empty()) {
+    std::cerr << "XDG_RUNTIME_DIR is not set" << std::endl;
+    return 1;
+  }
+  namespace fs = std::filesystem;
+  std::error_code ec;
+  int found = 0;
+  for (const auto &entry : fs::directory_iterator(runtime_dir, ec)) {
+    auto name = entry.path().filename().string();
+    if (!name.starts_with(SOCKET_PREFIX) || !name.ends_with(SOCKET_SUFFIX)) {
+      continue;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, entry.path().c_str(), sizeof(addr.sun_path) - 1);
+    if (fd == -1 || connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1) {
+      // Stale socket of an instance that didn't exit cleanly
+      if (fd != -1) close(fd);
+      continue;
+    }
+    std::string data;
+    char buffer[4096];
+    ssize_t len;
+    while ((len = read(fd, buffer, sizeof(buffer))) > 0) {
+      data.append(buffer, static_cast<size_t>(len));
+    }
+    close(fd);
+    std::cout << data << std::flush;
+    ++found;
+  }
+  if (found == 0) {
+    std::cerr << "No running instance found" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace wabar::util
@@ -0,0 +1,99 @@
+#include "util/profiler.hpp"
+
+#include <json/writer.h>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+#include <fstream>
+
+namespace wabar::util {
+
+Profiler &Profiler::inst() {
+  static Profiler instance;
+  return instance;
+}
+
+unsigned Profiler::threadId() {
+  // Small sequential ids read better in trace viewers than the native ones
+  static std::atomic<unsigned> next = 1;
+  thread_local unsigned id = next.fetch_add(1, std::memory_order_relaxed);
+  return id;
+}
+
+void Profiler::start(const std::string &path) {
+  std::lock_guard lock(mutex_);
+  path_ = path;
+  origin_ = clock::now();
+  events_.clear();
+  // The thread starting the profiler is the main one, make it the first track
+  threadId();
+  enabled_ = true;
+}
+
+void Profiler::finish() {
+  if (!enabled_.exchange(false)) {
+    return;
+  }
+  auto json = trace();
+  std::ofstream file(path_);
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  file << Json::writeString(builder, json) << '\n';
+  if (!file) {
+    spdlog::error("Failed to write the startup profile to {}", path_);
+    return;
+  }
+  spdlog::info("Startup profile written to {}", path_);
+}
+
+void Profiler::record(std::string name, std::string detail, clock::time_point begin,
+                      clock::time_point end) {
+  std::lock_guard lock(mutex_);
+  events_.push_back({std::move(name), std::move(detail), begin, end, threadId()});
+}
+
+Json::Value Profiler::trace() const {
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+
+  std::lock_guard lock(mutex_);
+  Json::Value events(Json::arrayValue);
+  for (const auto &event : events_) {
+    Json::Value span;
+    span["name"] = event.name;
+    span["cat"] = "startup";
+    span["ph"] = "X";
+    span["ts"] = static_cast<Json::Int64>(
+        duration_cast<microseconds>(event.begin - origin_).count());
+    span["dur"] = static_cast<Json::Int64>(
+        duration_cast<microseconds>(event.end - event.begin).count());
+    span["pid"] = static_cast<Json::Int>(getpid());
+    span["tid"] = event.thread;
+    if (!event.detail.empty()) {
+      span["args"]["detail"] = event.detail;
+    }
+    events.append(span);
+  }
+  Json::Value root;
+  root["traceEvents"] = events;
+  root["displayTimeUnit"] = "ms";
+  return root;
+}
+
+Profiler::Span::Span(std::string_view name, std::string_view detail, Profiler &profiler) {
+  if (profiler.enabled()) {
+    profiler_ = &profiler;
+    name_ = name;
+    detail_ = detail;
+    begin_ = clock::now();
+  }
+}
+
+Profiler::Span::~Span() {
+  // Spans still open when recording stops are dropped
+  if (profiler_ != nullptr && profiler_->enabled()) {
+    profiler_->record(std::move(name_), std::move(detail_), begin_, clock::now());
+  }
+}
+
+}  // namespace wabar::util
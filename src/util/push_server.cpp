@@ -0,0 +1,132 @@
+#include "util/push_server.hpp"
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "util/reactor.hpp"
+
+namespace wabar::util {
+
+PushServer &PushServer::inst() {
+  static PushServer instance;
+  return instance;
+}
+
+PushServer::~PushServer() {
+  // The reactor is gone by now, only the socket is left to clean up
+  if (fd_ != -1) {
+    close(fd_);
+    unlink(path_.c_str());
+  }
+}
+
+PushServer::Subscription PushServer::subscribe(const std::string &module, Handler handler) {
+  std::lock_guard lock(mutex_);
+  auto id = next_id_++;
+  subscribers_.emplace(module, std::make_pair(id, std::move(handler)));
+  return Subscription(this, id);
+}
+
+void PushServer::unsubscribe(uint64_t id) {
+  // Waits for a dispatch in progress, the handler may point to a module being destroyed
+  std::lock_guard lock(mutex_);
+  std::erase_if(subscribers_, [id](const auto &entry) { return entry.second.first == id; });
+}
+
+std::string PushServer::socketPath() {
+  const char *runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+  if (runtime_dir == nullptr) {
+    return "";
+  }
+  return fmt::format("{}/wabar-push.sock", runtime_dir);
+}
+
+void PushServer::serve() {
+  if (fd_ != -1) {
+    return;
+  }
+  auto path = socketPath();
+  struct sockaddr_un addr {};
+  if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+    spdlog::warn("No usable XDG_RUNTIME_DIR, the push socket is disabled");
+    return;
+  }
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  auto *sockaddr = reinterpret_cast<struct sockaddr *>(&addr);
+
+  int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+  auto in_use = probe != -1 && (connect(probe, sockaddr, sizeof(addr)) == 0 || errno == EAGAIN);
+  if (probe != -1) {
+    close(probe);
+  }
+  if (in_use) {
+    spdlog::warn("{} is served by another instance", path);
+    return;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+  if (fd == -1) {
+    spdlog::warn("Unable to create the push socket: {}", strerror(errno));
+    return;
+  }
+  // Nobody listens, left over by an instance that crashed
+  unlink(path.c_str());
+  if (bind(fd, sockaddr, sizeof(addr)) == -1 || listen(fd, 16) == -1) {
+    spdlog::warn("Unable to listen on {}: {}", path, strerror(errno));
+    close(fd);
+    return;
+  }
+  fd_ = fd;
+  path_ = path;
+  Reactor::inst().readable(fd_, [this] { accept(); });
+}
+
+void PushServer::accept() {
+  while (true) {
+    int client = accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client == -1) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      break;
+    }
+    // Producers may keep the connection open and write a line per change
+    Reactor::inst().readLines(
+        client, [this](std::string_view line) { dispatch(line); }, [client] { close(client); });
+  }
+  Reactor::inst().readable(fd_, [this] { accept(); });
+}
+
+void PushServer::dispatch(std::string_view line) {
+  if (line.find_first_not_of(" \t\r") == std::string_view::npos) {
+    return;
+  }
+  std::lock_guard lock(mutex_);
+  Json::Value payload;
+  try {
+    payload = parser_.parse(line);
+  } catch (const std::exception &e) {
+    spdlog::warn("Invalid push: {}", e.what());
+    return;
+  }
+  if (!payload.isObject() || !payload["module"].isString()) {
+    spdlog::warn("Push without a module: {}", line);
+    return;
+  }
+  auto [begin, end] = subscribers_.equal_range(payload["module"].asString());
+  if (begin == end) {
+    spdlog::debug("No module {} to push to", payload["module"].asString());
+  }
+  for (auto it = begin; it != end; ++it) {
+    it->second.second(payload);
+  }
+}
+
+}  // namespace wabar::util
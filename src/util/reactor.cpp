@@ -0,0 +1,386 @@
+#include "util/reactor.hpp"
+
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+#ifdef HAVE_EPOLL
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+
+#include <vector>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "util/metrics.hpp"
+
+namespace wabar::util {
+
+struct Reactor::Source {
+  int fd = -1;
+  LineHandler on_line;
+  std::function<void()> on_eof;
+  std::function<void()> on_timeout;
+  std::function<void()> on_ready;
+  bool priority = false;
+  std::shared_ptr<ModuleMetrics> owner = Metrics::current();
+  // Partial line, only touched by the reactor thread
+  std::string line;
+
+  // Guarded by Reactor::mutex_
+  bool running = false;
+  bool cancelled = false;
+  std::thread::id runner;
+};
+
+Reactor &Reactor::inst() {
+  static Reactor instance;
+  return instance;
+}
+
+Reactor::Reactor() {
+  if (pipe2(wake_fds_, O_CLOEXEC | O_NONBLOCK) != 0) {
+    throw std::runtime_error(fmt::format("Can't create the reactor pipe: {}", strerror(errno)));
+  }
+#ifdef HAVE_EPOLL
+  poll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (poll_fd_ == -1) {
+    throw std::runtime_error(fmt::format("Can't create the reactor epoll: {}", strerror(errno)));
+  }
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = wake_fds_[0];
+  epoll_ctl(poll_fd_, EPOLL_CTL_ADD, wake_fds_[0], &event);
+#endif
+  thread_ = std::thread(&Reactor::loop, this);
+}
+
+Reactor::~Reactor() {
+  {
+    std::lock_guard lock(mutex_);
+    stop_ = true;
+  }
+  wake();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  if (poll_fd_ != -1) {
+    ::close(poll_fd_);
+  }
+  ::close(wake_fds_[0]);
+  ::close(wake_fds_[1]);
+}
+
+std::shared_ptr<Reactor::Source> Reactor::readLines(int fd, LineHandler on_line,
+                                                    std::function<void()> on_eof) {
+  auto source = std::make_shared<Source>();
+  source->fd = fd;
+  source->on_line = std::move(on_line);
+  source->on_eof = std::move(on_eof);
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  add(source);
+  return source;
+}
+
+std::shared_ptr<Reactor::Source> Reactor::readable(int fd, std::function<void()> on_ready,
+                                                   bool priority) {
+  auto source = std::make_shared<Source>();
+  source->fd = fd;
+  source->on_ready = std::move(on_ready);
+  source->priority = priority;
+  add(source);
+  return source;
+}
+
+void Reactor::add(const std::shared_ptr<Source> &source) {
+  std::lock_guard lock(mutex_);
+  readers_[source->fd] = source;
+#ifdef HAVE_EPOLL
+  epoll_event event{};
+  event.events = source->priority ? EPOLLPRI : EPOLLIN;
+  event.data.fd = source->fd;
+  if (epoll_ctl(poll_fd_, EPOLL_CTL_ADD, source->fd, &event) != 0) {
+    spdlog::error("Can't watch fd {}: {}", source->fd, strerror(errno));
+  }
+#else
+  wake();
+#endif
+}
+
+std::shared_ptr<Reactor::Source> Reactor::after(clock::duration delay,
+                                                std::function<void()> func) {
+  auto source = std::make_shared<Source>();
+  source->on_timeout = std::move(func);
+  std::lock_guard lock(mutex_);
+  auto it = timers_.emplace(clock::now() + delay, source);
+  if (it == timers_.begin()) {
+    // Sooner than what the loop waits for
+    wake();
+  }
+  return source;
+}
+
+void Reactor::cancel(const std::shared_ptr<Source> &source) {
+  std::unique_lock lock(mutex_);
+  source->cancelled = true;
+  if (source->fd != -1) {
+    remove(source);
+  } else {
+    for (auto it = timers_.begin(); it != timers_.end(); ++it) {
+      if (it->second == source) {
+        timers_.erase(it);
+        break;
+      }
+    }
+  }
+  // A source may be cancelled from its own callback, don't deadlock on it
+  if (source->running && source->runner != std::this_thread::get_id()) {
+    done_cv_.wait(lock, [&source] { return !source->running; });
+  }
+}
+
+void Reactor::wake() {
+  char byte = 0;
+  // A full pipe already wakes the loop up
+  (void)!::write(wake_fds_[1], &byte, 1);
+}
+
+/* Stop watching the fd of the source, called with mutex_ held */
+void Reactor::remove(const std::shared_ptr<Source> &source) {
+  auto it = readers_.find(source->fd);
+  if (it != readers_.end() && it->second == source) {
+    readers_.erase(it);
+#ifdef HAVE_EPOLL
+    epoll_ctl(poll_fd_, EPOLL_CTL_DEL, source->fd, nullptr);
+#endif
+  }
+}
+
+/* Called with mutex_ held */
+int Reactor::timeout() const {
+  if (timers_.empty()) {
+    return -1;
+  }
+  auto delay = timers_.begin()->first - clock::now();
+  if (delay <= clock::duration::zero()) {
+    return 0;
+  }
+  // Round up, waking up early would only spin
+  return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(delay).count());
+}
+
+void Reactor::loop() {
+#ifdef HAVE_EPOLL
+  std::array<epoll_event, 32> events;
+#else
+  std::vector<pollfd> fds;
+#endif
+  std::vector<int> ready;
+  std::unique_lock lock(mutex_);
+  while (!stop_) {
+    ready.clear();
+    auto wait_ms = timeout();
+#ifdef HAVE_EPOLL
+    lock.unlock();
+    int count = epoll_wait(poll_fd_, events.data(), events.size(), wait_ms);
+    lock.lock();
+    for (int i = 0; i < count; ++i) {
+      ready.push_back(events[i].data.fd);
+    }
+#else
+    fds.clear();
+    fds.push_back({wake_fds_[0], POLLIN, 0});
+    for (const auto &[fd, source] : readers_) {
+      fds.push_back({fd, static_cast<short>(source->priority ? POLLPRI : POLLIN), 0});
+    }
+    lock.unlock();
+    int count = ::poll(fds.data(), fds.size(), wait_ms);
+    lock.lock();
+    for (const auto &fd : fds) {
+      if (count > 0 && fd.revents != 0) {
+        ready.push_back(fd.fd);
+      }
+    }
+#endif
+    if (count == -1 && errno != EINTR) {
+      spdlog::error("Reactor wait failed: {}", strerror(errno));
+    }
+
+    for (auto fd : ready) {
+      if (fd == wake_fds_[0]) {
+        std::array<char, 64> drain;
+        while (::read(fd, drain.data(), drain.size()) > 0) {
+        }
+        continue;
+      }
+      auto it = readers_.find(fd);
+      if (it == readers_.end()) {
+        continue;
+      }
+      auto source = it->second;
+      if (source->on_ready) {
+        remove(source);
+        lock.unlock();
+        run(source, source->on_ready);
+      } else {
+        lock.unlock();
+        read(source);
+      }
+      lock.lock();
+    }
+
+    auto now = clock::now();
+    while (!timers_.empty() && timers_.begin()->first <= now) {
+      auto source = timers_.begin()->second;
+      timers_.erase(timers_.begin());
+      lock.unlock();
+      run(source, source->on_timeout);
+      lock.lock();
+    }
+  }
+}
+
+/* Drain the fd of a reader up to READ_BUDGET, called without mutex_ held */
+void Reactor::read(const std::shared_ptr<Source> &source) {
+  // Running for the whole read, so that cancel() waits before the owner closes the fd
+  if (!acquire(source)) {
+    return;
+  }
+  size_t budget = READ_BUDGET;
+  while (true) {
+    if (budget == 0) {
+      // Still readable, so the wait reports the fd again right away
+      release(source);
+      return;
+    }
+    auto len = ::read(source->fd, chunk_.data(), std::min(chunk_.size(), budget));
+    if (len < 0 && errno == EINTR) {
+      continue;
+    }
+    if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      release(source);
+      return;
+    }
+    if (len > 0) {
+      budget -= len;
+    }
+    if (len <= 0) {
+      break;
+    }
+    std::string_view data(chunk_.data(), len);
+    while (!data.empty()) {
+      auto newline = data.find('\n');
+      auto complete = newline != std::string_view::npos;
+      auto part = data.substr(0, newline);
+      auto room = MAX_LINE - source->line.size();
+      if (part.size() > room) {
+        part = part.substr(0, room);
+        complete = false;
+      }
+      source->line.append(part);
+      data.remove_prefix(part.size() + (complete ? 1 : 0));
+      if (complete || source->line.size() == MAX_LINE) {
+        auto active = call(source, [&source] { source->on_line(source->line); });
+        // Keeps the capacity for the next lines
+        source->line.clear();
+        if (!active) {
+          release(source);
+          return;
+        }
+      }
+    }
+  }
+
+  // End of stream, or an error which ends it as well
+  {
+    std::lock_guard lock(mutex_);
+    remove(source);
+  }
+  if (source->line.empty() || call(source, [&source] { source->on_line(source->line); })) {
+    call(source, source->on_eof);
+  }
+  release(source);
+}
+
+/* Run a one-shot callback, called without mutex_ held */
+void Reactor::run(const std::shared_ptr<Source> &source, const std::function<void()> &func) {
+  if (acquire(source)) {
+    call(source, func);
+    release(source);
+  }
+}
+
+/* Mark the source running unless it was cancelled */
+bool Reactor::acquire(const std::shared_ptr<Source> &source) {
+  std::lock_guard lock(mutex_);
+  if (source->cancelled) {
+    return false;
+  }
+  source->running = true;
+  source->runner = std::this_thread::get_id();
+  return true;
+}
+
+void Reactor::release(const std::shared_ptr<Source> &source) {
+  std::lock_guard lock(mutex_);
+  source->running = false;
+  done_cv_.notify_all();
+}
+
+/* Run a callback of an acquired source, returns false if it got cancelled meanwhile */
+bool Reactor::call(const std::shared_ptr<Source> &source, const std::function<void()> &func) {
+  try {
+    Metrics::Scope scope(source->owner);
+    func();
+  } catch (const std::exception &e) {
+    spdlog::error("Reactor callback failed: {}", e.what());
+  }
+  std::lock_guard lock(mutex_);
+  return !source->cancelled;
+}
+
+void ReactorHandle::readLines(int fd, Reactor::LineHandler on_line,
+                              std::function<void()> on_eof) {
+  replace([&] { return Reactor::inst().readLines(fd, std::move(on_line), std::move(on_eof)); });
+}
+
+void ReactorHandle::readable(int fd, std::function<void()> on_ready, bool priority) {
+  replace([&] { return Reactor::inst().readable(fd, std::move(on_ready), priority); });
+}
+
+void ReactorHandle::replace(const std::function<std::shared_ptr<Reactor::Source>()> &start) {
+  std::shared_ptr<Reactor::Source> previous;
+  {
+    std::lock_guard lock(mutex_);
+    if (stopped_) {
+      return;
+    }
+    previous = std::exchange(source_, nullptr);
+  }
+  // Before starting the new one, it may be for the same fd number
+  if (previous) {
+    Reactor::inst().cancel(previous);
+  }
+  std::lock_guard lock(mutex_);
+  if (!stopped_) {
+    source_ = start();
+  }
+}
+
+void ReactorHandle::stop() {
+  std::shared_ptr<Reactor::Source> source;
+  {
+    std::lock_guard lock(mutex_);
+    stopped_ = true;
+    source = std::exchange(source_, nullptr);
+  }
+  if (source) {
+    Reactor::inst().cancel(source);
+  }
+}
+
+}  // namespace wabar::util
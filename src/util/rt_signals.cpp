@@ -0,0 +1,121 @@
+#include "util/rt_signals.hpp"
+
+#include <fcntl.h>
+#include <glibmm/main.h>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+#ifdef HAVE_SIGNALFD
+#include <sys/signalfd.h>
+#endif
+
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <utility>
+
+namespace wabar::util {
+
+#ifdef HAVE_SIGNALFD
+static sigset_t rtSignalMask() {
+  sigset_t mask;
+  sigemptyset(&mask);
+  for (int sig = SIGRTMIN + 1; sig <= SIGRTMAX; ++sig) {
+    sigaddset(&mask, sig);
+  }
+  return mask;
+}
+#else
+// Written by the signal handler
+static int pipe_write_fd = -1;
+#endif
+
+RtSignals &RtSignals::inst() {
+  static RtSignals instance;
+  return instance;
+}
+
+RtSignals::~RtSignals() {
+  if (fd_ != -1) {
+    ::close(fd_);
+  }
+}
+
+void RtSignals::block() {
+#ifdef HAVE_SIGNALFD
+  // Inherited by the threads started afterwards, a signal then only ever reaches the signalfd.
+  // Commands get an empty mask, see command::spawn.
+  auto mask = rtSignalMask();
+  int err = pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+  if (err != 0) {
+    spdlog::error("Unable to block the real-time signals: {}", strerror(err));
+  }
+#endif
+}
+
+void RtSignals::start(Handler handler) {
+  handler_ = std::move(handler);
+  if (fd_ != -1) {
+    return;
+  }
+#ifdef HAVE_SIGNALFD
+  auto mask = rtSignalMask();
+  fd_ = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+  if (fd_ == -1) {
+    spdlog::error("Unable to create a signalfd: {}", strerror(errno));
+    return;
+  }
+#else
+  int fds[2];
+  if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+    spdlog::error("Unable to create the signal pipe: {}", strerror(errno));
+    return;
+  }
+  fd_ = fds[0];
+  pipe_write_fd = fds[1];
+  for (int sig = SIGRTMIN + 1; sig <= SIGRTMAX; ++sig) {
+    std::signal(sig, [](int sig) {
+      int err = errno;
+      auto offset = static_cast<unsigned char>(sig - SIGRTMIN);
+      // A full pipe already has this burst pending
+      (void)!::write(pipe_write_fd, &offset, 1);
+      errno = err;
+    });
+  }
+#endif
+  dp_.connect(sigc::mem_fun(*this, &RtSignals::dispatch));
+  Glib::signal_io().connect(sigc::mem_fun(*this, &RtSignals::read), fd_, Glib::IO_IN);
+}
+
+bool RtSignals::read(Glib::IOCondition /*condition*/) {
+#ifdef HAVE_SIGNALFD
+  std::array<signalfd_siginfo, 16> infos;
+  ssize_t len;
+  while ((len = ::read(fd_, infos.data(), sizeof(infos))) > 0) {
+    for (size_t i = 0; i < static_cast<size_t>(len) / sizeof(signalfd_siginfo); ++i) {
+      pending_.insert(static_cast<int>(infos[i].ssi_signo));
+    }
+  }
+#else
+  std::array<unsigned char, 64> offsets;
+  ssize_t len;
+  while ((len = ::read(fd_, offsets.data(), offsets.size())) > 0) {
+    for (ssize_t i = 0; i < len; ++i) {
+      pending_.insert(SIGRTMIN + offsets[i]);
+    }
+  }
+#endif
+  if (!pending_.empty()) {
+    dp_.emit();
+  }
+  return true;
+}
+
+void RtSignals::dispatch() {
+  for (auto sig : std::exchange(pending_, {})) {
+    handler_(sig);
+  }
+}
+
+}  // namespace wabar::util
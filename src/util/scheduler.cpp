@@ -0,0 +1,267 @@
+#include "util/scheduler.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+#include "util/prepare_for_sleep.h"
+
+namespace wabar::util {
+
+struct Scheduler::Task {
+  uint64_t id;
+  duration interval;
+  Align align;
+  std::function<void()> func;
+
+  // Guarded by Scheduler::mutex_
+  bool queued = false;
+  bool running = false;
+  bool pending = false;
+  bool cancelled = false;
+  std::thread::id runner;
+  clock::time_point queued_at;
+};
+
+Scheduler &Scheduler::inst() {
+  static Scheduler instance;
+  return instance;
+}
+
+Scheduler::Scheduler() {
+  // Timers don't tick while suspended, refresh everything on resume as SleeperThread does
+  sleep_connection_ = prepare_for_sleep().connect([this](bool sleep) {
+    if (not sleep) wakeUpAll();
+  });
+  timer_thread_ = std::thread(&Scheduler::timerLoop, this);
+}
+
+Scheduler::~Scheduler() {
+  sleep_connection_.disconnect();
+  {
+    std::lock_guard lock(mutex_);
+    stop_ = true;
+  }
+  timer_cv_.notify_all();
+  worker_cv_.notify_all();
+  if (timer_thread_.joinable()) {
+    timer_thread_.join();
+  }
+  for (auto &worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+std::shared_ptr<Scheduler::Task> Scheduler::add(duration interval, std::function<void()> func,
+                                                Align align) {
+  auto task = std::make_shared<Task>();
+  task->interval = std::max(interval, TICK);
+  task->align = align;
+  task->func = std::move(func);
+
+  std::lock_guard lock(mutex_);
+  task->id = next_id_++;
+  tasks_.emplace(task->id, task);
+  dispatch(task);
+  return task;
+}
+
+void Scheduler::wakeUp(const std::shared_ptr<Task> &task) {
+  std::lock_guard lock(mutex_);
+  if (task->cancelled) {
+    return;
+  }
+  wheel_.remove(task->id);
+  dispatch(task);
+}
+
+void Scheduler::wakeUpAll() {
+  std::lock_guard lock(mutex_);
+  for (auto &[id, task] : tasks_) {
+    wheel_.remove(id);
+    dispatch(task);
+  }
+}
+
+void Scheduler::cancel(const std::shared_ptr<Task> &task) {
+  std::unique_lock lock(mutex_);
+  task->cancelled = true;
+  wheel_.remove(task->id);
+  tasks_.erase(task->id);
+  // A task may cancel itself from its own callback, don't deadlock on it
+  if (task->running && task->runner != std::this_thread::get_id()) {
+    done_cv_.wait(lock, [&task] { return !task->running; });
+  }
+}
+
+void Scheduler::setSlack(duration slack) {
+  std::lock_guard lock(mutex_);
+  slack_ = std::max(slack, TICK);
+}
+
+TimerWheel::tick_t Scheduler::toTick(clock::time_point tp) const {
+  if (tp <= epoch_) {
+    return 0;
+  }
+  return std::chrono::duration_cast<duration>(tp - epoch_) / TICK;
+}
+
+/* Called with mutex_ held */
+void Scheduler::dispatch(const std::shared_ptr<Task> &task) {
+  if (task->running) {
+    // Run once more right after the current run completes
+    task->pending = true;
+    return;
+  }
+  if (task->queued) {
+    return;
+  }
+  task->queued = true;
+  task->queued_at = clock::now();
+  ready_.push_back(task);
+  if (idle_ + starting_ < ready_.size() && live_ < MAX_WORKERS) {
+    spawn();
+  } else {
+    worker_cv_.notify_one();
+  }
+  if (idle_ + starting_ == 0) {
+    // Every worker is busy, the timer thread adds one if this waits too long
+    timer_cv_.notify_one();
+  }
+}
+
+/* Called with mutex_ held */
+void Scheduler::spawn() {
+  for (auto id : finished_) {
+    auto it = std::find_if(workers_.begin(), workers_.end(),
+                           [id](const auto &worker) { return worker.get_id() == id; });
+    // It released mutex_ on its way out, so this doesn't wait for long
+    it->join();
+    workers_.erase(it);
+  }
+  finished_.clear();
+  ++live_;
+  ++starting_;
+  workers_.emplace_back(&Scheduler::workerLoop, this);
+}
+
+/* Called with mutex_ held */
+bool Scheduler::stalled() const {
+  return !ready_.empty() && idle_ + starting_ == 0 && live_ < MAX_WORKERS + MAX_EXTRA_WORKERS;
+}
+
+/* Called with mutex_ held */
+void Scheduler::rearm(const std::shared_ptr<Task> &task) {
+  if (task->interval == duration::max()) {
+    // Wake up only
+    return;
+  }
+  auto delay = std::chrono::duration_cast<clock::duration>(task->interval);
+  if (task->align != Align::NONE) {
+    auto wall = std::chrono::system_clock::now().time_since_epoch();
+    if (task->align == Align::INTERVAL) {
+      delay = std::chrono::duration_cast<clock::duration>(task->interval - wall % task->interval);
+    } else if (task->interval % std::chrono::seconds(1) == duration::zero()) {
+      delay = std::chrono::duration_cast<clock::duration>(task->interval -
+                                                          wall % std::chrono::seconds(1));
+    }
+  }
+  // Never fire early: round up to the tick, then up to the slack window
+  auto elapsed = clock::now() + delay - epoch_;
+  auto ticks = static_cast<TimerWheel::tick_t>((elapsed + TICK - clock::duration(1)) / TICK);
+  auto slack_ticks = static_cast<TimerWheel::tick_t>(slack_ / TICK);
+  auto deadline = (ticks + slack_ticks - 1) / slack_ticks * slack_ticks;
+  wheel_.insert(task->id, deadline);
+  timer_cv_.notify_one();
+}
+
+void Scheduler::timerLoop() {
+  std::vector<TimerWheel::id_t> expired;
+  std::unique_lock lock(mutex_);
+  while (!stop_) {
+    expired.clear();
+    wheel_.advance(toTick(clock::now()), expired);
+    for (auto id : expired) {
+      auto it = tasks_.find(id);
+      if (it != tasks_.end()) {
+        dispatch(it->second);
+      }
+    }
+    auto wake = clock::time_point::max();
+    if (auto next = wheel_.nextExpiry()) {
+      wake = epoch_ + TICK * static_cast<int64_t>(*next);
+    }
+    if (stalled()) {
+      auto deadline = ready_.front()->queued_at + STALL_TIMEOUT;
+      if (deadline <= clock::now()) {
+        spawn();
+        continue;
+      }
+      wake = std::min(wake, deadline);
+    }
+    if (wake == clock::time_point::max()) {
+      timer_cv_.wait(lock);
+    } else {
+      timer_cv_.wait_until(lock, wake);
+    }
+  }
+}
+
+void Scheduler::workerLoop() {
+  std::unique_lock lock(mutex_);
+  --starting_;
+  auto ready = [this] { return stop_ || !ready_.empty(); };
+  while (true) {
+    ++idle_;
+    bool woken = true;
+    if (live_ > MAX_WORKERS) {
+      woken = worker_cv_.wait_for(lock, EXTRA_IDLE_TIMEOUT, ready);
+    } else {
+      worker_cv_.wait(lock, ready);
+    }
+    --idle_;
+    if (stop_) {
+      return;
+    }
+    if (!woken) {
+      // Back to the regular pool size
+      --live_;
+      finished_.push_back(std::this_thread::get_id());
+      return;
+    }
+    auto task = ready_.front();
+    ready_.pop_front();
+    task->queued = false;
+    if (stalled()) {
+      // The timer thread stopped watching the queue while this worker was starting
+      timer_cv_.notify_one();
+    }
+    if (task->cancelled) {
+      continue;
+    }
+    task->running = true;
+    task->runner = std::this_thread::get_id();
+    lock.unlock();
+    try {
+      task->func();
+    } catch (const std::exception &e) {
+      spdlog::error("Scheduled task failed: {}", e.what());
+    }
+    lock.lock();
+    task->running = false;
+    done_cv_.notify_all();
+    if (task->cancelled) {
+      continue;
+    }
+    if (task->pending) {
+      task->pending = false;
+      dispatch(task);
+    } else {
+      rearm(task);
+    }
+  }
+}
+
+}  // namespace wabar::util
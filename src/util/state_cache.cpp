@@ -0,0 +1,123 @@
+#include "util/state_cache.hpp"
+
+#include <fmt/format.h>
+#include <json/reader.h>
+#include <json/writer.h>
+#include <spdlog/spdlog.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace wabar::util {
+
+StateCache &StateCache::inst() {
+  static StateCache instance(defaultPath());
+  return instance;
+}
+
+StateCache::StateCache(std::string path) : path_(std::move(path)) {}
+
+std::string StateCache::defaultPath() {
+  const char *cache_home = std::getenv("XDG_CACHE_HOME");
+  if (cache_home != nullptr && *cache_home != '\0') {
+    return fmt::format("{}/wabar/state.json", cache_home);
+  }
+  const char *home = std::getenv("HOME");
+  if (home != nullptr && *home != '\0') {
+    return fmt::format("{}/.cache/wabar/state.json", home);
+  }
+  return "";
+}
+
+/* Read the file on first use, called with mutex_ held */
+void StateCache::load() {
+  if (loaded_) {
+    return;
+  }
+  loaded_ = true;
+  std::ifstream file(path_);
+  if (!file) {
+    return;
+  }
+  Json::CharReaderBuilder builder;
+  Json::Value root;
+  std::string errors;
+  if (!Json::parseFromStream(builder, file, &root, &errors) || !root.isObject()) {
+    spdlog::warn("Ignoring the state cache {}: {}", path_, errors);
+    return;
+  }
+  states_ = std::move(root);
+}
+
+std::optional<ModuleState> StateCache::get(const std::string &output, const std::string &module) {
+  std::lock_guard lock(mutex_);
+  load();
+  // Const lookups, which don't add members
+  const auto &states = states_;
+  const auto &entry = states[output][module];
+  if (!entry.isObject() || !entry["markup"].isString()) {
+    return std::nullopt;
+  }
+  ModuleState state{entry["markup"].asString(), {}};
+  for (const auto &name : entry["classes"]) {
+    if (name.isString()) {
+      state.classes.push_back(name.asString());
+    }
+  }
+  return state;
+}
+
+void StateCache::set(const std::string &output, const std::string &module,
+                     const std::optional<ModuleState> &state) {
+  std::lock_guard lock(mutex_);
+  load();
+  if (!state) {
+    if (states_.isMember(output) && states_[output].isObject() &&
+        states_[output].isMember(module)) {
+      states_[output].removeMember(module);
+      dirty_ = true;
+    }
+    return;
+  }
+  auto &modules = states_[output];
+  Json::Value entry(Json::objectValue);
+  entry["markup"] = state->markup;
+  entry["classes"] = Json::Value(Json::arrayValue);
+  for (const auto &name : state->classes) {
+    entry["classes"].append(name);
+  }
+  if (modules[module] != entry) {
+    modules[module] = std::move(entry);
+    dirty_ = true;
+  }
+}
+
+void StateCache::save() {
+  std::lock_guard lock(mutex_);
+  if (!dirty_ || path_.empty()) {
+    return;
+  }
+  dirty_ = false;
+  std::error_code ec;
+  std::filesystem::create_directories(std::filesystem::path(path_).parent_path(), ec);
+  // Renamed into place, a crash while writing leaves the previous file
+  auto tmp = path_ + ".tmp";
+  {
+    std::ofstream file(tmp, std::ios::trunc);
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    file << Json::writeString(builder, states_);
+    if (!file) {
+      spdlog::warn("Unable to write the state cache {}", tmp);
+      return;
+    }
+  }
+  std::filesystem::rename(tmp, path_, ec);
+  if (ec) {
+    spdlog::warn("Unable to write the state cache {}: {}", path_, ec.message());
+  }
+}
+
+}  // namespace wabar::util
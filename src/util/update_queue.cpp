@@ -0,0 +1,182 @@
+#include "util/update_queue.hpp"
+
+#include <glibmm/main.h>
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace wabar::util {
+
+// Flush anyway if no frame is drawn in time, e.g. the bar got unmapped meanwhile
+static constexpr unsigned FRAME_TIMEOUT_MS = 100;
+
+UpdateQueue &UpdateQueue::inst() {
+  static UpdateQueue instance;
+  return instance;
+}
+
+UpdateQueue::UpdateQueue() { wakeup_.connect(sigc::mem_fun(*this, &UpdateQueue::requestFrame)); }
+
+UpdateQueue::~UpdateQueue() {
+  delay_connection_.disconnect();
+  timeout_connection_.disconnect();
+  if (paint_clock_ != nullptr) {
+    g_signal_handler_disconnect(paint_clock_, paint_handler_);
+    g_object_unref(paint_clock_);
+  }
+}
+
+void UpdateQueue::attach(Gtk::Widget &widget) { widgets_.push_back(&widget); }
+
+void UpdateQueue::detach(Gtk::Widget &widget) {
+  if (tick_widget_ == &widget) {
+    widget.remove_tick_callback(tick_id_);
+    tick_widget_ = nullptr;
+    // Let the timeout flush the pending updates
+  }
+  widgets_.erase(std::remove(widgets_.begin(), widgets_.end(), &widget), widgets_.end());
+}
+
+void UpdateQueue::setMaxFps(unsigned fps) {
+  min_frame_interval_ =
+      fps == 0 ? clock::duration::zero() : clock::duration(std::chrono::seconds(1)) / fps;
+}
+
+void UpdateQueue::schedule(UpdateDispatcher *dispatcher) {
+  {
+    std::lock_guard lock(mutex_);
+    if (dispatcher->queued_) {
+      return;
+    }
+    dispatcher->queued_ = true;
+    dispatcher->queued_at_ = clock::now();
+    dirty_.push_back(dispatcher);
+    if (wakeup_pending_) {
+      // The main loop already knows, don't write to the pipe again
+      return;
+    }
+    wakeup_pending_ = true;
+  }
+  wakeup_.emit();
+}
+
+void UpdateQueue::remove(UpdateDispatcher *dispatcher) {
+  std::lock_guard lock(mutex_);
+  if (!dispatcher->queued_) {
+    return;
+  }
+  dirty_.erase(std::remove(dirty_.begin(), dirty_.end(), dispatcher), dirty_.end());
+  flushing_.erase(std::remove(flushing_.begin(), flushing_.end(), dispatcher), flushing_.end());
+}
+
+void UpdateQueue::requestFrame() {
+  if (frame_requested_) {
+    return;
+  }
+  frame_requested_ = true;
+  auto delay = last_flush_ + min_frame_interval_ - clock::now();
+  if (delay > clock::duration::zero()) {
+    auto ms = static_cast<unsigned>(std::chrono::ceil<std::chrono::milliseconds>(delay).count());
+    delay_connection_ = Glib::signal_timeout().connect(
+        [this] {
+          waitForFrame();
+          return false;
+        },
+        ms);
+  } else {
+    waitForFrame();
+  }
+}
+
+void UpdateQueue::waitForFrame() {
+  auto widget = std::find_if(widgets_.begin(), widgets_.end(),
+                             [](auto *widget) { return widget->get_mapped(); });
+  if (widget == widgets_.end()) {
+    // No frame clock to follow
+    timeout_connection_ = Glib::signal_idle().connect([this] {
+      flush();
+      return false;
+    });
+    return;
+  }
+  tick_widget_ = *widget;
+  tick_id_ = tick_widget_->add_tick_callback([this](const Glib::RefPtr<Gdk::FrameClock> &) {
+    auto *widget = std::exchange(tick_widget_, nullptr);
+    flush(widget);
+    return false;
+  });
+  timeout_connection_ = Glib::signal_timeout().connect(
+      [this] {
+        flush();
+        return false;
+      },
+      FRAME_TIMEOUT_MS);
+}
+
+void UpdateQueue::flush(Gtk::Widget *painting) {
+  frame_requested_ = false;
+  delay_connection_.disconnect();
+  timeout_connection_.disconnect();
+  if (tick_widget_ != nullptr) {
+    tick_widget_->remove_tick_callback(tick_id_);
+    tick_widget_ = nullptr;
+  }
+  last_flush_ = clock::now();
+
+  std::unique_lock lock(mutex_);
+  flushing_.swap(dirty_);
+  wakeup_pending_ = false;
+  while (!flushing_.empty()) {
+    auto *dispatcher = flushing_.front();
+    flushing_.pop_front();
+    // Emissions from the update itself are handled on the next frame
+    dispatcher->queued_ = false;
+    auto queued_at = dispatcher->queued_at_;
+    auto latency_cb = dispatcher->latency_cb_;
+    lock.unlock();
+    dispatcher->signal_.emit();
+    if (latency_cb) {
+      painting_.emplace_back(queued_at, std::move(latency_cb));
+    }
+    lock.lock();
+  }
+  lock.unlock();
+
+  auto *frame_clock =
+      painting != nullptr ? gtk_widget_get_frame_clock(painting->gobj()) : nullptr;
+  if (frame_clock == nullptr) {
+    // Not drawn in sync with a frame, the update is as visible as it gets
+    reportLatency();
+  } else if (paint_clock_ == nullptr) {
+    // Referenced, the window may go away before painting
+    paint_clock_ = GDK_FRAME_CLOCK(g_object_ref(frame_clock));
+    paint_handler_ =
+        g_signal_connect(frame_clock, "after-paint", G_CALLBACK(handleAfterPaint), this);
+  }
+}
+
+void UpdateQueue::reportLatency() {
+  if (paint_clock_ != nullptr) {
+    g_signal_handler_disconnect(paint_clock_, paint_handler_);
+    g_object_unref(std::exchange(paint_clock_, nullptr));
+  }
+  auto now = clock::now();
+  for (auto &[queued_at, callback] : painting_) {
+    callback(now - queued_at);
+  }
+  painting_.clear();
+}
+
+void UpdateQueue::handleAfterPaint(GdkFrameClock * /*clock*/, gpointer data) {
+  static_cast<UpdateQueue *>(data)->reportLatency();
+}
+
+UpdateDispatcher::UpdateDispatcher() {
+  // Make sure the queue is created on the main thread
+  UpdateQueue::inst();
+}
+
+UpdateDispatcher::~UpdateDispatcher() { UpdateQueue::inst().remove(this); }
+
+}  // namespace wabar::util
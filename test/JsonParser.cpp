@@ -42,4 +42,30 @@ TEST_CASE("Json with chinese characters", "[json]") {
     Json::Value jsonValue = parser.parse(stringToTest);
     REQUIRE(jsonValue["test"].asString() == "你好");
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Json with hexadecimal escapes", "[json]") {
+  wabar::util::JsonParser parser;
+
+  SECTION("Every escape is translated") {
+    auto jsonValue = parser.parse(R"({"a": "\xab\x41", "b": ["\x62"]})");
+    REQUIRE(jsonValue["a"].asString() == "\u00abA");
+    REQUIRE(jsonValue["b"][0].asString() == "b");
+  }
+
+  SECTION("Escaped backslashes are left alone") {
+    auto jsonValue = parser.parse(R"({"path": "C:\\xyz", "mixed": "\\\x41"})");
+    REQUIRE(jsonValue["path"].asString() == "C:\\xyz");
+    REQUIRE(jsonValue["mixed"].asString() == "\\A");
+  }
+
+  SECTION("Parses from a view into a larger buffer") {
+    std::string buffer = R"({"a": 1}{"b": 2})";
+    auto jsonValue = parser.parse(std::string_view(buffer).substr(0, 8));
+    REQUIRE(jsonValue["a"].asInt() == 1);
+  }
+
+  SECTION("Invalid input throws") {
+    REQUIRE_THROWS_AS(parser.parse(R"({"a": )"), std::runtime_error);
+  }
+}
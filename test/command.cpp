@@ -0,0 +1,192 @@
+#include "util/command.hpp"
+
+#include "util/exec_cache.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+#include <sys/stat.h>
+
+#include <atomic>
+#include <future>
+#include <thread>
+
+namespace command = wabar::util::command;
+
+using Words = std::vector<std::string>;
+
+TEST_CASE("Split plain commands into words", "[command]") {
+  SECTION("Words are separated by blanks") {
+    REQUIRE(command::splitWords("playerctl metadata") == Words{"playerctl", "metadata"});
+    REQUIRE(command::splitWords("  mpc\tcurrent  ") == Words{"mpc", "current"});
+    REQUIRE(command::splitWords("notify-send --urgency=low hi") ==
+            Words{"notify-send", "--urgency=low", "hi"});
+  }
+
+  SECTION("Anything the shell would interpret is left to it") {
+    for (const auto* cmd : {"checkupdates | wc -l", "echo $HOME", "cmus-remote -C \"format\"",
+                            "echo 'a b'", "ls *.txt", "script 2> /dev/null", "a && b", "a; b",
+                            "echo ~", "echo `date`", "FOO=1 script", "echo a\\ b", "echo a # b"}) {
+      CAPTURE(cmd);
+      REQUIRE_FALSE(command::splitWords(cmd).has_value());
+    }
+  }
+
+  SECTION("Blank commands have no words") {
+    REQUIRE_FALSE(command::splitWords("").has_value());
+    REQUIRE_FALSE(command::splitWords(" \t ").has_value());
+  }
+}
+
+TEST_CASE("Run commands", "[command]") {
+  SECTION("Plain commands run without a shell") {
+    auto res = command::exec("printf %s_%s a b", "");
+    REQUIRE(res.exit_code == 0);
+    REQUIRE(res.out == "a_b");
+  }
+
+  SECTION("Shell builtins fall back to the shell") {
+    REQUIRE(command::exec("exit 3", "").exit_code == 3);
+  }
+
+  SECTION("Arguments are passed verbatim") {
+    auto res = command::exec(Words{"printf", "%s|", "a b", "$HOME"}, "");
+    REQUIRE(res.exit_code == 0);
+    REQUIRE(res.out == "a b|$HOME|");
+  }
+
+  SECTION("The output name is exported") {
+    REQUIRE(command::exec("echo $WAYBAR_OUTPUT_NAME", "DP-1").out == "DP-1");
+    REQUIRE(command::exec(Words{"printenv", "WAYBAR_OUTPUT_NAME"}, "DP-2").out == "DP-2");
+  }
+
+  SECTION("Scripts without a shebang run with the shell") {
+    char path[] = "/tmp/wabar-test-script-XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd != -1);
+    std::string script = "echo \"$1\"; exit 4\n";
+    REQUIRE(::write(fd, script.data(), script.size()) == static_cast<ssize_t>(script.size()));
+    fchmod(fd, 0700);
+    ::close(fd);
+    auto plain = command::exec(std::string(path) + " hi", "");
+    auto args = command::exec(Words{path, "there"}, "");
+    unlink(path);
+    REQUIRE(plain.exit_code == 4);
+    REQUIRE(plain.out == "hi");
+    REQUIRE(args.out == "there");
+  }
+
+  SECTION("Missing programs fail to spawn") {
+    REQUIRE(command::exec(Words{"wabar-test-missing-program"}, "").exit_code == -1);
+  }
+}
+
+TEST_CASE("Bound command output", "[command]") {
+  using namespace std::chrono_literals;
+
+  SECTION("Large output is read whole") {
+    auto res = command::exec("head -c 3000000 /dev/zero | tr '\\0' a", "",
+                             {.max_output = 4 * 1024 * 1024});
+    REQUIRE(res.exit_code == 0);
+    REQUIRE(res.out.size() == 3000000);
+  }
+
+  SECTION("Output past the limit is dropped up to the last whole line") {
+    auto res = command::exec("printf '{\"a\":1}\\n{\"a\":2}\\n{\"a\":3}\\n'", "",
+                             {.max_output = 20});
+    REQUIRE(res.exit_code == 0);
+    REQUIRE(res.out == "{\"a\":1}\n{\"a\":2}");
+  }
+
+  SECTION("Without room for any output, all of it is drained") {
+    auto res = command::exec("head -c 100000 /dev/zero", "", {.max_output = 0});
+    REQUIRE(res.exit_code == 0);
+    REQUIRE(res.out.empty());
+  }
+
+  SECTION("Commands running too long are killed with their children") {
+    auto start = std::chrono::steady_clock::now();
+    auto res = command::exec("echo started; sleep 5; echo done", "", {.timeout = 100ms});
+    REQUIRE(std::chrono::steady_clock::now() - start < 2s);
+    REQUIRE(res.exit_code == 128 + SIGKILL);
+    REQUIRE(res.out == "started");
+  }
+}
+
+TEST_CASE("Share command results", "[command]") {
+  using namespace std::chrono_literals;
+  command::ExecCache cache;
+  std::atomic<int> runs = 0;
+  auto run = [&] {
+    std::this_thread::sleep_for(20ms);
+    return command::res{0, std::to_string(++runs)};
+  };
+
+  SECTION("Concurrent callers join the run in flight") {
+    std::vector<std::future<command::res>> results;
+    for (int i = 0; i < 4; ++i) {
+      results.push_back(std::async(std::launch::async, [&] { return cache.get("cmd", 1h, run); }));
+    }
+    for (auto &result : results) {
+      REQUIRE(result.get().out == "1");
+    }
+    REQUIRE(runs == 1);
+  }
+
+  SECTION("Results are reused for the ttl") {
+    REQUIRE(cache.get("cmd", 1h, run).out == "1");
+    REQUIRE(cache.get("cmd", 1h, run).out == "1");
+    REQUIRE(cache.get("other", 1h, run).out == "2");
+    REQUIRE(cache.get("cmd", 0s, run).out == "3");
+  }
+
+  SECTION("A failed run is reported to the callers that joined it") {
+    auto fail = [&]() -> command::res {
+      std::this_thread::sleep_for(20ms);
+      throw std::runtime_error("failed");
+    };
+    std::vector<std::future<command::res>> results;
+    for (int i = 0; i < 4; ++i) {
+      results.push_back(
+          std::async(std::launch::async, [&] { return cache.get("cmd", 1h, fail); }));
+    }
+    for (auto &result : results) {
+      REQUIRE_THROWS_AS(result.get(), std::runtime_error);
+    }
+    // Not cached, the next caller runs it again
+    REQUIRE(cache.get("cmd", 1h, run).out == "1");
+  }
+}
+
+TEST_CASE("Reap background commands", "[command]") {
+  std::promise<int> status;
+  auto child = command::forkExec("exit 3", [&status](int wstatus) { status.set_value(wstatus); });
+  REQUIRE(child != nullptr);
+  auto exited = status.get_future();
+  // Without pidfds, children are polled on SIGCHLD by the signal thread of main.cpp
+  while (exited.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready) {
+    wabar::util::ChildSupervisor::inst().reapPolled();
+  }
+  auto wstatus = exited.get();
+  REQUIRE(WIFEXITED(wstatus));
+  REQUIRE(WEXITSTATUS(wstatus) == 3);
+  REQUIRE(child->exited());
+  REQUIRE(waitpid(child->pid(), nullptr, WNOHANG) == -1);
+}
+
+TEST_CASE("Report the signal that killed a background command", "[command]") {
+  std::promise<int> status;
+  auto child =
+      command::forkExec("kill -KILL $$", [&status](int wstatus) { status.set_value(wstatus); });
+  REQUIRE(child != nullptr);
+  auto exited = status.get_future();
+  while (exited.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready) {
+    wabar::util::ChildSupervisor::inst().reapPolled();
+  }
+  auto wstatus = exited.get();
+  REQUIRE(WIFSIGNALED(wstatus));
+  REQUIRE(WTERMSIG(wstatus) == SIGKILL);
+}
@@ -0,0 +1,108 @@
+#include "util/config_view.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+#include "util/json.hpp"
+
+using wabar::util::ConfigView;
+
+namespace {
+
+ConfigView view(const std::string &config) {
+  return ConfigView(wabar::util::JsonParser().parse(config), "test");
+}
+
+}  // namespace
+
+TEST_CASE("Formats are looked up by state", "[config_view]") {
+  auto config = view(R"({
+    "format": "{usage}%",
+    "format-critical": "! {usage}%",
+    "format-charging-critical": "+! {usage}%",
+    "format-alt-click": 3,
+    "tooltip-format-critical": "critical"
+  })");
+  REQUIRE(*config.format("critical") == "! {usage}%");
+  REQUIRE(*config.format("charging-critical") == "+! {usage}%");
+  REQUIRE(*config.tooltipFormat("critical") == "critical");
+  REQUIRE(config.format("") == nullptr);
+  REQUIRE(config.format("warning") == nullptr);
+  REQUIRE(config.format("alt-click") == nullptr);
+  REQUIRE(config.tooltipFormat("warning") == nullptr);
+}
+
+TEST_CASE("States are sorted by threshold", "[config_view]") {
+  auto config = view(R"({"states": {
+    "warning": 70, "critical": 90, "high": 90, "low": 0, "bad": -1, "worse": "x"
+  }})");
+  const auto &states = config.states();
+  REQUIRE(states.size() == 3);
+  REQUIRE(states[0].name == "low");
+  REQUIRE(states[1].name == "warning");
+  REQUIRE(states[1].threshold == 70);
+  REQUIRE(states[2].name == "critical");
+  REQUIRE(states[2].threshold == 90);
+}
+
+TEST_CASE("Icons are tabled by alt", "[config_view]") {
+  SECTION("An array is used for every alt") {
+    auto config = view(R"({"format-icons": ["a", 1, "c"]})");
+    REQUIRE(*config.icons() == ConfigView::IconTable{"a", "", "c"});
+    REQUIRE(config.icons("charging") == config.icons());
+  }
+
+  SECTION("A string is a table of one") {
+    auto config = view(R"({"format-icons": "x"})");
+    REQUIRE(*config.icons("muted") == ConfigView::IconTable{"x"});
+  }
+
+  SECTION("Alts fall back to the default icons") {
+    auto config = view(R"({"format-icons": {"default": ["d"], "muted": "m", "bad": 3}})");
+    REQUIRE(*config.icons("muted") == ConfigView::IconTable{"m"});
+    REQUIRE(*config.icons("bad") == ConfigView::IconTable{"d"});
+    REQUIRE(*config.icons() == ConfigView::IconTable{"d"});
+    REQUIRE(*config.icons(std::vector<std::string>{"", "unknown", "muted"}) ==
+            ConfigView::IconTable{"m"});
+  }
+
+  SECTION("No icons") {
+    REQUIRE(view(R"({"format-icons": {"muted": "m"}})").icons("other") == nullptr);
+    REQUIRE(view("{}").icons() == nullptr);
+  }
+}
+
+TEST_CASE("Commands and actions are kept by event", "[config_view]") {
+  auto config = view(R"({
+    "on-click": "pavucontrol",
+    "on-scroll-up": "up",
+    "on-clik": "typo",
+    "on-update": 3,
+    "actions": {"on-click-right": "mode", "on-scroll-down": 2}
+  })");
+  REQUIRE(*config.command("on-click") == "pavucontrol");
+  REQUIRE(*config.command("on-scroll-up") == "up");
+  REQUIRE(config.command("on-clik") == nullptr);
+  REQUIRE(config.command("on-update") == nullptr);
+  REQUIRE(config.actions() == std::map<std::string, std::string>{{"on-click-right", "mode"}});
+}
+
+TEST_CASE("Placeholders of every format are collected", "[config_view]") {
+  auto config = view(R"({
+    "format": "{usage}%",
+    "format-alt": "{load}",
+    "format-critical": "{icon}",
+    "tooltip-format-critical": "{max_frequency}",
+    "format-icons": ["a", "b"],
+    "on-click": "notify-send {}"
+  })");
+  const auto &fields = config.fields();
+  REQUIRE(fields.contains("usage"));
+  REQUIRE(fields.contains("load"));
+  REQUIRE(fields.contains("icon"));
+  REQUIRE(fields.contains("max_frequency"));
+  REQUIRE_FALSE(fields.contains("avg_frequency"));
+}
@@ -0,0 +1,78 @@
+#include "util/file_watcher.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using wabar::util::FileWatcher;
+
+namespace {
+
+// Contents seen by a watcher, waited on from the test thread
+struct Changes {
+  void push(const std::string &content) {
+    std::lock_guard lock(mutex);
+    contents.push_back(content);
+    cv.notify_all();
+  }
+  std::vector<std::string> waitFor(size_t count) {
+    std::unique_lock lock(mutex);
+    cv.wait_for(lock, std::chrono::seconds(5), [this, count] { return contents.size() >= count; });
+    return contents;
+  }
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<std::string> contents;
+};
+
+void write(const std::filesystem::path &path, const std::string &content) {
+  std::ofstream(path) << content;
+}
+
+}  // namespace
+
+TEST_CASE("FileWatcher reads a file again on change", "[file_watcher]") {
+  auto dir = std::filesystem::temp_directory_path() / "wabar-file-watcher-test";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  auto path = dir / "state";
+  Changes changes;
+
+  SECTION("Writes and replacements are picked up") {
+    write(path, "first\n");
+    FileWatcher watcher(path, [&changes](const auto &content) { changes.push(content); });
+    REQUIRE(changes.waitFor(1) == std::vector<std::string>{"first\n"});
+
+    write(path, "second\n");
+    REQUIRE(changes.waitFor(2).back() == "second\n");
+
+    write(dir / "other", "ignored\n");
+    write(dir / "state.tmp", "third\n");
+    std::filesystem::rename(dir / "state.tmp", path);
+    REQUIRE(changes.waitFor(3).back() == "third\n");
+
+    std::filesystem::remove(path);
+    REQUIRE(changes.waitFor(4).back().empty());
+    REQUIRE(changes.waitFor(4).size() == 4);
+  }
+
+  SECTION("A file created later is picked up") {
+    FileWatcher watcher(path, [&changes](const auto &content) { changes.push(content); });
+    REQUIRE(changes.waitFor(1) == std::vector<std::string>{""});
+    write(path, "created\n");
+    REQUIRE(changes.waitFor(2).back() == "created\n");
+  }
+
+  std::filesystem::remove_all(dir);
+}
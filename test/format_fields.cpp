@@ -0,0 +1,41 @@
+#include "util/format_fields.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+using wabar::util::FormatFields;
+
+TEST_CASE("Named arguments of a format are found", "[format_fields]") {
+  FormatFields fields("{icon} {usage:>3}% {{load}} {avg_frequency:.{precision}f}GHz}}");
+  REQUIRE_FALSE(fields.any());
+  REQUIRE(fields.contains("icon"));
+  REQUIRE(fields.contains("usage"));
+  REQUIRE(fields.contains("avg_frequency"));
+  REQUIRE(fields.contains("precision"));
+  REQUIRE_FALSE(fields.contains("load"));
+  REQUIRE_FALSE(fields.contains("max_frequency"));
+}
+
+TEST_CASE("Names are looked up by prefix", "[format_fields]") {
+  FormatFields fields("{icon2}");
+  REQUIRE(fields.containsPrefix("icon"));
+  REQUIRE_FALSE(fields.containsPrefix("usage"));
+  REQUIRE_FALSE(fields.contains("icon"));
+
+  fields.add(FormatFields("{usage}"));
+  REQUIRE(fields.containsPrefix("usage"));
+  REQUIRE_FALSE(fields.containsPrefix("usages"));
+}
+
+TEST_CASE("Positional and invalid formats may show anything", "[format_fields]") {
+  REQUIRE(FormatFields("{}%").contains("usage"));
+  REQUIRE(FormatFields("{0:>3}").containsPrefix("icon"));
+  REQUIRE(FormatFields("{usage").any());
+  REQUIRE(FormatFields("{usage:{width}").any());
+  REQUIRE(FormatFields("usage}").any());
+  REQUIRE_FALSE(FormatFields("{{}}").any());
+  REQUIRE_FALSE(FormatFields().contains("usage"));
+}
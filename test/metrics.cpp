@@ -0,0 +1,92 @@
+#include "util/metrics.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+using wabar::util::Histogram;
+using wabar::util::Metrics;
+
+TEST_CASE("Histogram buckets", "[metrics]") {
+  SECTION("Small values are exact") {
+    for (uint64_t value = 0; value < Histogram::SUB_BUCKETS; ++value) {
+      REQUIRE(Histogram::upperBound(Histogram::index(value)) == value);
+    }
+  }
+
+  SECTION("Larger values are within a sub bucket") {
+    for (uint64_t value : {9UL, 100UL, 1000UL, 12345UL, 1UL << 30}) {
+      auto bound = Histogram::upperBound(Histogram::index(value));
+      REQUIRE(bound >= value);
+      REQUIRE(bound - value <= value / Histogram::SUB_BUCKETS);
+    }
+  }
+
+  SECTION("Huge values land in the last bucket") {
+    REQUIRE(Histogram::index(UINT64_MAX >> (64 - Histogram::MAX_BITS)) == Histogram::BUCKETS - 1);
+  }
+}
+
+TEST_CASE("Histogram percentiles", "[metrics]") {
+  Histogram histogram;
+  REQUIRE(histogram.percentile(0.5) == 0);
+  for (uint64_t value = 1; value <= 1000; ++value) {
+    histogram.record(value);
+  }
+  histogram.record(UINT64_MAX);
+
+  REQUIRE(histogram.count() == 1001);
+  REQUIRE(histogram.min() == 1);
+  REQUIRE(histogram.max() == (uint64_t{1} << Histogram::MAX_BITS) - 1);
+  auto p50 = histogram.percentile(0.5);
+  REQUIRE(p50 >= 500);
+  REQUIRE(p50 <= 500 + 500 / Histogram::SUB_BUCKETS);
+  REQUIRE(histogram.percentile(1) == histogram.max());
+
+  auto json = histogram.toJson();
+  REQUIRE(json["count"].asUInt64() == 1001);
+  REQUIRE(json["buckets"].isArray());
+  REQUIRE(json["buckets"][json["buckets"].size() - 1][1].asUInt64() == 1);
+}
+
+TEST_CASE("Work is attributed to the current module", "[metrics]") {
+  Metrics metrics;
+  auto cpu = metrics.add("cpu", "DP-1");
+  auto clock = metrics.add("clock", "DP-1");
+
+  {
+    Metrics::Scope scope(cpu);
+    Metrics::processSpawned();
+    {
+      Metrics::Scope nested(clock);
+      Metrics::processSpawned();
+    }
+    Metrics::processSpawned();
+  }
+  Metrics::processSpawned();
+  REQUIRE(Metrics::current() == nullptr);
+  REQUIRE(cpu->processes == 2);
+  REQUIRE(clock->processes == 1);
+
+  cpu->recordUpdate(std::chrono::microseconds(250));
+  cpu->recordLatency(std::chrono::milliseconds(16));
+  metrics.recordLoopIteration(std::chrono::milliseconds(1));
+  metrics.recordLoopIteration(std::chrono::milliseconds(200));
+
+  auto snapshot = metrics.snapshot();
+  REQUIRE(snapshot["main_loop"]["stalls"].asUInt64() == 1);
+  REQUIRE(snapshot["main_loop"]["stall_us"].asUInt64() == 200000);
+  REQUIRE(snapshot["modules"].size() == 2);
+  auto module = snapshot["modules"][0];
+  REQUIRE(module["name"].asString() == "cpu");
+  REQUIRE(module["output"].asString() == "DP-1");
+  REQUIRE(module["updates"].asUInt64() == 1);
+  REQUIRE(module["processes_spawned"].asUInt64() == 2);
+  REQUIRE(module["update_us"]["max"].asUInt64() == 250);
+  REQUIRE(module["latency_us"]["max"].asUInt64() == 16000);
+
+  clock.reset();
+  REQUIRE(metrics.snapshot()["modules"].size() == 1);
+}
@@ -0,0 +1,43 @@
+#include "util/profiler.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+using wabar::util::Profiler;
+
+TEST_CASE("Spans are only recorded while profiling", "[profiler]") {
+  Profiler profiler;
+  { Profiler::Span span("ignored", "", profiler); }
+  REQUIRE(profiler.trace()["traceEvents"].empty());
+
+  profiler.start("/dev/null");
+  { Profiler::Span span("Factory::makeModule", "clock", profiler); }
+  { Profiler::Span span("Client::setupCss", "", profiler); }
+
+  auto events = profiler.trace()["traceEvents"];
+  REQUIRE(events.size() == 2);
+  REQUIRE(events[0]["name"].asString() == "Factory::makeModule");
+  REQUIRE(events[0]["ph"].asString() == "X");
+  REQUIRE(events[0]["args"]["detail"].asString() == "clock");
+  REQUIRE(events[0]["dur"].asInt64() >= 0);
+  REQUIRE(events[1]["ts"].asInt64() >= events[0]["ts"].asInt64());
+  REQUIRE_FALSE(events[1].isMember("args"));
+
+  profiler.finish();
+  REQUIRE_FALSE(profiler.enabled());
+  { Profiler::Span span("after", "", profiler); }
+  REQUIRE(profiler.trace()["traceEvents"].size() == 2);
+}
+
+TEST_CASE("Spans open when profiling stops are dropped", "[profiler]") {
+  Profiler profiler;
+  profiler.start("/dev/null");
+  {
+    Profiler::Span span("open", "", profiler);
+    profiler.finish();
+  }
+  REQUIRE(profiler.trace()["traceEvents"].empty());
+}
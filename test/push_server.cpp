@@ -0,0 +1,54 @@
+#include "util/push_server.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+#include <string>
+#include <vector>
+
+using wabar::util::PushServer;
+
+TEST_CASE("Pushes reach the subscribers of their module", "[push]") {
+  PushServer server;
+  std::vector<std::string> vpn;
+  std::vector<std::string> mail;
+  auto vpn_sub = server.subscribe(
+      "custom/vpn", [&vpn](const auto &payload) { vpn.push_back(payload["text"].asString()); });
+  auto mail_sub = server.subscribe(
+      "custom/mail", [&mail](const auto &payload) { mail.push_back(payload["text"].asString()); });
+
+  SECTION("Only the named module is updated") {
+    server.dispatch(R"({"module": "custom/vpn", "text": "on"})");
+    server.dispatch(R"({"module": "custom/other", "text": "ignored"})");
+    REQUIRE(vpn == std::vector<std::string>{"on"});
+    REQUIRE(mail.empty());
+  }
+
+  SECTION("Invalid lines are ignored") {
+    server.dispatch("not json");
+    server.dispatch(R"(["custom/vpn"])");
+    server.dispatch(R"({"text": "no module"})");
+    server.dispatch("  ");
+    server.dispatch(R"({"module": "custom/vpn", "text": "after"})");
+    REQUIRE(vpn == std::vector<std::string>{"after"});
+  }
+
+  SECTION("Modules with the same name all get the push") {
+    std::vector<std::string> other_bar;
+    auto sub = server.subscribe("custom/mail", [&other_bar](const auto &payload) {
+      other_bar.push_back(payload["text"].asString());
+    });
+    server.dispatch(R"({"module": "custom/mail", "text": "3"})");
+    REQUIRE(mail == std::vector<std::string>{"3"});
+    REQUIRE(other_bar == std::vector<std::string>{"3"});
+  }
+
+  SECTION("A dropped subscription is not called") {
+    vpn_sub.reset();
+    server.dispatch(R"({"module": "custom/vpn", "text": "on"})");
+    REQUIRE(vpn.empty());
+  }
+}
@@ -0,0 +1,140 @@
+#include "util/reactor.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+#include <atomic>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+using wabar::util::Reactor;
+using wabar::util::ReactorHandle;
+
+namespace {
+
+struct Pipe {
+  Pipe() { REQUIRE(pipe2(fds, O_CLOEXEC) == 0); }
+  ~Pipe() {
+    closeWrite();
+    ::close(fds[0]);
+  }
+  void write(const std::string &data) const {
+    REQUIRE(::write(fds[1], data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+  }
+  void closeWrite() {
+    if (fds[1] != -1) {
+      ::close(fds[1]);
+      fds[1] = -1;
+    }
+  }
+  int fds[2];
+};
+
+// Lines read until the end of the stream
+std::future<std::vector<std::string>> collect(ReactorHandle &handle, int fd) {
+  auto promise = std::make_shared<std::promise<std::vector<std::string>>>();
+  auto lines = std::make_shared<std::vector<std::string>>();
+  handle.readLines(
+      fd, [lines](std::string_view line) { lines->emplace_back(line); },
+      [promise, lines] { promise->set_value(*lines); });
+  return promise->get_future();
+}
+
+}  // namespace
+
+TEST_CASE("Reactor splits lines", "[reactor]") {
+  Pipe pipe;
+  ReactorHandle handle;
+  auto lines = collect(handle, pipe.fds[0]);
+
+  SECTION("Lines written in pieces are joined") {
+    pipe.write("first\nsec");
+    pipe.write("ond\n\nthird\n");
+    pipe.write("unterminated");
+    pipe.closeWrite();
+    REQUIRE(lines.get() ==
+            std::vector<std::string>{"first", "second", "", "third", "unterminated"});
+  }
+
+  SECTION("Long lines are split") {
+    pipe.write(std::string(Reactor::MAX_LINE + 10, 'x') + "\n");
+    pipe.closeWrite();
+    auto result = lines.get();
+    REQUIRE(result.size() == 2);
+    REQUIRE(result[0].size() == Reactor::MAX_LINE);
+    REQUIRE(result[1] == std::string(10, 'x'));
+  }
+}
+
+TEST_CASE("A command writing nonstop doesn't starve the timers", "[reactor]") {
+  Pipe pipe;
+  ReactorHandle reader;
+  std::atomic<size_t> lines = 0;
+  reader.readLines(pipe.fds[0], [&](std::string_view) { ++lines; }, [] {});
+  std::atomic<bool> stop = false;
+  // Non-blocking, so the writer sees `stop` once nothing reads anymore
+  fcntl(pipe.fds[1], F_SETFL, O_NONBLOCK);
+  std::thread writer([&] {
+    std::string chunk;
+    for (int i = 0; i < 1024; ++i) {
+      chunk += "y\n";
+    }
+    while (!stop) {
+      ::write(pipe.fds[1], chunk.data(), chunk.size());
+    }
+  });
+
+  ReactorHandle timer;
+  std::promise<void> fired;
+  timer.after(std::chrono::milliseconds(10), [&] { fired.set_value(); });
+  auto status = fired.get_future().wait_for(std::chrono::seconds(1));
+  stop = true;
+  reader.stop();
+  pipe.closeWrite();
+  writer.join();
+  REQUIRE(status == std::future_status::ready);
+  REQUIRE(lines > 0);
+}
+
+TEST_CASE("Reactor timers", "[reactor]") {
+  ReactorHandle handle;
+
+  SECTION("Run once after the delay") {
+    std::promise<Reactor::clock::time_point> fired;
+    auto begin = Reactor::clock::now();
+    handle.after(std::chrono::milliseconds(20), [&] { fired.set_value(Reactor::clock::now()); });
+    REQUIRE(fired.get_future().get() - begin >= std::chrono::milliseconds(20));
+  }
+
+  SECTION("A callback can start the next source") {
+    std::promise<void> done;
+    int runs = 0;
+    std::function<void()> again = [&] {
+      if (++runs < 3) {
+        handle.after(std::chrono::milliseconds(1), again);
+      } else {
+        done.set_value();
+      }
+    };
+    handle.after(std::chrono::milliseconds(1), again);
+    done.get_future().get();
+    REQUIRE(runs == 3);
+  }
+
+  SECTION("Stopped handles don't run anything") {
+    std::atomic<bool> fired = false;
+    handle.after(std::chrono::milliseconds(10), [&] { fired = true; });
+    handle.stop();
+    handle.after(std::chrono::milliseconds(1), [&] { fired = true; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    REQUIRE_FALSE(fired);
+  }
+}
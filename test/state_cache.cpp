@@ -0,0 +1,70 @@
+#include "util/state_cache.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+#include <filesystem>
+#include <fstream>
+
+using wabar::util::ModuleState;
+using wabar::util::StateCache;
+
+TEST_CASE("Module states survive a restart", "[state_cache]") {
+  auto dir = std::filesystem::temp_directory_path() / "wabar-state-cache-test";
+  std::filesystem::remove_all(dir);
+  auto path = (dir / "wabar" / "state.json").string();
+  ModuleState clock{"<b>12:00</b>", {"module", "clock"}};
+  ModuleState battery{"42%", {"module", "warning"}};
+
+  SECTION("Saved states are loaded again") {
+    {
+      StateCache cache(path);
+      cache.set("DP-1", "clock", clock);
+      cache.set("DP-1", "battery", battery);
+      cache.set("HDMI-A-1", "clock", ModuleState{"12:01", {}});
+      cache.save();
+    }
+    StateCache cache(path);
+    REQUIRE(cache.get("DP-1", "clock") == clock);
+    REQUIRE(cache.get("DP-1", "battery") == battery);
+    REQUIRE(cache.get("HDMI-A-1", "clock")->markup == "12:01");
+    REQUIRE_FALSE(cache.get("DP-2", "clock").has_value());
+  }
+
+  SECTION("Modules showing nothing are forgotten") {
+    {
+      StateCache cache(path);
+      cache.set("DP-1", "clock", clock);
+      cache.save();
+      cache.set("DP-1", "clock", std::nullopt);
+      cache.set("DP-2", "clock", std::nullopt);
+      cache.save();
+    }
+    REQUIRE_FALSE(StateCache(path).get("DP-1", "clock").has_value());
+  }
+
+  SECTION("The file is only written on change") {
+    StateCache cache(path);
+    cache.set("DP-1", "clock", clock);
+    cache.save();
+    std::filesystem::remove(path);
+    cache.set("DP-1", "clock", clock);
+    cache.save();
+    REQUIRE_FALSE(std::filesystem::exists(path));
+  }
+
+  SECTION("A corrupted file is ignored") {
+    std::filesystem::create_directories(dir / "wabar");
+    std::ofstream(path) << "{\"DP-1\": ";
+    StateCache cache(path);
+    REQUIRE_FALSE(cache.get("DP-1", "clock").has_value());
+    cache.set("DP-1", "clock", clock);
+    cache.save();
+    REQUIRE(StateCache(path).get("DP-1", "clock") == clock);
+  }
+
+  std::filesystem::remove_all(dir);
+}
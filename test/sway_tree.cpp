@@ -0,0 +1,114 @@
+#include "modules/sway/tree.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+#include <stdexcept>
+#include <string>
+
+using wabar::modules::sway::Node;
+using wabar::modules::sway::Tree;
+
+namespace {
+
+const std::string TREE = R"({
+  "id": 1, "type": "root", "name": "root", "rect": {"x": 0, "y": 0, "width": 3840, "height": 1080},
+  "nodes": [
+    {"id": 2, "type": "output", "name": "DP-1", "current_workspace": "2", "percent": 0.5,
+     "marks": [], "nodes": [
+      {"id": 3, "type": "workspace", "name": "1", "num": 1, "output": "DP-1", "focused": false,
+       "layout": "splith", "nodes": [], "floating_nodes": []},
+      {"id": 4, "type": "workspace", "name": "2", "num": 2, "output": "DP-1", "layout": "tabbed",
+       "nodes": [
+        {"id": 5, "type": "con", "name": null, "layout": "splitv", "nodes": [
+          {"id": 6, "type": "con", "name": "vim \"a\x2fb\"", "app_id": "foot",
+           "shell": "xdg_shell", "focused": true, "window_properties": null, "nodes": []}]}],
+       "floating_nodes": [
+        {"id": 7, "type": "floating_con", "name": "été 😀", "app_id": null,
+         "shell": "xwayland", "urgent": true,
+         "window_properties": {"class": "Gimp", "instance": "gimp", "transient_for": null},
+         "rect": {"x": 10, "y": -20, "width": 640, "height": 480}, "nodes": []}]}],
+     "floating_nodes": []}]
+})";
+
+}  // namespace
+
+TEST_CASE("Decode the fields of a tree", "[sway_tree]") {
+  Tree tree(TREE);
+  REQUIRE(tree.size() == 7);
+
+  const auto &root = tree.root();
+  REQUIRE(root.type == "root");
+  REQUIRE(root.rect.width == 3840);
+  REQUIRE(tree.nodes(root).size() == 1);
+  REQUIRE(tree.floatingNodes(root).empty());
+
+  const auto &output = tree.nodes(root)[0];
+  REQUIRE(output.name == "DP-1");
+  REQUIRE(output.current_workspace == "2");
+  REQUIRE(output.num == -1);
+
+  auto workspaces = tree.nodes(output);
+  REQUIRE(workspaces.size() == 2);
+  REQUIRE(workspaces[0].id == 3);
+  REQUIRE(workspaces[0].num == 1);
+  REQUIRE(tree.allNodes(workspaces[0]).empty());
+
+  const auto &workspace = workspaces[1];
+  REQUIRE(workspace.output == "DP-1");
+  REQUIRE(workspace.layout == "tabbed");
+  REQUIRE(tree.nodes(workspace).size() == 1);
+  REQUIRE(tree.allNodes(workspace).size() == 2);
+
+  const auto &split = tree.nodes(workspace)[0];
+  REQUIRE(split.name.data() == nullptr);
+  const auto &window = tree.nodes(split)[0];
+  REQUIRE(window.name == "vim \"a/b\"");
+  REQUIRE(window.app_id == "foot");
+  REQUIRE(window.focused);
+  REQUIRE(window.window_class.data() == nullptr);
+
+  const auto &floating = tree.floatingNodes(workspace)[0];
+  REQUIRE(floating.type == "floating_con");
+  REQUIRE(floating.name == "\xc3\xa9t\xc3\xa9 \xf0\x9f\x98\x80");
+  REQUIRE(floating.app_id.data() == nullptr);
+  REQUIRE(floating.window_class == "Gimp");
+  REQUIRE(floating.window_instance == "gimp");
+  REQUIRE(floating.rect.y == -20);
+  REQUIRE(floating.rect.height == 480);
+}
+
+TEST_CASE("Flags are looked up below a container", "[sway_tree]") {
+  Tree tree(TREE);
+  auto workspaces = tree.nodes(tree.nodes(tree.root())[0]);
+  REQUIRE_FALSE(tree.hasFlag(workspaces[0], &Node::focused));
+  REQUIRE(tree.hasFlag(workspaces[1], &Node::focused));
+  REQUIRE(tree.hasFlag(workspaces[1], &Node::urgent));
+  REQUIRE_FALSE(tree.hasFlag(workspaces[1], &Node::visible));
+}
+
+TEST_CASE("Modules given the same reply share its tree", "[sway_tree]") {
+  auto tree = Tree::decode(TREE);
+  REQUIRE(Tree::decode(std::string(TREE)) == tree);
+  auto changed = Tree::decode(R"({"type": "root", "nodes": []})");
+  REQUIRE(changed != tree);
+  REQUIRE(changed->size() == 1);
+}
+
+TEST_CASE("Invalid trees are rejected", "[sway_tree]") {
+  REQUIRE_THROWS_AS(Tree(R"({"nodes": [)"), std::runtime_error);
+  REQUIRE_THROWS_AS(Tree(R"({"name": "\ud83d"})"), std::runtime_error);
+  REQUIRE_THROWS_AS(Tree(R"({"name": "a"} {})"), std::runtime_error);
+  // Truncated in a skipped string, right after a backslash
+  REQUIRE_THROWS_AS(Tree(R"({"foo": "a\)"), std::runtime_error);
+  REQUIRE_THROWS_AS(Tree(R"({"foo": "a\")"), std::runtime_error);
+
+  std::string nested;
+  for (int i = 0; i <= Tree::MAX_DEPTH; ++i) {
+    nested += R"({"nodes": [)";
+  }
+  REQUIRE_THROWS_AS(Tree(nested), std::runtime_error);
+}
@@ -0,0 +1,68 @@
+#include "util/timer_wheel.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+using wabar::util::TimerWheel;
+
+TEST_CASE("Timer wheel expiry", "[util][timer]") {
+  TimerWheel wheel;
+  std::vector<TimerWheel::id_t> expired;
+
+  SECTION("Timers expire at their tick") {
+    wheel.insert(1, 5);
+    wheel.insert(2, 100);
+    wheel.insert(3, 5000);
+    REQUIRE(wheel.nextExpiry() == 5);
+
+    wheel.advance(4, expired);
+    REQUIRE(expired.empty());
+    wheel.advance(5, expired);
+    REQUIRE(expired == std::vector<TimerWheel::id_t>{1});
+
+    expired.clear();
+    REQUIRE(wheel.nextExpiry() == 100);
+    wheel.advance(4999, expired);
+    REQUIRE(expired == std::vector<TimerWheel::id_t>{2});
+
+    expired.clear();
+    REQUIRE(wheel.nextExpiry() == 5000);
+    wheel.advance(6000, expired);
+    REQUIRE(expired == std::vector<TimerWheel::id_t>{3});
+    REQUIRE(wheel.empty());
+    REQUIRE_FALSE(wheel.nextExpiry().has_value());
+  }
+
+  SECTION("Timers in the past expire immediately") {
+    wheel.advance(10, expired);
+    wheel.insert(1, 3);
+    REQUIRE(wheel.nextExpiry() == 10);
+    wheel.advance(10, expired);
+    REQUIRE(expired == std::vector<TimerWheel::id_t>{1});
+  }
+
+  SECTION("Removed and re-armed timers") {
+    wheel.insert(1, 70);
+    wheel.insert(2, 70);
+    REQUIRE(wheel.remove(1));
+    REQUIRE_FALSE(wheel.remove(1));
+    wheel.insert(2, 300);
+    wheel.advance(299, expired);
+    REQUIRE(expired.empty());
+    wheel.advance(300, expired);
+    REQUIRE(expired == std::vector<TimerWheel::id_t>{2});
+  }
+
+  SECTION("Timers beyond the wheel horizon") {
+    const TimerWheel::tick_t far = TimerWheel::tick_t{1} << 30;
+    wheel.insert(1, far);
+    REQUIRE(wheel.nextExpiry() == far);
+    wheel.advance(far - 1, expired);
+    REQUIRE(expired.empty());
+    wheel.advance(far, expired);
+    REQUIRE(expired == std::vector<TimerWheel::id_t>{1});
+  }
+}